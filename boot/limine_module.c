@@ -10,6 +10,7 @@
  */
 
 #include "limine_module.h"
+#include "initcall.h"
 #include "limine.h"
 #include "printk.h"
 #include "rinx.h"
@@ -54,3 +55,4 @@ void lmodule_init(void)
         lmodule_count++;
     }
 }
+INITCALL(lmodule_init, INITCALL_SUBSYS, 0);
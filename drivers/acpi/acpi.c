@@ -21,8 +21,8 @@
 xsdt_t *xsdt = 0;
 rsdt_t *rsdt = 0;
 
-/* Find the corresponding ACPI table in XSDT */
-void *find_table(const char *name)
+/* Find the `index`-th ACPI table with a signature in XSDT, 0 if there are not that many */
+void *find_table_index(const char *name, uint32_t index)
 {
     int use_xsdt = xsdt != 0;
     if (!use_xsdt && !rsdt) {
@@ -44,15 +44,22 @@ void *find_table(const char *name)
     for (uint32_t i = 0; i < entry_count; i++) {
         uint64_t           phys_addr = (entry_size == 8) ? ((const uint64_t *)entry_base)[i] : ((const uint32_t *)entry_base)[i];
         acpi_sdt_header_t *header    = (acpi_sdt_header_t *)phys_to_virt(phys_addr);
-        if (*(const uint32_t *)header->signature == target_sig) {
-            plogk("acpi: %.4s found at %p\n", name, header);
-            return header;
-        }
+        if (*(const uint32_t *)header->signature == target_sig && !index--) return header;
     }
-    plogk("acpi: Table %.4s not found in %s\n", name, use_xsdt ? "XSDT" : "RSDT");
     return 0;
 }
 
+/* Find the corresponding ACPI table in XSDT */
+void *find_table(const char *name)
+{
+    void *header = find_table_index(name, 0);
+    if (header)
+        plogk("acpi: %.4s found at %p\n", name, header);
+    else if (xsdt || rsdt)
+        plogk("acpi: Table %.4s not found in %s\n", name, xsdt ? "XSDT" : "RSDT");
+    return header;
+}
+
 /* Initialize ACPI */
 void acpi_init(void)
 {
@@ -0,0 +1,165 @@
+/*
+ *
+ *      cst.c
+ *      Processor power states from _CST
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "acpi.h"
+#include "hhdm.h"
+#include "printk.h"
+#include "stdint.h"
+#include "string.h"
+
+#define AML_NAME_OP    0x08
+#define AML_PACKAGE_OP 0x12
+#define AML_BUFFER_OP  0x11
+
+#define CST_REGISTER_DESC  0x82 // Generic Register resource descriptor
+#define CST_FFIXEDHW       0x7f // Functional fixed hardware address space
+#define CST_FFH_INTEL      1    // Vendor code in bit_width
+#define CST_FFH_MWAIT      2    // Native C-state instruction class in bit_offset
+#define CST_REGISTER_BYTES 15   // Descriptor tag, length and body
+
+/* Decode the PkgLength at *p and step over it, returns the end of the object it measures, 0 if that runs past `end` */
+static const uint8_t *cst_pkg_end(const uint8_t **p, const uint8_t *end)
+{
+    const uint8_t *start = *p;
+    if (start >= end) return 0;
+
+    uint32_t follow = start[0] >> 6;
+    uint32_t length = follow ? start[0] & 0x0f : start[0] & 0x3f;
+    if (start + 1 + follow > end) return 0;
+    for (uint32_t i = 0; i < follow; i++) length |= (uint32_t)start[1 + i] << (4 + 8 * i);
+
+    *p = start + 1 + follow;
+    return length > (uint32_t)(end - start) ? 0 : start + length;
+}
+
+/* Decode a constant integer at *p and step over it, returns 1 if there is none */
+static int cst_integer(const uint8_t **p, const uint8_t *end, uint64_t *value)
+{
+    const uint8_t *q    = *p;
+    uint32_t       size = 0;
+    if (q >= end) return 1;
+
+    switch (*q++) {
+        case 0x00 : // ZeroOp
+            *value = 0;
+            break;
+        case 0x01 : // OneOp
+            *value = 1;
+            break;
+        case 0xff : // OnesOp
+            *value = ~(uint64_t)0;
+            break;
+        case 0x0a : // BytePrefix
+            size = 1;
+            break;
+        case 0x0b : // WordPrefix
+            size = 2;
+            break;
+        case 0x0c : // DWordPrefix
+            size = 4;
+            break;
+        case 0x0e : // QWordPrefix
+            size = 8;
+            break;
+        default :
+            return 1;
+    }
+    if (size) {
+        if (q + size > end) return 1;
+        *value = 0;
+        for (uint32_t i = 0; i < size; i++) *value |= (uint64_t)q[i] << (8 * i);
+        q += size;
+    }
+    *p = q;
+    return 0;
+}
+
+/* Parse one Package {Register, Type, Latency, Power} body, returns 1 unless it is an MWAIT entry */
+static int cst_entry(const uint8_t *q, const uint8_t *end, acpi_cstate_t *state)
+{
+    uint64_t size, type, latency, power;
+    if (q >= end || *q++ < 4 || q >= end || *q++ != AML_BUFFER_OP) return 1;
+
+    const uint8_t *buffer_end = cst_pkg_end(&q, end);
+    if (!buffer_end || cst_integer(&q, buffer_end, &size) || q + CST_REGISTER_BYTES > buffer_end) return 1;
+    const uint8_t *reg = q;
+
+    q = buffer_end;
+    if (cst_integer(&q, end, &type) || cst_integer(&q, end, &latency) || cst_integer(&q, end, &power)) return 1;
+
+    /* Only the MWAIT form is usable here, the I/O port form needs the chipset's P_LVLx registers */
+    if (reg[0] != CST_REGISTER_DESC || reg[1] != 0x0c || reg[2] || reg[3] != CST_FFIXEDHW) return 1;
+    if (reg[4] != CST_FFH_INTEL || reg[5] != CST_FFH_MWAIT) return 1;
+
+    uint64_t address;
+    memcpy(&address, &reg[7], sizeof(address));
+    state->type    = (uint32_t)type;
+    state->latency = (uint32_t)latency;
+    state->power   = (uint32_t)power;
+    state->hint    = (uint32_t)address;
+    return 0;
+}
+
+/* Parse a Name(_CST, Package) starting at its PackageOp, returns how many states were stored */
+static uint32_t cst_parse(const uint8_t *p, const uint8_t *end, acpi_cstate_t *states, uint32_t max)
+{
+    uint64_t count;
+    uint32_t stored = 0;
+
+    p++;
+    const uint8_t *package_end = cst_pkg_end(&p, end);
+    if (!package_end || p >= package_end) return 0;
+    p++; // NumElements, the Count integer that follows is what firmware keeps in sync
+    if (cst_integer(&p, package_end, &count)) return 0;
+
+    for (uint64_t i = 0; i < count && stored < max && p < package_end; i++) {
+        if (*p++ != AML_PACKAGE_OP) break;
+        const uint8_t *entry_end = cst_pkg_end(&p, package_end);
+        if (!entry_end) break;
+        if (!cst_entry(p, entry_end, &states[stored])) stored++;
+        p = entry_end;
+    }
+    return stored;
+}
+
+/* Search a definition block for a static _CST, returns how many states were stored */
+static uint32_t cst_scan(dsdt_table_t *table, acpi_cstate_t *states, uint32_t max)
+{
+    static const uint8_t pattern[] = {AML_NAME_OP, '_', 'C', 'S', 'T', AML_PACKAGE_OP};
+
+    if (!table || table->length <= sizeof(acpi_sdt_header_t)) return 0;
+    const uint8_t *p   = &table->definition_block;
+    const uint8_t *end = (const uint8_t *)table + table->length;
+
+    for (; p + sizeof(pattern) < end; p++) {
+        if (memcmp(p, pattern, sizeof(pattern))) continue;
+        uint32_t stored = cst_parse(p + sizeof(pattern) - 1, end, states, max);
+        if (stored) return stored;
+    }
+    return 0;
+}
+
+/* Read the MWAIT C-states of the first static _CST in the DSDT or an SSDT, returns how many were stored */
+uint32_t acpi_cst_read(acpi_cstate_t *states, uint32_t max)
+{
+    acpi_facp_t *fadt   = (acpi_facp_t *)find_table_index("FACP", 0);
+    uint32_t     stored = 0;
+
+    /* Most firmware defines _CST as a Method, which would take an AML interpreter to evaluate */
+    if (fadt && fadt->dsdt) stored = cst_scan((dsdt_table_t *)phys_to_virt(fadt->dsdt), states, max);
+    for (uint32_t i = 0; !stored; i++) {
+        dsdt_table_t *ssdt = (dsdt_table_t *)find_table_index("SSDT", i);
+        if (!ssdt) break;
+        stored = cst_scan(ssdt, states, max);
+    }
+    if (stored) plogk("acpi: _CST lists %u MWAIT C-states.\n", stored);
+    return stored;
+}
@@ -13,12 +13,16 @@
 #include "apic.h"
 #include "common.h"
 #include "fs/sb_devices.h"
-#include "interrupt.h"
+#include "initcall.h"
+#include "irq.h"
 #include "pci.h"
 #include "printk.h"
 #include "stddef.h"
 #include "stdint.h"
 #include "timer.h"
+#include "wait.h"
+
+#define IDE_POLL_SPINS 1000 // Short status polls before the poller starts sleeping
 
 /* Request for operation IDE Controller */
 pci_finding_request_t ide_pci_request = {
@@ -41,25 +45,22 @@ static uint8_t atapi_packet[12] = {
 };
 int package[2];
 
-/* Interrupt status bit */
-static volatile uint8_t ide_irq_invoked = 0;
+/* Signalled by the IDE interrupt */
+static completion_t ide_irq_done;
 
-/* IDE interrupt handling function */
-INTERRUPT_BEGIN static void ide_irq(interrupt_frame_t *frame)
+/* IDE interrupt handling function of both channels */
+static int ide_irq(uint8_t vector, void *data)
 {
-    (void)frame;
-    disable_intr();
-    ide_irq_invoked = 1;
-    send_eoi();
-    enable_intr();
+    (void)data;
+    ioapic_account(vector - IRQ_0);
+    complete(&ide_irq_done);
+    return IRQ_HANDLED;
 }
-INTERRUPT_END
 
 /* Waiting for IDE interrupt to be triggered */
 static void ide_wait_irq(void)
 {
-    while (!ide_irq_invoked);
-    ide_irq_invoked = 0;
+    wait_for_completion(&ide_irq_done);
 }
 
 /* Setting up the IDE */
@@ -231,8 +232,9 @@ void init_ide(void)
          */
     }
     bar_reg.parent = ide_pci_request.response->device;
-    register_interrupt_handler(IRQ_14, (void *)ide_irq, 0, 0x8e);
-    register_interrupt_handler(IRQ_15, (void *)ide_irq, 0, 0x8e);
+    init_completion(&ide_irq_done);
+    irq_request(IRQ_14, ide_irq, 0, "ide0");
+    irq_request(IRQ_15, ide_irq, 0, "ide1");
 
     for (uint32_t idx = 0; idx < 6; idx++) {
         bars[idx] = get_base_address_register(bar_reg.parent, idx);
@@ -243,6 +245,7 @@ void init_ide(void)
     ide_initialize(bar_addrs[0], bar_addrs[1], bar_addrs[2], bar_addrs[3], bar_addrs[4]);
     ide_superblock_init();
 }
+INITCALL(init_ide, INITCALL_DEVICE, INITCALL_ASYNC, "pci_init");
 
 /* Read a byte of data from the specified register of the IDE device */
 uint8_t ide_read(uint8_t channel, uint8_t reg)
@@ -302,10 +305,14 @@ uint8_t ide_polling(uint8_t channel, uint32_t advanced_check) // NOLINT(bugprone
 {
     for (int i = 0; i < 4; i++) ide_read(channel, ATA_REG_ALTSTATUS);
 
-    int a = ide_read(channel, ATA_REG_STATUS);
+    int      a     = ide_read(channel, ATA_REG_STATUS);
+    uint32_t spins = 0;
     while (a & ATA_SR_BSY) {
         a = ide_read(channel, ATA_REG_STATUS);
-        nsleep(10);
+        if (spins++ < IDE_POLL_SPINS)
+            nsleep(10);
+        else
+            msleep(1); // The device is slow, let other threads run
     }
     if (advanced_check) {
         uint8_t state = ide_read(channel, ATA_REG_STATUS);
@@ -331,7 +338,8 @@ uint8_t ide_ata_access(uint8_t direction, uint8_t drive, uint32_t lba, uint8_t n
     uint16_t cyl, i;
     uint8_t  head, sect, err;
 
-    ide_write(channel, ATA_REG_CONTROL, channels[channel].nIEN = (ide_irq_invoked = 0x0) + 0x02);
+    reinit_completion(&ide_irq_done);
+    ide_write(channel, ATA_REG_CONTROL, channels[channel].nIEN = 0x02);
     if (lba >= 0x10000000) {
         lba_mode  = 2;
         lba_io[0] = (lba & 0x000000ff) >> 0;
@@ -428,7 +436,8 @@ uint8_t ide_atapi_read(uint8_t drive, uint32_t lba, uint8_t numsects, uint16_t *
     uint8_t  err;
     int      i;
 
-    ide_write(channel, ATA_REG_CONTROL, channels[channel].nIEN = ide_irq_invoked = 0x0);
+    reinit_completion(&ide_irq_done);
+    ide_write(channel, ATA_REG_CONTROL, channels[channel].nIEN = 0x0);
 
     /* Setting up SCSI packets */
     atapi_packet[0]  = ATAPI_CMD_READ;
@@ -15,10 +15,16 @@
 #include "common.h"
 #include "debug.h"
 #include "hhdm.h"
+#include "initcall.h"
+#include "parallel_for.h"
 #include "printk.h"
+#include "rcu.h"
+#include "sched.h"
+#include "spin_lock.h"
 #include "stddef.h"
 #include "stdint.h"
 #include "stdlib.h"
+#include "string.h"
 
 mcfg_info_t mcfg_info;
 
@@ -27,6 +33,17 @@ pci_devices_cache_t pci_cache = {
     .devices_count = 0,
 };
 
+static DEFINE_SPIN_LOCK_CLASS(pci_cache_lock_class, "pci_cache");
+
+static spinlock_t          pci_cache_lock = SPINLOCK_INIT(&pci_cache_lock_class); // Serializes writers, lookups walk the list under RCU
+static volatile int        pci_flush_busy;                                        // One bus scan at a time
+static pci_devices_cache_t pci_scan_buses[256];                                   // Per-bus lists of a parallel MCFG scan
+
+typedef struct {
+        rcu_head_t          rcu;
+        pci_device_cache_t *list; // Swapped out of the cache, lookups may still be walking it
+} pci_cache_retired_t;
+
 static uint32_t pci_legacy_read(pci_device_reg_t reg);
 static void     pci_legacy_write(pci_device_reg_t reg, uint32_t value);
 
@@ -430,6 +447,25 @@ uint32_t pci_get_irq(pci_device_cache_t *device)
     return read_pci(reg);
 }
 
+/* Returns the config offset of a capability, 0 if the device does not have it */
+uint32_t pci_find_capability(pci_device_cache_t *device, uint8_t id)
+{
+    pci_device_reg_t reg = {device, PCI_CONF_COMMAND};
+    if (!((read_pci(reg) >> 16) & PCI_STATUS_CAP_LIST)) return 0;
+
+    reg.offset      = (device->header_type & 0x7f) == HEADER_TYPE_CARDBUS ? PCI_CONF_CARDBUS_CAP : PCI_CONF_CAP_PTR;
+    uint32_t offset = read_pci(reg) & 0xfc;
+
+    /* 48 entries fill the 192 bytes after the header, anything longer is a loop */
+    for (uint32_t i = 0; i < 48 && offset >= 0x40; i++) {
+        reg.offset     = offset;
+        uint32_t value = read_pci(reg);
+        if ((value & 0xff) == id) return offset;
+        offset = (value >> 8) & 0xfc;
+    }
+    return 0;
+}
+
 /* Configuring PCI Devices */
 void pci_config(pci_device_cache_t *cache, uint32_t addr)
 {
@@ -442,19 +478,21 @@ void pci_config(pci_device_cache_t *cache, uint32_t addr)
 /* Find devices by class code */
 static pci_finding_response_iter_t pci_class_finding(pci_device_cache_t *start, pci_finding_request_t *req)
 {
-    pci_class_request_t         class_req  = req->req.class_req;
-    pci_device_cache_t         *cache      = pci_found_class_cache(start, class_req);
-    pci_device_reg_t            reg_vendor = {cache, PCI_CONF_VENDOR};
-    pci_finding_response_iter_t response   = {0};
+    pci_class_request_t         class_req = req->req.class_req;
+    pci_finding_response_iter_t response  = {0};
 
     response.device = 0;
     response.error  = PCI_FINDING_NOT_FOUND;
 
-    /* Test existence of device */
+    /* Test existence of device, a flush frees the node only after the read-side section */
+    rcu_read_lock();
+    pci_device_cache_t *cache      = pci_found_class_cache(start, class_req);
+    pci_device_reg_t    reg_vendor = {cache, PCI_CONF_VENDOR};
     if (cache && read_pci(reg_vendor) != 0xffffffff) {
         response.device = cache;
         response.error  = PCI_FINDING_SUCCESS;
     }
+    rcu_read_unlock();
     return response;
 }
 
@@ -462,18 +500,20 @@ static pci_finding_response_iter_t pci_class_finding(pci_device_cache_t *start,
 static pci_finding_response_iter_t pci_device_finding(pci_device_cache_t *start, pci_finding_request_t *req)
 {
     pci_device_request_t        device_req = req->req.device_req;
-    pci_device_cache_t         *cache      = pci_found_device_cache(start, device_req);
-    pci_device_reg_t            reg_vendor = {cache, PCI_CONF_VENDOR};
     pci_finding_response_iter_t response   = {0};
 
     response.device = 0;
     response.error  = PCI_FINDING_NOT_FOUND;
 
-    /* Test existence of device */
+    /* Test existence of device, a flush frees the node only after the read-side section */
+    rcu_read_lock();
+    pci_device_cache_t *cache      = pci_found_device_cache(start, device_req);
+    pci_device_reg_t    reg_vendor = {cache, PCI_CONF_VENDOR};
     if (cache && read_pci(reg_vendor) != 0xffffffff) {
         response.device = cache;
         response.error  = PCI_FINDING_SUCCESS;
     }
+    rcu_read_unlock();
     return response;
 }
 
@@ -529,7 +569,8 @@ void pci_device_find_next(pci_finding_request_t *request, volatile pci_finding_r
     if (response->error == PCI_FINDING_SUCCESS) {
         if (!response->next) response->next = malloc(sizeof(pci_finding_response_iter_t));
         next_response = response->next;
-        /* Process the request to next responses */
+        /* Process the request to next responses, response->device is not freed before rcu_read_unlock() */
+        rcu_read_lock();
         switch (request->type) {
             case PCI_FOUND_CLASS :
                 *next_response = pci_class_finding(response->device->next, request);
@@ -543,6 +584,7 @@ void pci_device_find_next(pci_finding_request_t *request, volatile pci_finding_r
                 next_response->error  = PCI_FINDING_ERROR;
                 break;
         }
+        rcu_read_unlock();
         next_response->next = 0;
     }
     response->next = next_response;
@@ -600,10 +642,9 @@ pci_devices_cache_t *pci_get_devices_cache(void)
     return &pci_cache;
 }
 
-/* Free the PCI devices cache */
-void pci_free_devices_cache(void)
+/* Free a detached list of device caches */
+static void pci_free_cache_list(pci_device_cache_t *cache)
 {
-    pci_device_cache_t *cache = pci_cache.head;
     pci_device_cache_t *free_ptr;
     while (cache) {
         free_ptr = cache;
@@ -611,25 +652,57 @@ void pci_free_devices_cache(void)
         free(free_ptr->device);
         free(free_ptr);
     }
-    pci_cache.head          = 0;
+}
+
+/* RCU callback of pci_retire_cache_list() */
+static void pci_retired_free(rcu_head_t *head)
+{
+    pci_cache_retired_t *retired = (pci_cache_retired_t *)head;
+    pci_free_cache_list(retired->list);
+    free(retired);
+}
+
+/* Free a list swapped out of the cache once every lookup that may hold one of its nodes is over */
+static void pci_retire_cache_list(pci_device_cache_t *list)
+{
+    if (!list) return;
+    pci_cache_retired_t *retired = (pci_cache_retired_t *)malloc(sizeof(pci_cache_retired_t));
+    if (!retired) {
+        synchronize_rcu();
+        pci_free_cache_list(list);
+        return;
+    }
+    retired->list = list;
+    call_rcu(&retired->rcu, pci_retired_free);
+}
+
+/* Free the PCI devices cache */
+void pci_free_devices_cache(void)
+{
+    uint64_t            flags = spin_lock_irqsave(&pci_cache_lock);
+    pci_device_cache_t *cache = pci_cache.head;
+    rcu_assign_pointer(pci_cache.head, (pci_device_cache_t *)0);
     pci_cache.devices_count = 0;
+    spin_unlock_irqrestore(&pci_cache_lock, flags);
+
+    pci_retire_cache_list(cache);
 }
 
 /* A helper function to add device cache */
-static void pci_add_device_cache(pci_device_cache_t *cache)
+static void pci_add_device_cache(pci_devices_cache_t *scan, pci_device_cache_t *cache)
 {
     pci_device_cache_t *cpy_cache = (pci_device_cache_t *)malloc(sizeof(pci_device_cache_t));
     *cpy_cache                    = *cache;
     pci_device_t *cpy_device      = (pci_device_t *)malloc(sizeof(pci_device_t));
     *cpy_device                   = *(cache->device);
     cpy_cache->device             = cpy_device;
-    cpy_cache->next               = pci_cache.head;
-    pci_cache.head                = cpy_cache;
-    pci_cache.devices_count++;
+    cpy_cache->next               = scan->head;
+    scan->head                    = cpy_cache;
+    scan->devices_count++;
 }
 
 /* A helper function to read registers and add device cache */
-static int pci_cache_process(pci_device_cache_t *cache)
+static int pci_cache_process(pci_devices_cache_t *scan, pci_device_cache_t *cache)
 {
     union {
             pci_device_reg_t ecam_area;
@@ -657,90 +730,156 @@ static int pci_cache_process(pci_device_cache_t *cache)
     cache->class_code   = cache->value_c >> 8;
     regs.header.offset  = PCI_CONF_HEADER_TYPE;
     cache->header_type  = read_pci(regs.header) & 0xff;
-    pci_add_device_cache(cache);
+    pci_add_device_cache(scan, cache);
 
     /* Exist and added */
     return 1;
 }
 
 /* Process slots of PCI devices */
-static void slot_process(pci_device_cache_t *cache)
+static void slot_process(pci_devices_cache_t *scan, pci_device_cache_t *cache)
 {
     pci_device_t *device = cache->device;
 
     device->func = 0;
-    if (!pci_cache_process(cache)) return; // Device not exist
+    if (!pci_cache_process(scan, cache)) return; // Device not exist
 
     /* Check if device is a multifunction device */
     if (!(cache->header_type & 0x80)) return; // Not a multifunction device
 
     /* Process func=1..7 */
-    for (device->func = 1; device->func < 8; device->func++) pci_cache_process(cache);
+    for (device->func = 1; device->func < 8; device->func++) pci_cache_process(scan, cache);
 }
 
 /* Iterate over bus by a range */
-static void pci_iter_bus_range(pci_device_cache_t *cache, bus_range_t bus_range)
+static void pci_iter_bus_range(pci_devices_cache_t *scan, pci_device_cache_t *cache, bus_range_t bus_range)
 {
     if (mcfg_info.enabled && !cache->entry) return; // Enabled MCFG but no entry found
     pci_device_t *device = cache->device;
     for (device->bus = bus_range.start; device->bus < bus_range.end; device->bus++) {
-        for (device->slot = 0; device->slot < 32; device->slot++) slot_process(cache);
+        for (device->slot = 0; device->slot < 32; device->slot++) slot_process(scan, cache);
     }
 }
 
-/* Flush the PCI devices cache */
-void pci_flush_devices_cache(void)
+/* Scan the buses [start, end) of an MCFG entry, each bus into its own list so that chunks on other CPUs never share one */
+static void pci_scan_bus_chunk(uint64_t start, uint64_t end, void *arg)
+{
+    mcfg_entry_t      *entry       = (mcfg_entry_t *)arg;
+    pci_device_t       curr_device = {entry->segment, 0, 0, 0};
+    pci_device_cache_t curr_cache  = {
+        &curr_device, entry, 0, 0, 0, 0, 0, 0, 0,
+    };
+
+    for (uint64_t bus = start; bus < end; bus++) pci_iter_bus_range(&pci_scan_buses[bus], &curr_cache, (bus_range_t) {bus, bus + 1});
+}
+
+/* Take the right to scan, a scan runs too long to hold a spinlock across, so a second one yields until it is done */
+static void pci_flush_begin(void)
+{
+    while (__atomic_exchange_n(&pci_flush_busy, 1, __ATOMIC_ACQUIRE)) thread_yield();
+}
+
+/* Let the next scan in */
+static void pci_flush_end(void)
+{
+    __atomic_store_n(&pci_flush_busy, 0, __ATOMIC_RELEASE);
+}
+
+/* Scan every bus into a new list, between pci_flush_begin() and pci_flush_end() */
+static void pci_scan_devices(pci_devices_cache_t *scan)
 {
-    pci_free_devices_cache();
     pci_device_t       curr_device = {0, 0, 0, 0};
     pci_device_cache_t curr_cache  = {
         &curr_device, 0, 0, 0, 0, 0, 0, 0, 0,
     };
 
-    if (!mcfg_info.enabled) {
-        curr_device.domain = 0;
-        pci_iter_bus_range(&curr_cache, (bus_range_t) {0, 256});
-    } else {
-        for (size_t i = 0; i < mcfg_info.count; i++) {
-            mcfg_entry_t *entry = &mcfg_info.mcfg->entries[i];
-            curr_cache.entry    = entry;
-            curr_device.domain  = entry->segment;
-            pci_iter_bus_range(&curr_cache, (bus_range_t) {entry->start_bus, entry->end_bus + 1});
+    scan->head          = 0;
+    scan->devices_count = 0;
+    if (!mcfg_info.enabled) { // 0xcf8 and 0xcfc are one shared index and data pair, the legacy scan stays on this CPU
+        pci_iter_bus_range(scan, &curr_cache, (bus_range_t) {0, 256});
+        return;
+    }
+
+    /* ECAM accesses are independent memory reads, spread the buses over the CPUs */
+    for (size_t i = 0; i < mcfg_info.count; i++) {
+        mcfg_entry_t *entry = &mcfg_info.mcfg->entries[i];
+        memset(&pci_scan_buses[entry->start_bus], 0, sizeof(pci_devices_cache_t) * (entry->end_bus - entry->start_bus + 1));
+        parallel_for(entry->start_bus, entry->end_bus + 1, 1, pci_scan_bus_chunk, entry);
+
+        /* Splice in bus order, the list comes out as a serial scan would build it */
+        for (uint32_t bus = entry->start_bus; bus <= entry->end_bus; bus++) {
+            pci_devices_cache_t *list = &pci_scan_buses[bus];
+            if (!list->head) continue;
+            pci_device_cache_t *tail = list->head;
+            while (tail->next) tail = tail->next;
+            tail->next = scan->head;
+            scan->head = list->head;
+            scan->devices_count += list->devices_count;
         }
     }
+}
+
+/* Flush the PCI devices cache */
+void pci_flush_devices_cache(void)
+{
+    pci_devices_cache_t scan;
+
+    pci_flush_begin();
+    pci_scan_devices(&scan);
+
+    /* The new list is complete before it is published, readers never wait */
+    uint64_t            flags = spin_lock_irqsave(&pci_cache_lock);
+    pci_device_cache_t *old   = pci_cache.head;
+    rcu_assign_pointer(pci_cache.head, scan.head);
+    pci_cache.devices_count = scan.devices_count;
+    spin_unlock_irqrestore(&pci_cache_lock, flags);
+    pci_flush_end();
+
+    pci_retire_cache_list(old);
     pci_update_usable_list();
 }
 
-/* Found PCI devices cache by vender ID and device ID */
+/* Scan every bus without touching the cache, returns the number of functions found */
+uint32_t pci_count_devices(void)
+{
+    pci_devices_cache_t scan;
+
+    pci_flush_begin();
+    pci_scan_devices(&scan);
+    pci_flush_end();
+
+    pci_free_cache_list(scan.head);
+    return (uint32_t)scan.devices_count;
+}
+
+/* Found PCI devices cache by vender ID and device ID, call under rcu_read_lock(), the node stays valid until rcu_read_unlock() */
 pci_device_cache_t *pci_found_device_cache(pci_device_cache_t *start, pci_device_request_t device_req)
 {
-    uint32_t            vendor_id = device_req.vendor_id;
-    uint32_t            device_id = device_req.device_id;
-    pci_device_cache_t *cache     = start ? start : pci_cache.head;
-    while (cache != 0) {
-        if (cache->vendor_id == vendor_id && cache->device_id == device_id) return cache;
-        cache = cache->next;
-    }
-    return 0;
+    uint32_t vendor_id = device_req.vendor_id;
+    uint32_t device_id = device_req.device_id;
+
+    /* Nodes are never changed once published, only the head pointer is swapped */
+    pci_device_cache_t *cache = start ? start : rcu_dereference(pci_cache.head);
+    while (cache != 0 && !(cache->vendor_id == vendor_id && cache->device_id == device_id)) cache = cache->next;
+    return cache;
 }
 
-/* Found PCI devices cache by class code */
+/* Found PCI devices cache by class code, call under rcu_read_lock(), the node stays valid until rcu_read_unlock() */
 pci_device_cache_t *pci_found_class_cache(pci_device_cache_t *start, pci_class_request_t class_req)
 {
-    uint32_t            class_code = class_req.class_code;
-    pci_device_cache_t *cache      = start ? start : pci_cache.head;
-    while (cache != 0) {
-        if (cache->class_code == class_code || (cache->class_code & 0xffff00) == class_code) return cache;
-        cache = cache->next;
-    }
-    return 0;
+    uint32_t class_code = class_req.class_code;
+
+    pci_device_cache_t *cache = start ? start : rcu_dereference(pci_cache.head);
+    while (cache != 0 && !(cache->class_code == class_code || (cache->class_code & 0xffff00) == class_code)) cache = cache->next;
+    return cache;
 }
 
 /* PCI device initialization */
 void pci_init(void)
 {
     pci_flush_devices_cache();
-    pci_device_cache_t *cache  = pci_cache.head;
+    rcu_read_lock();
+    pci_device_cache_t *cache  = rcu_dereference(pci_cache.head);
     pci_device_t       *device = 0;
 
     if (!mcfg_info.enabled)
@@ -755,4 +894,6 @@ void pci_init(void)
         cache = cache->next;
     }
     plogk("pci: Found %lu devices.\n", pci_cache.devices_count);
+    rcu_read_unlock();
 }
+INITCALL(pci_init, INITCALL_DEVICE, INITCALL_ASYNC);
@@ -0,0 +1,227 @@
+/*
+ *
+ *      pci_msi.c
+ *      PCI Message Signaled Interrupts (MSI and MSI-X)
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "apic.h"
+#include "irq.h"
+#include "isolation.h"
+#include "pci.h"
+#include "percpu.h"
+#include "printk.h"
+#include "smp.h"
+#include "stdint.h"
+#include "string.h"
+
+#define MSI_ADDRESS_BASE 0xfee00000 // Local APIC message window, physical destination, fixed delivery
+#define MSI_DEST_MAX     0xff       // Widest APIC ID the destination field holds without interrupt remapping
+
+/* Message control sits in the upper half of the first capability dword */
+#define MSI_CTRL_ENABLE   (1 << 16)
+#define MSI_CTRL_MME_MASK (7 << 20) // Multiple message enable, 0 means one message
+#define MSI_CTRL_64BIT    (1 << 23)
+#define MSI_CTRL_MASKABLE (1 << 24)
+
+#define MSIX_CTRL_ENABLE   (1U << 31)
+#define MSIX_CTRL_MASK_ALL (1 << 30)
+#define MSIX_TABLE_BIR     0x7
+
+#define MSIX_ENTRY_ADDR_LOW  0
+#define MSIX_ENTRY_ADDR_HIGH 1
+#define MSIX_ENTRY_DATA      2
+#define MSIX_ENTRY_CTRL      3
+#define MSIX_ENTRY_MASKED    1
+
+/* Read a config dword, every offset used here is dword aligned */
+static uint32_t pci_msi_read(pci_device_cache_t *device, uint32_t offset)
+{
+    return read_pci((pci_device_reg_t) {device, offset});
+}
+
+/* Write a config dword */
+static void pci_msi_write(pci_device_cache_t *device, uint32_t offset, uint32_t value)
+{
+    write_pci((pci_device_reg_t) {device, offset}, value);
+}
+
+/* Build the message address of a CPU, returns 1 if its APIC ID does not fit the destination field */
+static int pci_msi_address(uint32_t cpu, uint32_t *address)
+{
+    if (cpu >= get_cpu_count()) return 1;
+    uint64_t apic_id = get_cpu_percpu(cpu)->lapic_id;
+    if (apic_id > MSI_DEST_MAX) return 1;
+    *address = MSI_ADDRESS_BASE | (uint32_t)apic_id << 12;
+    return 0;
+}
+
+/* Switch the device between its INTx pin and message writes, which need bus mastering */
+static void pci_msi_intx(pci_device_cache_t *device, int enable)
+{
+    uint32_t command = pci_read_command_status(device) & 0xffff; // Writing the status half back would clear its error bits
+    if (enable)
+        command &= ~PCI_COMMAND_INTX_DISABLE;
+    else
+        command |= PCI_COMMAND_INTX_DISABLE | PCI_COMMAND_MASTER | PCI_COMMAND_MEMORY;
+    pci_write_command_status(device, command);
+}
+
+/* Program one MSI-X entry, masked while its address and data change */
+static void pci_msix_entry(pci_irq_t *irq, uint32_t queue, uint32_t address)
+{
+    volatile uint32_t *entry = irq->table + queue * 4;
+    entry[MSIX_ENTRY_CTRL] |= MSIX_ENTRY_MASKED;
+    entry[MSIX_ENTRY_ADDR_LOW]  = address;
+    entry[MSIX_ENTRY_ADDR_HIGH] = 0;
+    entry[MSIX_ENTRY_DATA]      = irq->vectors[queue];
+    entry[MSIX_ENTRY_CTRL] &= ~MSIX_ENTRY_MASKED;
+}
+
+/* Program the single MSI message, masked around the update where the function supports it */
+static void pci_msi_message(pci_irq_t *irq, uint32_t address)
+{
+    uint32_t control = pci_msi_read(irq->device, irq->cap);
+    uint32_t data    = irq->cap + (control & MSI_CTRL_64BIT ? 0xc : 0x8);
+    uint32_t mask    = data + 4;
+
+    if (control & MSI_CTRL_MASKABLE) pci_msi_write(irq->device, mask, pci_msi_read(irq->device, mask) | 1);
+    pci_msi_write(irq->device, irq->cap + 4, address);
+    if (control & MSI_CTRL_64BIT) pci_msi_write(irq->device, irq->cap + 8, 0);
+    pci_msi_write(irq->device, data, irq->vectors[0]);
+    if (control & MSI_CTRL_MASKABLE) pci_msi_write(irq->device, mask, pci_msi_read(irq->device, mask) & ~1U);
+}
+
+/* Give the next queue a vector and the first housekeeping CPU from `queue` on that messages can reach, returns 1 on failure */
+static int pci_irq_queue_setup(pci_irq_t *irq, irq_handler_t handler, void *data)
+{
+    uint32_t queue = irq->count, cpus = get_cpu_count(), address = 0, cpu = 0, i;
+
+    for (i = 0; i < cpus; i++) {
+        cpu = (queue + i) % cpus;
+        if (!cpu_isolated(cpu) && !pci_msi_address(cpu, &address)) break;
+    }
+    if (i == cpus) return 1;
+
+    uint8_t vector = irq_alloc_vector(handler, data, "pci-msi");
+    if (!vector) return 1;
+    irq->vectors[queue] = vector;
+    irq->cpus[queue]    = cpu;
+    irq->data[queue]    = data;
+    irq->count++;
+
+    if (irq->mode == PCI_IRQ_MSIX)
+        pci_msix_entry(irq, queue, address);
+    else
+        pci_msi_message(irq, address);
+    return 0;
+}
+
+/* Map the MSI-X table and set up to `count` entries, returns 1 if none could be */
+static int pci_msix_setup(pci_irq_t *irq, uint32_t count, irq_handler_t handler, void **data)
+{
+    uint32_t control = pci_msi_read(irq->device, irq->cap);
+    uint32_t table   = pci_msi_read(irq->device, irq->cap + 4);
+    uint32_t size    = ((control >> 16) & 0x7ff) + 1;
+
+    base_address_register_t bar = get_base_address_register(irq->device, table & MSIX_TABLE_BIR);
+    if (bar.type != mem_mapping || !bar.address) return 1;
+    irq->table = (volatile uint32_t *)((uint8_t *)bar.address + (table & ~MSIX_TABLE_BIR));
+    irq->mode  = PCI_IRQ_MSIX;
+
+    /* The function mask holds every entry back while the table is written */
+    pci_msi_intx(irq->device, 0);
+    pci_msi_write(irq->device, irq->cap, control | MSIX_CTRL_ENABLE | MSIX_CTRL_MASK_ALL);
+    for (uint32_t i = 0; i < size; i++) irq->table[i * 4 + MSIX_ENTRY_CTRL] |= MSIX_ENTRY_MASKED;
+
+    if (count > size) count = size;
+    for (uint32_t i = 0; i < count; i++)
+        if (pci_irq_queue_setup(irq, handler, data ? data[i] : 0)) break;
+
+    if (!irq->count) {
+        pci_msi_write(irq->device, irq->cap, control & ~(MSIX_CTRL_ENABLE | MSIX_CTRL_MASK_ALL));
+        pci_msi_intx(irq->device, 1);
+        irq->mode = PCI_IRQ_INTX;
+        return 1;
+    }
+    pci_msi_write(irq->device, irq->cap, (control | MSIX_CTRL_ENABLE) & ~MSIX_CTRL_MASK_ALL);
+    return 0;
+}
+
+/* Set up a single MSI message, returns 1 if it could not be */
+static int pci_msi_setup(pci_irq_t *irq, irq_handler_t handler, void *data)
+{
+    /* Multiple messages would need a naturally aligned block of vectors, one is all a queue needs here */
+    uint32_t control = pci_msi_read(irq->device, irq->cap) & ~(MSI_CTRL_ENABLE | MSI_CTRL_MME_MASK);
+    pci_msi_write(irq->device, irq->cap, control);
+    irq->mode = PCI_IRQ_MSI;
+
+    if (pci_irq_queue_setup(irq, handler, data)) {
+        irq->mode = PCI_IRQ_INTX;
+        return 1;
+    }
+    pci_msi_intx(irq->device, 0);
+    pci_msi_write(irq->device, irq->cap, control | MSI_CTRL_ENABLE);
+    return 0;
+}
+
+/* Allocate up to `count` vectors over MSI-X, else one over MSI, queue i on CPU i with argument data[i], returns the number set up */
+uint32_t pci_alloc_irq_vectors(pci_irq_t *irq, pci_device_cache_t *device, uint32_t count, irq_handler_t handler, void **data)
+{
+    static const char *mode_names[] = {"INTx", "MSI", "MSI-X"};
+
+    memset(irq, 0, sizeof(pci_irq_t));
+    irq->device  = device;
+    irq->mode    = PCI_IRQ_INTX;
+    irq->handler = handler;
+    if (count > PCI_IRQ_MAX_VECTORS) count = PCI_IRQ_MAX_VECTORS;
+    if (!count) return 0;
+
+    irq->cap = pci_find_capability(device, PCI_CAP_ID_MSIX);
+    if (!irq->cap || pci_msix_setup(irq, count, handler, data)) {
+        irq->cap = pci_find_capability(device, PCI_CAP_ID_MSI);
+        if (!irq->cap || pci_msi_setup(irq, handler, data ? data[0] : 0)) return 0;
+    }
+
+    pci_device_t *dev = device->device;
+    plogk("pci: %04x:%02x:%02x.%01x: %u %s vectors from %#x, first on CPU %u.\n", dev->domain, dev->bus, dev->slot,
+          dev->func, irq->count, mode_names[irq->mode], irq->vectors[0], irq->cpus[0]);
+    return irq->count;
+}
+
+/* Deliver one queue's vector to another CPU, returns 1 if the queue or CPU is invalid */
+int pci_irq_set_affinity(pci_irq_t *irq, uint32_t queue, uint32_t cpu)
+{
+    uint32_t address;
+    if (irq->mode == PCI_IRQ_INTX || queue >= irq->count || pci_msi_address(cpu, &address)) return 1;
+
+    if (irq->mode == PCI_IRQ_MSIX)
+        pci_msix_entry(irq, queue, address);
+    else
+        pci_msi_message(irq, address);
+    irq->cpus[queue] = cpu;
+    return 0;
+}
+
+/* Turn message signaled interrupts off, free the vectors and give the device its INTx pin back */
+void pci_free_irq_vectors(pci_irq_t *irq)
+{
+    if (irq->mode == PCI_IRQ_INTX) return;
+
+    uint32_t control = pci_msi_read(irq->device, irq->cap);
+    if (irq->mode == PCI_IRQ_MSIX) {
+        for (uint32_t i = 0; i < irq->count; i++) irq->table[i * 4 + MSIX_ENTRY_CTRL] |= MSIX_ENTRY_MASKED;
+        pci_msi_write(irq->device, irq->cap, control & ~(MSIX_CTRL_ENABLE | MSIX_CTRL_MASK_ALL));
+    } else {
+        pci_msi_write(irq->device, irq->cap, control & ~MSI_CTRL_ENABLE);
+    }
+    pci_msi_intx(irq->device, 1);
+
+    for (uint32_t i = 0; i < irq->count; i++) irq_free_vector(irq->vectors[i], irq->handler, irq->data[i]);
+    irq->count = 0;
+    irq->mode  = PCI_IRQ_INTX;
+}
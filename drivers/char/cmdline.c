@@ -9,11 +9,36 @@
  *
  */
 
+#include "cmdline.h"
 #include "limine.h"
 #include "rinx.h"
+#include "stddef.h"
+#include "string.h"
 
 /* Get the kernel command line */
 const char *get_cmdline(void)
 {
     return kernel_file_request.response->kernel_file->cmdline;
 }
+
+/* Copy the value of a `key=value` argument into `value`, returns 1 if the command line does not have it */
+int cmdline_get_arg(const char *key, char *value, size_t size)
+{
+    const char *p   = get_cmdline();
+    size_t      len = strlen(key);
+    if (!p || !size) return 1;
+
+    while (*p) {
+        while (*p == ' ') p++;
+        const char *arg = p;
+        while (*p && *p != ' ') p++;
+        if ((size_t)(p - arg) <= len || strncmp(arg, key, len) || arg[len] != '=') continue;
+
+        size_t n = (size_t)(p - arg) - len - 1;
+        if (n >= size) n = size - 1; // Truncated, a value this long is malformed anyway
+        memcpy(value, arg + len + 1, n);
+        value[n] = '\0';
+        return 0;
+    }
+    return 1;
+}
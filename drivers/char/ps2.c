@@ -11,6 +11,7 @@
 
 #include "ps2.h"
 #include "common.h"
+#include "initcall.h"
 #include "printk.h"
 
 /* Waiting for PS/2 read ready */
@@ -130,3 +131,4 @@ void init_ps2(void)
     final_config |= PS2_CONFIG_PORT2_CLOCK;
     ps2_write_config(final_config);
 }
+INITCALL(init_ps2, INITCALL_DEVICE, INITCALL_ASYNC);
@@ -88,6 +88,16 @@ void flush_tlb(uint64_t addr)
     __asm__ volatile("invlpg (%0)" ::"r"(addr) : "memory");
 }
 
+/* Flushes all non-global TLB entries of the current CPU */
+void flush_tlb_local(void)
+{
+    __asm__ volatile("mov %%cr3, %%rax\n\t"
+                     "mov %%rax, %%cr3\n\t"
+                     :
+                     :
+                     : "rax", "memory");
+}
+
 /* Get the current value of the CR3 register */
 uint64_t get_cr3(void)
 {
@@ -152,6 +162,14 @@ void wrmsr(uint32_t msr, uint64_t value)
     __asm__ volatile("wrmsr" ::"c"(msr), "a"(rax), "d"(rdx));
 }
 
+/* Read the time-stamp counter */
+uint64_t rdtsc(void)
+{
+    uint32_t rax, rdx;
+    __asm__ volatile("rdtsc" : "=a"(rax), "=d"(rdx));
+    return ((uint64_t)rdx << 32) | rax;
+}
+
 /* Loading data atomically */
 uint64_t load(uint64_t *addr)
 {
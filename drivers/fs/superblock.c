@@ -12,16 +12,22 @@
 #include "fs/superblock.h"
 #include "alloc.h"
 #include "printk.h"
+#include "rcu.h"
 #include "spin_lock.h"
 #include "string.h"
 
-size_t superblocks_length = 0; // Current length of array superblocks
-sb_t  *superblocks;            // All the superblocks
+/* Copy-on-write table of every superblock, readers walk it under rcu_read_lock() */
+typedef struct {
+        rcu_head_t rcu;
+        size_t     length;    // Slots in `entries`
+        sb_t       entries[]; // Free slots hold sb_dummy
+} sb_table_t;
 
-spinlock_t superblock_lock = {
-    .lock   = 0, // Unlock
-    .rflags = 0  // Initialized sign
-};
+static sb_table_t *superblock_table; // Replaced as a whole on every change, never written once published
+
+static DEFINE_SPIN_LOCK_CLASS(superblock_lock_class, "superblock");
+
+spinlock_t superblock_lock = SPINLOCK_INIT(&superblock_lock_class); // Serializes registration, lookups take no lock
 
 sb_t sb_dummy = { // Dummy superblock
     .type            = SUPERBLOCK_NULL,
@@ -42,20 +48,33 @@ sb_t sb_dummy = { // Dummy superblock
 
     .private_data = (void *)NULL};
 
+/* Copy a table into a new one of `length` slots, padded with dummies, returns 0 if out of memory */
+static sb_table_t *superblock_table_copy(const sb_table_t *old, size_t length)
+{
+    sb_table_t *table = (sb_table_t *)malloc(sizeof(sb_table_t) + sizeof(sb_t) * length);
+    if (!table) return 0;
+
+    table->length = length;
+    for (size_t i = 0; i < length; i++) table->entries[i] = old && i < old->length ? old->entries[i] : sb_dummy;
+    return table;
+}
+
+/* RCU callback of a replaced table */
+static void superblock_table_free(rcu_head_t *head)
+{
+    free((sb_table_t *)head);
+}
+
 int superblock_init()
 {
-    superblocks = (sb_t *)malloc(sizeof(sb_t) * DEFAULT_SUPERBLOCK_COUNT);
+    sb_table_t *table = superblock_table_copy(0, DEFAULT_SUPERBLOCK_COUNT); // Fill in dummies
 
-    if (superblocks == NULL) {
+    if (table == NULL) {
         plogk("vfs: Failed to initialize superblock manager.\n");
         return 0;
     }
 
-    superblocks_length = DEFAULT_SUPERBLOCK_COUNT;
-
-    for (size_t i = 0; i < superblocks_length; i++) { // Fill in dummies
-        superblocks[i] = sb_dummy;
-    }
+    rcu_assign_pointer(superblock_table, table);
 
     plogk("vfs: Superblock manager successfully.\n");
 
@@ -64,35 +83,27 @@ int superblock_init()
 
 int superblock_register(sb_t sb)
 {
-    spin_lock(&superblock_lock);
+    uint64_t    flags = spin_lock_irqsave(&superblock_lock);
+    sb_table_t *old   = superblock_table;
+    size_t      slot  = 0;
 
-    for (size_t i = 0; i < superblocks_length; i++) {
-        if (superblocks[i].type == SUPERBLOCK_NULL) {
-            superblocks[i] = sb;
-            spin_unlock(&superblock_lock);
-            plogk("sb: Register superblock type=%d ID=%u name=%s\n", sb.type, sb.device_id, sb.device_name);
-            return 1;
-        }
-    }
+    while (slot < old->length && old->entries[slot].type != SUPERBLOCK_NULL) slot++;
 
-    size_t new_length = superblocks_length * 2;
-    sb_t  *new_blocks = realloc(superblocks, sizeof(sb_t) * new_length);
+    /* Readers keep walking the old table, the new one is complete before it is published */
+    sb_table_t *table = superblock_table_copy(old, slot < old->length ? old->length : old->length * 2);
 
-    if (!new_blocks) {
-        spin_unlock(&superblock_lock);
+    if (!table) {
+        spin_unlock_irqrestore(&superblock_lock, flags);
         plogk("sb: Register superblock failed type=%d ID=%u Name=%s\n", sb.type, sb.device_id, sb.device_name);
 
         return 0;
     }
 
-    superblocks = new_blocks;
-
-    for (size_t i = superblocks_length; i < new_length; i++) { superblocks[i] = sb_dummy; }
-    superblocks_length = new_length;
+    table->entries[slot] = sb;
+    rcu_assign_pointer(superblock_table, table);
 
-    superblocks[superblocks_length / 2] = sb;
-
-    spin_unlock(&superblock_lock);
+    spin_unlock_irqrestore(&superblock_lock, flags);
+    call_rcu(&old->rcu, superblock_table_free);
     plogk("sb: Register superblock type=%d ID=%u name=%s\n", sb.type, sb.device_id, sb.device_name);
 
     return 1;
@@ -100,13 +111,19 @@ int superblock_register(sb_t sb)
 
 int superblock_unregister(sb_t sb)
 {
-    spin_lock(&superblock_lock);
+    uint64_t    flags = spin_lock_irqsave(&superblock_lock);
+    sb_table_t *old   = superblock_table;
+
+    for (size_t i = 0; i < old->length; i++) {
+        if (old->entries[i].device_id == sb.device_id && strcmp(old->entries[i].device_name, sb.device_name) == 0) {
+            sb_table_t *table = superblock_table_copy(old, old->length);
+            if (!table) break;
 
-    for (size_t i = 0; i < superblocks_length; i++) {
-        if (superblocks[i].device_id == sb.device_id && strcmp(superblocks[i].device_name, sb.device_name) == 0) {
-            superblocks[i] = sb_dummy;
+            table->entries[i] = sb_dummy;
+            rcu_assign_pointer(superblock_table, table);
 
-            spin_unlock(&superblock_lock);
+            spin_unlock_irqrestore(&superblock_lock, flags);
+            call_rcu(&old->rcu, superblock_table_free);
             plogk("sb: Unregister superblock type=%d ID=%u name=%s\n", sb.type, sb.device_id, sb.device_name);
 
             return 1;
@@ -115,7 +132,7 @@ int superblock_unregister(sb_t sb)
 
     plogk("sb: Unregister superblock failed type=%d ID=%u name=%s\n", sb.type, sb.device_id, sb.device_name);
 
-    spin_unlock(&superblock_lock);
+    spin_unlock_irqrestore(&superblock_lock, flags);
     return 0;
 }
 
@@ -164,63 +181,69 @@ int superblock_is_ready(const sb_t sb)
 
 sb_t superblock_find_id(const uint32_t id)
 {
-    spin_lock(&superblock_lock);
+    sb_t found = sb_dummy;
+
+    rcu_read_lock();
+    sb_table_t *table = rcu_dereference(superblock_table);
 
-    for (size_t i = 0; i < superblocks_length; i++) {
-        if (superblocks[i].device_id == id) {
-            spin_unlock(&superblock_lock);
-            return superblocks[i];
+    for (size_t i = 0; table && i < table->length; i++) {
+        if (table->entries[i].device_id == id) {
+            found = table->entries[i]; // The table may be freed once unlocked
+            break;
         }
     }
 
-    spin_unlock(&superblock_lock);
-    return sb_dummy;
+    rcu_read_unlock();
+    return found;
 }
 
 sb_t superblock_find_name(const char *name)
 {
-    spin_lock(&superblock_lock);
+    sb_t found = sb_dummy;
 
-    for (size_t i = 0; i < superblocks_length; i++) {
-        if (strcmp(superblocks[i].device_name, name) == 0) {
-            spin_unlock(&superblock_lock);
-            return superblocks[i];
+    rcu_read_lock();
+    sb_table_t *table = rcu_dereference(superblock_table);
+
+    for (size_t i = 0; table && i < table->length; i++) {
+        if (strcmp(table->entries[i].device_name, name) == 0) {
+            found = table->entries[i]; // The table may be freed once unlocked
+            break;
         }
     }
 
-    spin_unlock(&superblock_lock);
-    return sb_dummy;
+    rcu_read_unlock();
+    return found;
 }
 
 size_t superblock_count()
 {
-    spin_lock(&superblock_lock);
-
     size_t count = 0;
 
-    for (size_t i = 0; i < superblocks_length; i++) {
-        if (superblocks[i].type != SUPERBLOCK_NULL) count++;
+    rcu_read_lock();
+    sb_table_t *table = rcu_dereference(superblock_table);
+
+    for (size_t i = 0; table && i < table->length; i++) {
+        if (table->entries[i].type != SUPERBLOCK_NULL) count++;
     }
 
-    spin_unlock(&superblock_lock);
+    rcu_read_unlock();
     return count;
 }
 
+/* The callback runs under rcu_read_lock() on a snapshot of the table, it must not block */
 int superblock_foreach(superblock_iter_cb callback, void *arg)
 {
-    spin_lock(&superblock_lock);
+    if (!callback) return 0;
 
-    if (!callback) {
-        spin_unlock(&superblock_lock);
-        return 0;
-    }
+    rcu_read_lock();
+    sb_table_t *table = rcu_dereference(superblock_table);
 
-    for (size_t i = 0; i < superblocks_length; i++) {
-        if (superblocks[i].type != SUPERBLOCK_NULL) {
-            if (!callback(&superblocks[i], arg)) break;
+    for (size_t i = 0; table && i < table->length; i++) {
+        if (table->entries[i].type != SUPERBLOCK_NULL) {
+            if (!callback(&table->entries[i], arg)) break;
         }
     }
 
-    spin_unlock(&superblock_lock);
+    rcu_read_unlock();
     return 1;
 }
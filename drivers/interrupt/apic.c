@@ -14,17 +14,35 @@
 #include "common.h"
 #include "hhdm.h"
 #include "idt.h"
+#include "isolation.h"
 #include "limine.h"
 #include "printk.h"
 #include "rinx.h"
+#include "smp.h"
+#include "spin_lock.h"
 #include "stddef.h"
 #include "stdint.h"
+#include "tick.h"
+
+/* Routing of an I/O APIC pin */
+typedef struct ioapic_pin {
+        uint8_t   vector;   // 0 while the pin is not routed
+        uint8_t   logical;  // Lowest-priority delivery to a set of logical IDs
+        uint32_t  dest;     // Physical APIC ID, or the logical ID bits
+        cpumask_t affinity; // CPUs the pin may be delivered to
+} ioapic_pin_t;
 
 int x2apic_mode;
 
 pointer_cast_t lapic_ptr;
 pointer_cast_t ioapic_ptr;
 
+static ioapic_pin_t ioapic_pins[IOAPIC_MAX_PINS];
+static int          ioapic_flat_logical = 0; // Every CPU has a flat logical ID
+
+static DEFINE_SPIN_LOCK_CLASS(ioapic_lock_class, "ioapic");
+static spinlock_t ioapic_lock = SPINLOCK_INIT(&ioapic_lock_class); // Index and data register pair
+
 /* Turn off PIC */
 void disable_pic(void)
 {
@@ -32,8 +50,8 @@ void disable_pic(void)
     outb(0xa1, 0xff);
 }
 
-/* Write I/O APIC register */
-void ioapic_write(uint32_t reg, uint32_t value)
+/* Select an I/O APIC register and write it, the caller holds ioapic_lock */
+static void ioapic_write_locked(uint32_t reg, uint32_t value)
 {
     mmio_write32(ioapic_ptr.ptr, reg);
     pointer_cast_t reg_ptr;
@@ -41,18 +59,58 @@ void ioapic_write(uint32_t reg, uint32_t value)
     mmio_write32(reg_ptr.ptr, value);
 }
 
+/* Write I/O APIC register */
+void ioapic_write(uint32_t reg, uint32_t value)
+{
+    uint64_t flags = spin_lock_irqsave(&ioapic_lock);
+    ioapic_write_locked(reg, value);
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+}
+
 /* Read I/O APIC registers */
 uint32_t ioapic_read(uint32_t reg)
 {
+    uint64_t flags = spin_lock_irqsave(&ioapic_lock);
     mmio_write32(ioapic_ptr.ptr, reg);
     pointer_cast_t reg_ptr;
-    reg_ptr.val = ioapic_ptr.val + 0x10;
-    return mmio_read32(reg_ptr.ptr);
+    reg_ptr.val    = ioapic_ptr.val + 0x10;
+    uint32_t value = mmio_read32(reg_ptr.ptr);
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+    return value;
+}
+
+/* Write the redirection entry of a pin from its routing, the caller holds ioapic_lock */
+static void ioapic_pin_write(uint32_t irq)
+{
+    ioapic_pin_t *pin      = &ioapic_pins[irq];
+    uint32_t      ioredtbl = (uint32_t)(0x10 + irq * 2);
+    uint64_t      redirect = pin->vector;
+    if (pin->logical) redirect |= IOAPIC_RTE_LOGICAL | IOAPIC_RTE_LOWEST;
+    redirect |= (uint64_t)pin->dest << 56;
+
+    /* Destination first, a pin that only moves never sees a half-written entry */
+    ioapic_write_locked(ioredtbl + 1, (uint32_t)(redirect >> 32));
+    ioapic_write_locked(ioredtbl, (uint32_t)redirect);
 }
 
 /* Configuring I/O APIC interrupt routing */
 void ioapic_add(ioapic_routing_t *routing)
 {
+    if (routing->irq < IOAPIC_MAX_PINS) {
+        /* Probes run on any CPU, an isolated one hands its pin to a housekeeping CPU */
+        ioapic_pin_t *pin = &ioapic_pins[routing->irq];
+        uint32_t      cpu = housekeeping_cpu();
+        pin->vector       = routing->vector;
+        pin->logical      = 0;
+        pin->dest         = cpu == get_current_cpu_id() ? (uint32_t)lapic_id() : (uint32_t)get_cpu_percpu(cpu)->lapic_id;
+        pin->affinity     = *housekeeping_mask();
+
+        uint64_t flags = spin_lock_irqsave(&ioapic_lock);
+        ioapic_pin_write(routing->irq);
+        spin_unlock_irqrestore(&ioapic_lock, flags);
+        return;
+    }
+
     uint32_t ioredtbl = (uint32_t)(0x10 + (uint32_t)(routing->irq * 2));
     uint64_t redirect = routing->vector;
     redirect |= lapic_id() << 56;
@@ -60,6 +118,110 @@ void ioapic_add(ioapic_routing_t *routing)
     ioapic_write(ioredtbl + 1, (uint32_t)(redirect >> 32));
 }
 
+/* Returns the number of redirection entries of the I/O APIC */
+uint32_t ioapic_pin_count(void)
+{
+    return ((ioapic_read(IOAPIC_REG_VERSION) >> 16) & 0xff) + 1;
+}
+
+/* Check whether a pin was routed by ioapic_add() */
+int ioapic_pin_routed(uint32_t irq)
+{
+    return irq < IOAPIC_MAX_PINS && ioapic_pins[irq].vector;
+}
+
+/* Deliver a pin to the CPUs in `mask`, lowest-priority among them where supported, returns 1 if it cannot */
+int ioapic_set_affinity(uint32_t irq, const cpumask_t *mask)
+{
+    uint32_t  cpus = get_cpu_count();
+    cpumask_t online, allowed;
+    if (!ioapic_pin_routed(irq) || !cpus) return 1;
+    cpumask_fill(&online, cpus);
+    cpumask_and(&allowed, mask, &online);
+    if (cpumask_empty(&allowed)) return 1;
+
+    ioapic_pin_t *pin   = &ioapic_pins[irq];
+    uint64_t      flags = spin_lock_irqsave(&ioapic_lock);
+    pin->affinity       = allowed;
+    if (ioapic_flat_logical && cpumask_weight(&allowed) > 1) {
+        uint32_t cpu, dest = 0;
+        for_each_cpu(cpu, &allowed) dest |= 1 << cpu;
+        pin->logical = 1;
+        pin->dest    = dest;
+    } else {
+        /* Stay on the current CPU if it is still allowed */
+        uint32_t cpu = pin->logical ? CPUMASK_BITS : ioapic_irq_cpu(irq);
+        if (!cpumask_test_cpu(&allowed, cpu)) cpu = cpumask_first(&allowed);
+        pin->logical = 0;
+        pin->dest    = (uint32_t)get_cpu_percpu(cpu)->lapic_id;
+    }
+    ioapic_pin_write(irq);
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+    return 0;
+}
+
+/* Copy the affinity mask of a pin, returns 1 for a pin that is not routed */
+int ioapic_get_affinity(uint32_t irq, cpumask_t *mask)
+{
+    if (!ioapic_pin_routed(irq)) return 1;
+    uint64_t flags = spin_lock_irqsave(&ioapic_lock);
+    *mask          = ioapic_pins[irq].affinity;
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+    return 0;
+}
+
+/* Deliver a pin to one CPU of its affinity mask, returns 1 if the CPU is not in it */
+int ioapic_move_irq(uint32_t irq, uint32_t cpu)
+{
+    if (!ioapic_pin_routed(irq) || cpu >= get_cpu_count()) return 1;
+
+    ioapic_pin_t *pin   = &ioapic_pins[irq];
+    uint64_t      flags = spin_lock_irqsave(&ioapic_lock);
+    if (!cpumask_test_cpu(&pin->affinity, cpu)) {
+        spin_unlock_irqrestore(&ioapic_lock, flags);
+        return 1;
+    }
+    pin->logical = 0;
+    pin->dest    = (uint32_t)get_cpu_percpu(cpu)->lapic_id;
+    ioapic_pin_write(irq);
+    spin_unlock_irqrestore(&ioapic_lock, flags);
+    return 0;
+}
+
+/* Returns the CPU a pin is delivered to, IOAPIC_CPU_LOGICAL for lowest-priority or unrouted pins */
+uint32_t ioapic_irq_cpu(uint32_t irq)
+{
+    if (!ioapic_pin_routed(irq) || ioapic_pins[irq].logical) return IOAPIC_CPU_LOGICAL;
+    for (uint32_t cpu = 0; cpu < get_cpu_count(); cpu++)
+        if (get_cpu_percpu(cpu)->lapic_id == ioapic_pins[irq].dest) return cpu;
+    return 0; // Routed before SMP came up, that is the boot CPU
+}
+
+/* Count a device interrupt of an IOAPIC pin on the current CPU, called by its handler */
+void ioapic_account(uint32_t irq)
+{
+    if (irq < IOAPIC_MAX_PINS) this_cpu()->irq_counts[irq]++;
+}
+
+/* Load this CPU's flat logical ID, run on every CPU */
+static void ioapic_flat_logical_cpu(void *info)
+{
+    (void)info;
+    lapic_write(LAPIC_REG_DFR, LAPIC_DFR_FLAT);
+    lapic_write(LAPIC_REG_LDR, (1 << get_current_cpu_id()) << 24);
+}
+
+/* Give every CPU a flat logical ID so pins may use lowest-priority delivery, returns 1 if unsupported */
+int ioapic_logical_init(void)
+{
+    /* x2APIC logical IDs are fixed by hardware and too wide for the 8-bit I/O APIC destination */
+    uint32_t cpus = get_cpu_count();
+    if (x2apic_mode || cpus < 2 || cpus > LAPIC_FLAT_MAX_CPUS) return 1;
+    smp_call_function_all(ioapic_flat_logical_cpu, 0, 1);
+    ioapic_flat_logical = 1;
+    return 0;
+}
+
 /* Write local APIC register */
 void lapic_write(uint32_t reg, uint32_t value)
 {
@@ -98,18 +260,15 @@ void local_apic_init(void)
         plogk("apic: Local APIC: %s\n", x2apic_mode ? "x2APIC" : "xAPIC");
     }
 
-    lapic_write(LAPIC_REG_SPURIOUS, 0xff | 1 << 8);
+    lapic_write(LAPIC_REG_SPURIOUS, LAPIC_SPURIOUS_VECTOR | 1 << 8);
     lapic_write(LAPIC_REG_TIMER, IRQ_0);
     lapic_write(LAPIC_REG_TIMER_DIV, 11);
     lapic_write(LAPIC_REG_TIMER_INITCNT, ~((uint32_t)0));
 
     for (uint64_t start = nano_time(); nano_time() - start < 1000000;);
 
-    uint64_t lapic_timer              = (~(uint32_t)0) - lapic_read(LAPIC_REG_TIMER_CURCNT);
-    uint64_t calibrated_timer_initial = (uint64_t)((uint64_t)(lapic_timer * 1000) / 250);
-
-    lapic_write(LAPIC_REG_TIMER, lapic_read(LAPIC_REG_TIMER) | 1 << 17);
-    lapic_write(LAPIC_REG_TIMER_INITCNT, calibrated_timer_initial);
+    uint64_t lapic_timer = (~(uint32_t)0) - lapic_read(LAPIC_REG_TIMER_CURCNT);
+    tick_cpu_init(lapic_timer);
 }
 
 /* Initialize I/O APIC */
@@ -148,14 +307,28 @@ void lapic_timer_stop(void)
 
 /* Send interrupt handling instruction */
 void send_ipi(uint32_t apic_id, uint32_t command)
+{
+    if (x2apic_mode) { // A single MSR write, there is no delivery status to poll
+        wrmsr(0x800 + (APIC_ICR_LOW >> 4), ((uint64_t)apic_id << 32) | command);
+        return;
+    }
+
+    /* Only wait for the previous IPI, so back-to-back sends overlap with their delivery */
+    while (lapic_read(APIC_ICR_LOW) & APIC_ICR_BUSY) __asm__ volatile("pause");
+    lapic_write(APIC_ICR_HIGH, apic_id << 24);
+    lapic_write(APIC_ICR_LOW, command);
+}
+
+/* Send an interrupt to every CPU except the current one with a single ICR write */
+void send_ipi_all_but_self(uint32_t command)
 {
     if (x2apic_mode) {
-        wrmsr(0x800 + (APIC_ICR_LOW >> 4), ((uint64_t)(apic_id & 0b1111) << 32) | command);
-    } else {
-        lapic_write(APIC_ICR_HIGH, apic_id << 24);
-        lapic_write(APIC_ICR_LOW, command);
+        wrmsr(0x800 + (APIC_ICR_LOW >> 4), command | APIC_ICR_ALL_BUT);
+        return;
     }
-    while (lapic_read(APIC_ICR_LOW) & (1 << 12));
+    while (lapic_read(APIC_ICR_LOW) & APIC_ICR_BUSY) __asm__ volatile("pause");
+    lapic_write(APIC_ICR_HIGH, 0);
+    lapic_write(APIC_ICR_LOW, command | APIC_ICR_ALL_BUT);
 }
 
 /* Initialize APIC */
@@ -11,6 +11,7 @@
 
 #include "parallel.h"
 #include "common.h"
+#include "initcall.h"
 #include "printk.h"
 #include "timer.h"
 
@@ -52,6 +53,7 @@ void init_parallel(void)
     }
     if (valid_ports == 0) plogk("parallel: No parallel port available.\n");
 }
+INITCALL(init_parallel, INITCALL_DEVICE, INITCALL_ASYNC);
 
 /* Check if the specified parallel port is busy */
 int parallel_port_busy(uint16_t port)
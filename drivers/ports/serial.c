@@ -11,6 +11,7 @@
 
 #include "serial.h"
 #include "common.h"
+#include "initcall.h"
 #include "printk.h"
 #include "stdint.h"
 
@@ -119,6 +120,7 @@ void init_serial(void)
     }
     if (valid_ports == 0) plogk("serial: No serial port available.\n");
 }
+INITCALL(init_serial, INITCALL_DEVICE, INITCALL_ASYNC);
 
 /* Check whether the serial port is ready to read */
 int serial_received(uint16_t port)
@@ -12,12 +12,17 @@
 #include "video.h"
 #include "common.h"
 #include "cpuid.h"
+#include "fpu.h"
 #include "gfx_proc.h"
 #include "limine.h"
+#include "page.h"
+#include "parallel_for.h"
 #include "rinx.h"
 #include "stddef.h"
 #include "stdint.h"
 
+#define VIDEO_FILL_GRAIN 0x10000 // Pixels per parallel_for() chunk, 256 KiB of frame buffer
+
 extern uint8_t ascii_font[]; // Fonts
 
 uint64_t  width;  // Screen width
@@ -80,6 +85,9 @@ void video_init(void)
     height                                 = framebuffer->height;
     stride                                 = framebuffer->pitch / (framebuffer->bpp / 8);
 
+    /* Write-combining lets scrolls and fills stream whole lines to the device */
+    set_memory_type((uint64_t)buffer, framebuffer->pitch * height, MEMORY_TYPE_WC);
+
     x = cx = y = cy = 0;
     c_width         = width / 9;
     c_height        = height / 16;
@@ -89,11 +97,18 @@ void video_init(void)
     video_clear();
 }
 
+/* Fill the pixels [start, end) of the frame buffer with the background color */
+static void video_fill(uint64_t start, uint64_t end, void *arg)
+{
+    (void)arg;
+    for (uint64_t i = start; i < end; i++) buffer[i] = back_color;
+}
+
 /* Clear screen */
 void video_clear(void)
 {
     back_color = color_to_fb_color((color_t) {0x00, 0x00, 0x00});
-    for (uint32_t i = 0; i < (stride * height); i++) buffer[i] = back_color;
+    parallel_for(0, stride * height, VIDEO_FILL_GRAIN, video_fill, 0);
     x  = 2;
     y  = 0;
     cx = cy = 0;
@@ -103,7 +118,7 @@ void video_clear(void)
 void video_clear_color(uint32_t color)
 {
     back_color = color;
-    for (uint32_t i = 0; i < (stride * height); i++) buffer[i] = back_color;
+    parallel_for(0, stride * height, VIDEO_FILL_GRAIN, video_fill, 0);
     x  = 2;
     y  = 0;
     cx = cy = 0;
@@ -116,6 +131,30 @@ void video_move_to(uint32_t c_x, uint32_t c_y)
     cy = c_y;
 }
 
+#if CPU_FEATURE_SSE
+/* Copy 64-byte blocks through the SSE registers, the only code in this file built with SSE, call it inside kernel_fpu_begin() */
+__attribute__((target("sse2"))) static void video_copy_sse(uint8_t *dest, const uint8_t *src, size_t blocks)
+{
+    if (!blocks) return;
+    __asm__ volatile("1:\n\t"
+                     "movdqu (%[src]), %%xmm0\n\t"
+                     "movdqu 16(%[src]), %%xmm1\n\t"
+                     "movdqu 32(%[src]), %%xmm2\n\t"
+                     "movdqu 48(%[src]), %%xmm3\n\t"
+                     "movdqu %%xmm0, (%[dest])\n\t"
+                     "movdqu %%xmm1, 16(%[dest])\n\t"
+                     "movdqu %%xmm2, 32(%[dest])\n\t"
+                     "movdqu %%xmm3, 48(%[dest])\n\t"
+                     "add $64, %[src]\n\t"
+                     "add $64, %[dest]\n\t"
+                     "dec %[blocks]\n\t"
+                     "jnz 1b\n\t"
+                     : [src] "+r"(src), [dest] "+r"(dest), [blocks] "+r"(blocks)
+                     :
+                     : "xmm0", "xmm1", "xmm2", "xmm3", "memory");
+}
+#endif
+
 /* Screen scrolling operation */
 void video_scroll(void)
 {
@@ -132,27 +171,13 @@ void video_scroll(void)
         size_t         count = stride * (height - 16) * sizeof(uint32_t);
 
 #if CPU_FEATURE_SSE
-        if (cpu_support_sse()) {
-            size_t blocks = count / 64;
+        if (cpu_support_sse() && !kernel_fpu_begin()) {
             size_t remain = count % 64;
+            video_copy_sse(dest, src, count / 64);
+            kernel_fpu_end();
 
-            __asm__ volatile("1:\n\t"
-                             "movdqu (%[src]), %%xmm0\n\t"
-                             "movdqu 16(%[src]), %%xmm1\n\t"
-                             "movdqu 32(%[src]), %%xmm2\n\t"
-                             "movdqu 48(%[src]), %%xmm3\n\t"
-                             "movdqu %%xmm0, (%[dest])\n\t"
-                             "movdqu %%xmm1, 16(%[dest])\n\t"
-                             "movdqu %%xmm2, 32(%[dest])\n\t"
-                             "movdqu %%xmm3, 48(%[dest])\n\t"
-                             "add $64, %[src]\n\t"
-                             "add $64, %[dest]\n\t"
-                             "dec %[blocks]\n\t"
-                             "jnz 1b\n\t"
-                             : [src] "+r"(src), [dest] "+r"(dest), [blocks] "+r"(blocks)
-                             :
-                             : "xmm0", "xmm1", "xmm2", "xmm3", "memory");
-
+            dest += count - remain;
+            src += count - remain;
             for (size_t i = 0; i < remain; i++) *dest++ = *src++;
         } else {
             count /= 8;
@@ -157,6 +157,13 @@ typedef struct {
         generic_address_t x_gpe1_blk;
 } __attribute__((packed)) acpi_facp_t;
 
+typedef struct {
+        uint32_t type;    // ACPI C-state number, 1 for C1
+        uint32_t latency; // Worst-case exit latency in microseconds
+        uint32_t power;   // Average power in milliwatts
+        uint32_t hint;    // MWAIT hint from the functional fixed hardware register
+} acpi_cstate_t;
+
 typedef struct {
         uint64_t base_addr;
         uint16_t segment;
@@ -180,6 +187,9 @@ typedef struct {
 /* Find the corresponding ACPI table in XSDT */
 void *find_table(const char *name);
 
+/* Find the `index`-th ACPI table with a signature in XSDT, 0 if there are not that many */
+void *find_table_index(const char *name, uint32_t index);
+
 /* Initialize ACPI */
 void acpi_init(void);
 
@@ -192,6 +202,9 @@ void hpet_init(hpet_t *hpet);
 /* Initialize facp */
 void facp_init(acpi_facp_t *facp0);
 
+/* Read the MWAIT C-states of the first static _CST in the DSDT or an SSDT, returns how many were stored */
+uint32_t acpi_cst_read(acpi_cstate_t *states, uint32_t max);
+
 /* Get MCFG information */
 mcfg_info_t *get_mcfg(void);
 
@@ -13,6 +13,8 @@
 #define INCLUDE_APIC_H_
 
 #include "acpi.h"
+#include "cpumask.h"
+#include "percpu.h"
 #include "stdint.h"
 
 #define MADT_APIC_LOCAL_CPU    0x00
@@ -29,6 +31,17 @@
 #define LAPIC_REG_TIMER         0x320
 #define LAPIC_REG_SPURIOUS      0xf0
 #define LAPIC_REG_TIMER_DIV     0x3e0
+#define LAPIC_REG_LDR           0xd0 // Logical destination, xAPIC only
+#define LAPIC_REG_DFR           0xe0 // Destination format, xAPIC only
+
+#define LAPIC_SPURIOUS_VECTOR 0xff       // Delivered without an in-service bit, never acknowledged
+#define LAPIC_DFR_FLAT        0xffffffff // Flat model, one logical ID bit per CPU
+#define LAPIC_FLAT_MAX_CPUS   8
+
+#define IOAPIC_REG_VERSION 0x01
+#define IOAPIC_RTE_LOWEST  0x100      // Lowest-priority delivery
+#define IOAPIC_RTE_LOGICAL 0x800      // Destination is a set of logical APIC IDs
+#define IOAPIC_CPU_LOGICAL 0xffffffff // ioapic_irq_cpu() of a pin left to lowest-priority arbitration
 
 #define APIC_ICR_LOW  0x300
 #define APIC_ICR_HIGH 0x310
@@ -37,6 +50,7 @@
 #define IPI_HALT          0x53
 #define IPI_TLB_SHOOTDOWN 0x54
 #define IPI_PANIC         0x55
+#define IPI_CALL_FUNCTION 0x56
 
 #define IPI_FIXED         0x0
 #define IPI_LOWEST        0x100
@@ -50,6 +64,9 @@
 #define APIC_ICR_INIT     0x4500
 #define APIC_ICR_STARTUP  0x4600
 #define APIC_ICR_PHYSICAL 0x0
+#define APIC_ICR_BUSY     0x1000  // Delivery status, xAPIC only
+#define APIC_ICR_SELF     0x40000 // Destination shorthand, the sender itself
+#define APIC_ICR_ALL_BUT  0xc0000 // Destination shorthand, every CPU except the sender
 
 typedef struct {
         acpi_sdt_header_t header;
@@ -109,6 +126,30 @@ uint32_t ioapic_read(uint32_t reg);
 /* Configuring I/O APIC interrupt routing */
 void ioapic_add(ioapic_routing_t *routing);
 
+/* Returns the number of redirection entries of the I/O APIC */
+uint32_t ioapic_pin_count(void);
+
+/* Check whether a pin was routed by ioapic_add() */
+int ioapic_pin_routed(uint32_t irq);
+
+/* Deliver a pin to the CPUs in `mask`, lowest-priority among them where supported, returns 1 if it cannot */
+int ioapic_set_affinity(uint32_t irq, const cpumask_t *mask);
+
+/* Copy the affinity mask of a pin, returns 1 for a pin that is not routed */
+int ioapic_get_affinity(uint32_t irq, cpumask_t *mask);
+
+/* Deliver a pin to one CPU of its affinity mask, returns 1 if the CPU is not in it */
+int ioapic_move_irq(uint32_t irq, uint32_t cpu);
+
+/* Returns the CPU a pin is delivered to, IOAPIC_CPU_LOGICAL for lowest-priority or unrouted pins */
+uint32_t ioapic_irq_cpu(uint32_t irq);
+
+/* Count a device interrupt of an IOAPIC pin on the current CPU, called by its handler */
+void ioapic_account(uint32_t irq);
+
+/* Give every CPU a flat logical ID so pins may use lowest-priority delivery, returns 1 if unsupported */
+int ioapic_logical_init(void);
+
 /* Write local APIC register */
 void lapic_write(uint32_t reg, uint32_t value);
 
@@ -133,6 +174,9 @@ void lapic_timer_stop(void);
 /* Send interrupt handling instruction */
 void send_ipi(uint32_t apic_id, uint32_t command);
 
+/* Send an interrupt to every CPU except the current one with a single ICR write */
+void send_ipi_all_but_self(uint32_t command);
+
 /* Initialize APIC */
 void apic_init(madt_t *madt);
 
@@ -0,0 +1,57 @@
+/*
+ *
+ *      bench.h
+ *      In-kernel benchmarks header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_BENCH_H_
+#define INCLUDE_BENCH_H_
+
+#include "stdint.h"
+
+#ifndef KERNEL_BENCH
+#    define KERNEL_BENCH 0
+#endif
+
+/* Print a value with two decimals from a fixed-point x100 integer */
+#define BENCH_FIX2(value) (value) / 100, (value) % 100
+
+/* Spread CPU-bound threads over the run queues and report scaling */
+void bench_sched(void);
+
+/* Measure workqueue enqueue-to-execution latency and throughput */
+void bench_workqueue(void);
+
+/* Measure timer wheel and hrtimer arm/cancel cycles */
+void bench_timer(void);
+
+/* Measure the queued spinlock against the previous xchg lock */
+void bench_spinlock(void);
+
+/* Measure RCU list lookups against reader-writer and spin locks over growing CPU counts */
+void bench_rcu(void);
+
+/* Measure cross-CPU call round trips and throughput over growing target counts */
+void bench_smp_call(void);
+
+/* Measure periodic release jitter of the deadline and normal classes next to CPU-bound threads */
+void bench_deadline(void);
+
+/* Count the interruptions each isolated CPU takes while a single thread keeps it busy */
+void bench_isolation(void);
+
+/* Measure coroutine switches against thread switches, and the cost of many coroutines waiting on one event */
+void bench_coroutine(void);
+
+/* Time every parallel_for() site over growing CPU counts and report the speedup over one CPU */
+void bench_parallel_for(void);
+
+/* Run every in-kernel benchmark */
+void bench_run_all(void);
+
+#endif // INCLUDE_BENCH_H_
@@ -12,7 +12,12 @@
 #ifndef INCLUDE_CMDLINE_H_
 #define INCLUDE_CMDLINE_H_
 
+#include "stddef.h"
+
 /* Get the kernel command line */
 const char *get_cmdline(void);
 
+/* Copy the value of a `key=value` argument into `value`, returns 1 if the command line does not have it */
+int cmdline_get_arg(const char *key, char *value, size_t size);
+
 #endif // INCLUDE_CMDLINE_H_
@@ -38,6 +38,9 @@ void outsl(uint32_t port, const void *addr, size_t cnt);
 /* Flushes the TLB of the specified address */
 void flush_tlb(uint64_t addr);
 
+/* Flushes all non-global TLB entries of the current CPU */
+void flush_tlb_local(void);
+
 /* Get the current value of the CR3 register */
 uint64_t get_cr3(void);
 
@@ -65,6 +68,9 @@ uint64_t rdmsr(uint32_t msr);
 /* Write to msr register */
 void wrmsr(uint32_t msr, uint64_t value);
 
+/* Read the time-stamp counter */
+uint64_t rdtsc(void);
+
 /* Loading data atomically */
 uint64_t load(uint64_t *addr);
 
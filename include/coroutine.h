@@ -0,0 +1,93 @@
+/*
+ *
+ *      coroutine.h
+ *      Stackful kernel coroutines header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_COROUTINE_H_
+#define INCLUDE_COROUTINE_H_
+
+#include "double_list.h"
+#include "sched.h"
+#include "spin_lock.h"
+#include "stdint.h"
+#include "wait.h"
+
+#define CO_STACK_SIZE THREAD_STACK_SIZE // Interrupts and softirqs taken while a coroutine runs nest on it, so it gets the thread budget
+#define CO_POOL_SLOTS 4096              // Coroutines that can exist at once
+
+typedef enum {
+    CO_READY,    // On the ready list of its executor
+    CO_RUNNING,  // Running, or woken before it could switch out
+    CO_WAITING,  // Queued by co_prepare_wait() and still running, a wakeup keeps it running
+    CO_SLEEPING, // Switched out until a wakeup
+    CO_DEAD,     // Returned from its entry, the executor frees it
+} co_state_t;
+
+typedef struct co_sched {
+        spinlock_t        lock;     // Guards the ready list, the count and the coroutine states
+        ilist_node_t      ready;    // Ready coroutines, run in FIFO order
+        volatile uint32_t nr_ready; // Read without the lock by the sleeping executor
+        uint32_t          count;    // Coroutines not finished yet
+        struct coroutine *current;  // Running coroutine, 0 while the executor itself runs
+        uint64_t          rsp;      // Executor context saved while a coroutine runs
+        wait_queue_head_t wait;     // The executor thread sleeps here while every coroutine waits
+        uint64_t          switches; // Switches into coroutines
+} co_sched_t;
+
+typedef struct coroutine {
+        ilist_node_t        node;  // On the ready list
+        co_sched_t         *sched; // Executor that runs it
+        uint64_t            rsp;   // Saved stack pointer while switched out
+        uintptr_t           stack; // Lowest byte of its stack, the guard page sits below it
+        volatile co_state_t state; // CO_* state
+        void (*entry)(void *arg);
+        void              *arg;
+        wait_queue_entry_t wait; // Queued on the wait queue of co_await()
+} __attribute__((aligned(64))) coroutine_t;
+
+/* Sleep the current coroutine until `condition` holds, outside one this is wait_event() */
+#define co_await(wq, condition)        \
+    do {                               \
+        if (!co_current()) {           \
+            wait_event(wq, condition); \
+            break;                     \
+        }                              \
+        while (1) {                    \
+            co_prepare_wait(&(wq));    \
+            if (condition) break;      \
+            co_suspend();              \
+        }                              \
+        co_finish_wait(&(wq));         \
+    } while (0)
+
+/* Initialize an executor without coroutines */
+void co_sched_init(co_sched_t *sched);
+
+/* Create a coroutine and queue it on an executor, returns 0 if no stack is left */
+coroutine_t *co_create(co_sched_t *sched, void (*entry)(void *arg), void *arg);
+
+/* Run the coroutines of an executor on the calling thread until every one of them has returned */
+void co_run(co_sched_t *sched);
+
+/* Returns the running coroutine, 0 outside one */
+coroutine_t *co_current(void);
+
+/* Let the other ready coroutines run, outside a coroutine this is thread_yield() */
+void co_yield(void);
+
+/* Queue the current coroutine on a wait queue and mark it waiting, check the condition afterwards */
+void co_prepare_wait(wait_queue_head_t *wq);
+
+/* Switch away from the current coroutine unless a wakeup came after co_prepare_wait() */
+void co_suspend(void);
+
+/* Mark the current coroutine running again and dequeue it from the wait queue */
+void co_finish_wait(wait_queue_head_t *wq);
+
+#endif // INCLUDE_COROUTINE_H_
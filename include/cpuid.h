@@ -17,6 +17,9 @@
 /* Get CPUID */
 void cpuid(uint32_t code, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx);
 
+/* Get a sub-leaf of CPUID */
+void cpuid_count(uint32_t code, uint32_t subleaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx);
+
 /* Get CPU manufacturer name */
 char *get_vendor_name(void);
 
@@ -71,4 +74,16 @@ int cpu_support_avx(void);
 /* Check CPU supports AVX2 */
 int cpu_support_avx2(void);
 
+/* Check CPU supports CLFLUSH */
+int cpu_support_clflush(void);
+
+/* Check CPU supports the TSC-deadline timer mode */
+int cpu_support_tsc_deadline(void);
+
+/* Check CPU has an invariant TSC */
+int cpu_support_invariant_tsc(void);
+
+/* Get the CLFLUSH line size in bytes */
+uint32_t get_cpu_clflush_size(void);
+
 #endif // INCLUDE_CPUID_H_
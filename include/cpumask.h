@@ -0,0 +1,71 @@
+/*
+ *
+ *      cpumask.h
+ *      CPU set header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_CPUMASK_H_
+#define INCLUDE_CPUMASK_H_
+
+#include "stdint.h"
+
+#ifndef CPU_MAX_COUNT
+#    define CPU_MAX_COUNT 0
+#endif
+
+#define CPUMASK_BITS  (CPU_MAX_COUNT ? CPU_MAX_COUNT : 256) // CPUs a mask can hold, also caps the CPUs brought up
+#define CPUMASK_WORDS ((CPUMASK_BITS + 63) / 64)
+
+typedef struct {
+        uint64_t bits[CPUMASK_WORDS];
+} cpumask_t;
+
+/* Visit every CPU in a mask in ascending order */
+#define for_each_cpu(cpu, mask) \
+    for ((cpu) = cpumask_first(mask); (cpu) < CPUMASK_BITS; (cpu) = cpumask_next((mask), (cpu)))
+
+/* Remove every CPU from a mask */
+void cpumask_clear(cpumask_t *mask);
+
+/* Put CPUs 0 to count - 1 in a mask and nothing else */
+void cpumask_fill(cpumask_t *mask, uint32_t count);
+
+/* Add a CPU to a mask */
+void cpumask_set_cpu(cpumask_t *mask, uint32_t cpu);
+
+/* Remove a CPU from a mask */
+void cpumask_clear_cpu(cpumask_t *mask, uint32_t cpu);
+
+/* Check whether a CPU is in a mask */
+int cpumask_test_cpu(const cpumask_t *mask, uint32_t cpu);
+
+/* Returns the number of CPUs in a mask */
+uint32_t cpumask_weight(const cpumask_t *mask);
+
+/* Returns the lowest CPU in a mask, CPUMASK_BITS if it is empty */
+uint32_t cpumask_first(const cpumask_t *mask);
+
+/* Returns the lowest CPU above `cpu` in a mask, CPUMASK_BITS if there is none */
+uint32_t cpumask_next(const cpumask_t *mask, uint32_t cpu);
+
+/* Store the CPUs in both masks */
+void cpumask_and(cpumask_t *dst, const cpumask_t *a, const cpumask_t *b);
+
+/* Store the CPUs in either mask */
+void cpumask_or(cpumask_t *dst, const cpumask_t *a, const cpumask_t *b);
+
+/* Check whether two masks hold the same CPUs */
+int cpumask_equal(const cpumask_t *a, const cpumask_t *b);
+
+/* Check whether a mask holds no CPU */
+int cpumask_empty(const cpumask_t *mask);
+
+/* Fill a mask from a CPU list such as "1,3-5", returns 1 on a malformed list */
+int cpumask_parse(cpumask_t *mask, const char *list);
+
+#endif // INCLUDE_CPUMASK_H_
@@ -12,6 +12,10 @@
 #ifndef INCLUDE_INTRUSIVE_LIST_H_
 #define INCLUDE_INTRUSIVE_LIST_H_
 
+#include "stddef.h"
+
+#define ilist_entry(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+
 typedef struct ilist_node {
         struct ilist_node *prev;
         struct ilist_node *next;
@@ -32,4 +36,16 @@ int ilist_remove(struct ilist_node *node);
 /* Check if the intrusive linked list is empty */
 int ilist_is_empty(const struct ilist_node *list);
 
+/* Insert a new node after the specified node, publishing it to concurrent RCU readers */
+int ilist_insert_after_rcu(struct ilist_node *node, struct ilist_node *new_node);
+
+/* Insert a new node before the specified node, publishing it to concurrent RCU readers */
+int ilist_insert_before_rcu(struct ilist_node *node, struct ilist_node *new_node);
+
+/* Unlink a node but keep its next pointer for RCU readers still on it, free it after a grace period */
+int ilist_remove_rcu(struct ilist_node *node);
+
+/* Load the successor of a node inside an RCU read-side critical section */
+struct ilist_node *ilist_next_rcu(const struct ilist_node *node);
+
 #endif // INCLUDE_INTRUSIVE_LIST_H_
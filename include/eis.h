@@ -24,13 +24,23 @@
 #    define CPU_FEATURE_AVX 1
 #endif
 
+#define CR4_OSXSAVE (1 << 18)
+
+#define XFEATURE_X87    (1 << 0)
+#define XFEATURE_SSE    (1 << 1)
+#define XFEATURE_AVX    (1 << 2)
+#define XFEATURE_AVX512 (7 << 5) // Opmask, ZMM_Hi256 and Hi16_ZMM, enabled together or not at all
+
 /* Initialize the FPU, including MMX (if any) */
 void init_fpu(void);
 
 /* Initialize the SSE, including SSE2 (if any) */
 void init_sse(void);
 
-/* Initialize the AVX, including AVX2 (if any) */
+/* Initialize XSAVE with the x87 and SSE state components (if any) */
+void init_xsave(void);
+
+/* Initialize the AVX, including AVX2 and the AVX-512 state (if any) */
 void init_avx(void);
 
 #endif // INCLUDE_EIS_H_
@@ -0,0 +1,55 @@
+/*
+ *
+ *      fpu.h
+ *      Extended processor state header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_FPU_H_
+#define INCLUDE_FPU_H_
+
+#include "interrupt.h"
+#include "stddef.h"
+#include "stdint.h"
+
+#ifndef FPU_LAZY
+#    define FPU_LAZY 0
+#endif
+
+#define FPU_CPU_NONE 0xffffffff // Thread whose state is loaded on no CPU
+
+typedef enum {
+    FPU_FXSAVE,   // Legacy 512-byte image, x87 and SSE only
+    FPU_XSAVE,    // Standard format
+    FPU_XSAVEOPT, // Standard format, skips components unchanged since the last restore
+    FPU_XSAVES,   // Compacted format with the init and modified optimizations
+} fpu_save_mode_t;
+
+struct thread;
+
+/* Pick the save instruction and size the per-thread state from CPUID leaf 0xd, call once on the boot CPU */
+void fpu_init(void);
+
+/* Allocate a state area holding the initial x87, SSE and AVX state, 0 if out of memory */
+uint8_t *fpu_state_alloc(void);
+
+/* Free a state area */
+void fpu_state_free(uint8_t *state);
+
+/* Hand the extended state over from `prev` to `next`, called by schedule() with interrupts off */
+void fpu_switch(struct thread *prev, struct thread *next);
+
+/* #NM handler, loads the current thread's state on its first SIMD use after a switch */
+void fpu_nm_handle(interrupt_frame_t *frame);
+
+/* Let the current context use SIMD registers until kernel_fpu_end(), returns 1 if it may not */
+int kernel_fpu_begin(void);
+
+/* End a kernel_fpu_begin() section and give the registers back to their owner */
+void kernel_fpu_end(void);
+
+#endif // INCLUDE_FPU_H_
@@ -37,6 +37,9 @@ uint64_t alloc_frames_2M(size_t count);
 /* Allocate 1G memory frames */
 uint64_t alloc_frames_1G(size_t count);
 
+/* Returns 1 if a frame lies in a usable region, only those may be passed to free_frame() */
+int frame_is_usable(uint64_t addr);
+
 /* Free a memory frame */
 void free_frame(uint64_t addr);
 
@@ -0,0 +1,70 @@
+/*
+ *
+ *      hrtimer.h
+ *      High-resolution timer header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_HRTIMER_H_
+#define INCLUDE_HRTIMER_H_
+
+#include "rbtree.h"
+#include "spin_lock.h"
+#include "stddef.h"
+#include "stdint.h"
+
+typedef enum {
+    HRTIMER_NORESTART, // Done, the timer stays idle
+    HRTIMER_RESTART,   // Requeue at the expiry the callback set
+} hrtimer_restart_t;
+
+struct hrtimer_base;
+
+typedef struct hrtimer {
+        rb_node_t            node;
+        uint64_t             expires; // nano_time() deadline
+        hrtimer_restart_t (*func)(struct hrtimer *timer);
+        struct hrtimer_base *base;    // Tree the timer is queued on, 0 when not queued
+} hrtimer_t;
+
+typedef struct hrtimer_base {
+        spinlock_t lock;
+        rb_root_t  root;    // Queued timers ordered by expiry
+        hrtimer_t *first;   // Leftmost node, the next to expire
+        hrtimer_t *running; // Callback being run, for hrtimer_cancel()
+        size_t     count;
+        uint32_t   cpu;
+} __attribute__((aligned(64))) hrtimer_base_t;
+
+/* Initialize a high-resolution timer */
+void hrtimer_setup(hrtimer_t *timer, hrtimer_restart_t (*func)(hrtimer_t *timer));
+
+/* Check whether a high-resolution timer is queued */
+int hrtimer_active(const hrtimer_t *timer);
+
+/* Queue a timer on the current CPU for an absolute nano_time() expiry */
+void hrtimer_start(hrtimer_t *timer, uint64_t expires);
+
+/* Push the expiry forward by whole intervals past now, returns the number of intervals */
+uint64_t hrtimer_forward(hrtimer_t *timer, uint64_t now, uint64_t interval);
+
+/* Dequeue a timer without waiting, returns 1 if it was queued */
+int hrtimer_try_cancel(hrtimer_t *timer);
+
+/* Dequeue a timer and wait for a running callback to finish, returns 1 if it was queued */
+int hrtimer_cancel(hrtimer_t *timer);
+
+/* Returns the earliest expiry on the current CPU, 0 if none */
+uint64_t hrtimer_next_expiry(void);
+
+/* Run expired high-resolution timers of the current CPU, called from the timer interrupt */
+void hrtimer_run_expired(void);
+
+/* Set up the per-CPU high-resolution timer trees */
+void hrtimer_init(void);
+
+#endif // INCLUDE_HRTIMER_H_
@@ -0,0 +1,51 @@
+/*
+ *
+ *      idle.h
+ *      CPU idle states header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_IDLE_H_
+#define INCLUDE_IDLE_H_
+
+#include "stdint.h"
+
+#ifndef IDLE_MWAIT
+#    define IDLE_MWAIT 0
+#endif
+
+#define IDLE_STATES_MAX 8 // C-states the governor chooses from
+#define IDLE_EMA_SHIFT  3 // Weight of the newest idle length in the prediction, 1 / 8
+
+typedef struct {
+        uint32_t type;             // C-state number, 1 for C1
+        uint32_t hint;             // MWAIT EAX, target C-state - 1 in bits 7:4 and the sub-state in bits 3:0
+        uint32_t exit_latency;     // Microseconds to leave the state
+        uint32_t target_residency; // Shortest idle period in microseconds worth entering the state for
+} idle_state_t;
+
+typedef struct {
+        volatile uint32_t wake;      // Monitored line, another CPU writes it to end MWAIT
+        volatile uint32_t polling;   // Waiting in MWAIT, a write to `wake` is enough to wake this CPU
+        uint64_t          predicted; // Moving average of measured idle periods in nanoseconds
+        uint64_t          wakeups;   // Wakeups done by a write to `wake` instead of an IPI
+        uint64_t          usage[IDLE_STATES_MAX];
+} __attribute__((aligned(64))) idle_cpu_t;
+
+/* Pick the idle instruction and C-states from CPUID and ACPI _CST, call once after smp_init() */
+void idle_init(void);
+
+/* Idle the current CPU until an interrupt or a wake flag write, called with interrupts off, returns with them on */
+void idle_enter(void);
+
+/* Stop taking flag wakeups for the current CPU, called by schedule() when an interrupt switches away from idle_enter() */
+void idle_exit(void);
+
+/* Wake a CPU waiting in MWAIT by writing its flag, returns 1 if it is not waiting there and needs an IPI */
+int idle_wake_cpu(uint32_t cpu);
+
+#endif // INCLUDE_IDLE_H_
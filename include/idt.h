@@ -52,6 +52,10 @@
 #define IRQ_14 46 // IDE0 transmission control usage
 #define IRQ_15 47 // IDE1 transmission control usage
 
+#define IDT_VECTORS              256  // Gates in the IDT
+#define IDT_VECTOR_DYNAMIC_FIRST 0x30 // First vector idt_alloc_vector() hands out, right after the legacy IRQs
+#define IDT_VECTOR_DYNAMIC_LAST  0xef // Last one, the vectors above stay with the local APIC
+
 typedef struct {
         uint16_t size;
         void    *ptr;
@@ -83,4 +87,10 @@ void init_idt(void);
 /* Register an interrupt handler */
 void register_interrupt_handler(uint16_t vector, void *handler, uint8_t ist, uint8_t flags);
 
+/* Allocate a free device vector and install `handler` on it (0 keeps irq_dispatch()), returns 0 if none is left */
+uint8_t idt_alloc_vector(void *handler);
+
+/* Give a vector from idt_alloc_vector() back and point it at irq_dispatch() again */
+void idt_free_vector(uint8_t vector);
+
 #endif // INCLUDE_IDT_H_
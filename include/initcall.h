@@ -0,0 +1,56 @@
+/*
+ *
+ *      initcall.h
+ *      Leveled initcalls header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_INITCALL_H_
+#define INCLUDE_INITCALL_H_
+
+#include "stdint.h"
+
+#define INITCALL_MAX_DEPS 4
+
+#define INITCALL_ASYNC (1 << 0) // Independent probe, may run on an AP while the level goes on
+
+typedef enum {
+    INITCALL_SUBSYS, // Core subsystems other drivers build on
+    INITCALL_DEVICE, // Bus scans and device probes
+    INITCALL_LATE,   // Users of the probed devices
+    INITCALL_LEVELS,
+} initcall_level_t;
+
+typedef enum {
+    INITCALL_WAITING,
+    INITCALL_RUNNING,
+    INITCALL_DONE,
+} initcall_state_t;
+
+typedef struct initcall {
+        const char               *name;
+        void                      (*func)(void);
+        uint32_t                  level;                   // INITCALL_* level, every lower level finishes first
+        uint32_t                  flags;                   // INITCALL_* flags
+        const char               *deps[INITCALL_MAX_DEPS]; // Names of initcalls of the same level to wait for
+        volatile initcall_state_t state;
+        uint32_t                  cpu;  // CPU it ran on
+        uint64_t                  time; // Nanoseconds it took
+} initcall_t;
+
+/* Register `fn` to run at `level` after the initcalls named in the trailing arguments */
+#define INITCALL(fn, lvl, flg, ...)                                                                        \
+    static initcall_t __initcall_##fn __attribute__((used, section(".initcalls"), aligned(8))) = {          \
+        .name = #fn, .func = (fn), .level = (lvl), .flags = (flg), .deps = {__VA_ARGS__}}
+
+/* Run every initcall of a level, async ones spread over the APs, returns once all have finished */
+void do_initcalls(initcall_level_t level);
+
+/* Print how long each initcall and level took */
+void initcall_report(void);
+
+#endif // INCLUDE_INITCALL_H_
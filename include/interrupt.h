@@ -27,8 +27,13 @@
 #    error "Unknown compiler"
 #endif
 
-/* Empty function handling */
-extern void (*empty_handle[256])(interrupt_frame_t *frame);
+#define IRQ_STUB_SIZE 16 // Bytes per entry stub in irq_entry.s
+
+/* Entry stubs of every vector, each pushes its vector number and enters irq_dispatch() */
+extern uint8_t irq_stubs[];
+
+/* Returns the entry stub of a vector */
+#define irq_entry_stub(vector) ((void *)(irq_stubs + (vector) * IRQ_STUB_SIZE))
 
 /* Register ISR interrupt processing */
 void isr_registe_handle(void);
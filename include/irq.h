@@ -0,0 +1,61 @@
+/*
+ *
+ *      irq.h
+ *      Interrupt dispatch header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_IRQ_H_
+#define INCLUDE_IRQ_H_
+
+#include "idt.h"
+#include "stdint.h"
+
+#define IRQ_NONE        0 // The device of this handler did not interrupt
+#define IRQ_HANDLED     1
+#define IRQ_WAKE_THREAD 2 // Handled, the rest runs in the handler's thread
+
+struct thread;
+
+/* Runs in interrupt context with interrupts off, irq_dispatch() sends the EOI */
+typedef int (*irq_handler_t)(uint8_t vector, void *data);
+
+/* One handler chained on a vector */
+typedef struct irq_action {
+        irq_handler_t      handler;
+        irq_handler_t      thread_fn; // Runs in `thread` after the handler returns IRQ_WAKE_THREAD
+        void              *data;
+        const char        *name;
+        struct thread     *thread;
+        volatile uint32_t  thread_pending; // Set by irq_dispatch(), taken by the thread
+        volatile uint32_t  thread_stop;
+        uint8_t            vector;
+        struct irq_action *next;
+} irq_action_t;
+
+/* Chain a handler onto a vector dispatched by irq_dispatch(), returns 1 if out of memory */
+int irq_request(uint8_t vector, irq_handler_t handler, void *data, const char *name);
+
+/* Chain a handler whose `thread_fn` runs in a thread of its own, a 0 handler always wakes it, returns 1 on failure */
+int irq_request_threaded(uint8_t vector, irq_handler_t handler, irq_handler_t thread_fn, void *data, const char *name);
+
+/* Unchain a handler, returns once no CPU can still be running it */
+void irq_release(uint8_t vector, irq_handler_t handler, void *data);
+
+/* Allocate a free vector and chain a handler onto it, returns 0 if none is left */
+uint8_t irq_alloc_vector(irq_handler_t handler, void *data, const char *name);
+
+/* Unchain the handler of a vector from irq_alloc_vector() and give the vector back */
+void irq_free_vector(uint8_t vector, irq_handler_t handler, void *data);
+
+/* Returns how often a vector was dispatched, summed over all CPUs */
+uint64_t irq_vector_count(uint8_t vector);
+
+/* Entered from the stubs of irq_entry.s, runs the handlers chained on a vector */
+void irq_dispatch(uint64_t vector, interrupt_frame_t *frame);
+
+#endif // INCLUDE_IRQ_H_
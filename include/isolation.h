@@ -0,0 +1,32 @@
+/*
+ *
+ *      isolation.h
+ *      CPU isolation header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_ISOLATION_H_
+#define INCLUDE_ISOLATION_H_
+
+#include "cpumask.h"
+#include "stdint.h"
+
+#define ISOLATION_ARG_MAX 128 // Longest isolcpus= list taken from the command line
+
+/* Read isolcpus= from the command line, call once after smp_init() and before sched_init() */
+void isolation_init(void);
+
+/* Check whether a CPU was isolated on the command line */
+int cpu_isolated(uint32_t cpu);
+
+/* Returns the CPUs left for the tick, unbound work, timers and device interrupts */
+const cpumask_t *housekeeping_mask(void);
+
+/* Returns the current CPU, or the nearest housekeeping CPU if the current one is isolated */
+uint32_t housekeeping_cpu(void);
+
+#endif // INCLUDE_ISOLATION_H_
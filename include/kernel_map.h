@@ -0,0 +1,32 @@
+/*
+ *
+ *      kernel_map.h
+ *      Kernel image mapping header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_KERNEL_MAP_H_
+#define INCLUDE_KERNEL_MAP_H_
+
+#include "stdint.h"
+
+/* Segment boundaries exported by assets/linker.ld */
+extern char __kernel_start[];
+extern char __text_start[];
+extern char __rodata_start[];
+extern char __data_start[];
+extern char __kernel_end[];
+
+#define KERNEL_MAP_PROBE_PAGES 16 // Pages spanned by the stubs in kernel_map_probe.s, keep the .rept count in sync
+
+/* One `ret` stub at the start of each probe page (kernel_map_probe.s) */
+extern uint8_t kernel_map_probe[];
+
+/* Rebuild the kernel image mapping with 2 MiB pages and per-segment W^X */
+void kernel_map_init(void);
+
+#endif // INCLUDE_KERNEL_MAP_H_
@@ -20,7 +20,11 @@
 #define PTE_PRESENT      (0x1 << 0)
 #define PTE_WRITEABLE    (0x1 << 1)
 #define PTE_USER         (0x1 << 2)
+#define PTE_PWT          (0x1 << 3)  // PAT index bit 0
+#define PTE_PCD          (0x1 << 4)  // PAT index bit 1
+#define PTE_PAT          (0x1 << 7)  // PAT index bit 2 (4K pages)
 #define PTE_HUGE         (0x1 << 7)
+#define PTE_HUGE_PAT     (0x1 << 12) // PAT index bit 2 (2M/1G pages)
 #define PTE_NO_EXECUTE   (((uint64_t)0x1) << 63)
 #define KERNEL_PTE_FLAGS (PTE_PRESENT | PTE_WRITEABLE | PTE_NO_EXECUTE)
 
@@ -31,6 +35,19 @@
 #define HUGE_1G_SIZE      0x40000000
 #define HUGE_PAGE_1G_MASK 0x000fffffc0000000
 
+/* PAT entries 0-7: WB WT UC- UC WB WT WC WP, 0-5 keep their power-on types so mappings made before pat_init() keep theirs */
+#define PAT_LAYOUT 0x0501040600070406
+
+/* Memory types, the value is the PAT index selected by the PTE */
+typedef enum {
+    MEMORY_TYPE_WB       = 0,
+    MEMORY_TYPE_WT       = 1,
+    MEMORY_TYPE_UC_MINUS = 2,
+    MEMORY_TYPE_UC       = 3,
+    MEMORY_TYPE_WC       = 6, // Only PAT entries 6 and 7 are free to reprogram
+    MEMORY_TYPE_WP       = 7,
+} memory_type_t;
+
 typedef struct {
         uint64_t value;
 } page_table_entry_t;
@@ -112,6 +129,12 @@ void page_map_range_to_random(page_directory_t *directory, uint64_t addr, uint64
 /* Get the PAT configuration */
 pat_config_t get_pat_config(void);
 
+/* Program the PAT layout on the current CPU */
+void pat_init(void);
+
+/* Change the memory type of a kernel virtual range */
+int set_memory_type(uint64_t addr, uint64_t length, memory_type_t type);
+
 /* Initialize memory page table */
 void page_init(void);
 
@@ -0,0 +1,46 @@
+/*
+ *
+ *      parallel_for.h
+ *      Fork-join parallel loops header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_PARALLEL_FOR_H_
+#define INCLUDE_PARALLEL_FOR_H_
+
+#include "spin_lock.h"
+#include "stdint.h"
+
+#define PFOR_DEQUE_SIZE 64 // Ranges one participant can hold, 2^64 iterations split in halves need at most 64
+
+typedef void (*parallel_for_fn_t)(uint64_t start, uint64_t end, void *arg);
+
+typedef struct {
+        uint64_t start;
+        uint64_t end;
+} pfor_range_t;
+
+typedef struct {
+        spinlock_t   lock;
+        uint32_t     top;    // Thieves take the oldest, largest range here
+        uint32_t     bottom; // The owner pushes and pops here
+        pfor_range_t ranges[PFOR_DEQUE_SIZE];
+} __attribute__((aligned(64))) pfor_deque_t;
+
+/* Start a helper thread on every housekeeping CPU, call once after workqueue_init() */
+void parallel_for_init(void);
+
+/* Run fn over [start, end) in chunks of at least `grain` iterations on every helper and the caller, returns when all are done */
+void parallel_for(uint64_t start, uint64_t end, uint64_t grain, parallel_for_fn_t fn, void *arg);
+
+/* Cap the helpers joining the caller of parallel_for(), 0 runs every loop on the caller alone, returns the previous cap */
+uint32_t parallel_for_set_helpers(uint32_t helpers);
+
+/* Returns the number of helper threads */
+uint32_t parallel_for_helpers(void);
+
+#endif // INCLUDE_PARALLEL_FOR_H_
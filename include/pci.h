@@ -13,6 +13,7 @@
 #define INCLUDE_PCI_H_
 
 #include "acpi.h"
+#include "irq.h"
 #include "stddef.h"
 #include "stdint.h"
 
@@ -25,6 +26,18 @@
 #define PCI_CONF_REVISION    0x8  // Revision ID
 #define PCI_CONF_HEADER_TYPE 0xe  // Header Type
 #define PCI_CONF_BAR0        0x10 // Base Address Register 0
+#define PCI_CONF_CAP_PTR     0x34 // Capabilities Pointer
+#define PCI_CONF_CARDBUS_CAP 0x14 // Capabilities Pointer of a CardBus bridge
+
+#define PCI_COMMAND_MEMORY       (1 << 1)  // Command register, memory space decoding
+#define PCI_COMMAND_MASTER       (1 << 2)  // Command register, bus mastering, which message writes need
+#define PCI_COMMAND_INTX_DISABLE (1 << 10) // Command register, no legacy INTx assertion
+#define PCI_STATUS_CAP_LIST      (1 << 4)  // Status register, a capability list is present
+
+#define PCI_CAP_ID_MSI  0x05 // Message Signaled Interrupts
+#define PCI_CAP_ID_MSIX 0x11 // MSI-X
+
+#define PCI_IRQ_MAX_VECTORS 32 // Vectors one pci_irq_t may hold
 
 #define PCI_COMMAND_PORT 0xCF8
 #define PCI_DATA_PORT    0xCFC
@@ -78,6 +91,25 @@ typedef struct {
         uint32_t            offset;
 } pci_device_reg_t;
 
+typedef enum {
+    PCI_IRQ_INTX, // Legacy pin through the I/O APIC
+    PCI_IRQ_MSI,  // One MSI message
+    PCI_IRQ_MSIX, // One MSI-X table entry per vector
+} pci_irq_mode_t;
+
+/* Message signaled vectors of a device, one per queue */
+typedef struct {
+        pci_device_cache_t *device;
+        pci_irq_mode_t      mode;
+        uint32_t            cap;                          // Config offset of the MSI or MSI-X capability
+        uint32_t            count;                        // Vectors in use
+        volatile uint32_t  *table;                        // MSI-X table, 4 dwords per entry
+        irq_handler_t       handler;                      // Chained on every queue's vector
+        uint8_t             vectors[PCI_IRQ_MAX_VECTORS]; // IDT vector of each queue
+        uint32_t            cpus[PCI_IRQ_MAX_VECTORS];    // CPU each queue is delivered to
+        void               *data[PCI_IRQ_MAX_VECTORS];    // Handler argument of each queue
+} pci_irq_t;
+
 typedef struct {
         pci_device_cache_t *head;
         size_t              devices_count;
@@ -165,6 +197,18 @@ uint32_t read_bar_n(pci_device_cache_t *device, uint32_t bar_n);
 /* Get the interrupt number of the PCI device */
 uint32_t pci_get_irq(pci_device_cache_t *device);
 
+/* Returns the config offset of a capability, 0 if the device does not have it */
+uint32_t pci_find_capability(pci_device_cache_t *device, uint8_t id);
+
+/* Allocate up to `count` vectors over MSI-X, else one over MSI, queue i on CPU i with argument data[i], returns the number set up */
+uint32_t pci_alloc_irq_vectors(pci_irq_t *irq, pci_device_cache_t *device, uint32_t count, irq_handler_t handler, void **data);
+
+/* Deliver one queue's vector to another CPU, returns 1 if the queue or CPU is invalid */
+int pci_irq_set_affinity(pci_irq_t *irq, uint32_t queue, uint32_t cpu);
+
+/* Turn message signaled interrupts off, free the vectors and give the device its INTx pin back */
+void pci_free_irq_vectors(pci_irq_t *irq);
+
 /* Configuring PCI Devices */
 void pci_config(pci_device_cache_t *cache, uint32_t addr);
 
@@ -189,10 +233,13 @@ void pci_free_devices_cache(void);
 /* Flush the PCI devices cache and update the responses of each `pci_finding_request` */
 void pci_flush_devices_cache(void);
 
-/* Found PCI devices cache by vender ID and device ID */
+/* Scan every bus without touching the cache, returns the number of functions found */
+uint32_t pci_count_devices(void);
+
+/* Found PCI devices cache by vender ID and device ID, call under rcu_read_lock(), the node stays valid until rcu_read_unlock() */
 pci_device_cache_t *pci_found_device_cache(pci_device_cache_t *start, pci_device_request_t device_req);
 
-/* Found PCI devices cache by class code */
+/* Found PCI devices cache by class code, call under rcu_read_lock(), the node stays valid until rcu_read_unlock() */
 pci_device_cache_t *pci_found_class_cache(pci_device_cache_t *start, pci_class_request_t class_req);
 
 /* PCI device initialization */
@@ -0,0 +1,90 @@
+/*
+ *
+ *      percpu.h
+ *      Per-CPU data area header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_PERCPU_H_
+#define INCLUDE_PERCPU_H_
+
+#include "gdt.h"
+#include "idt.h"
+#include "rwlock.h"
+#include "spin_lock.h"
+#include "stddef.h"
+#include "stdint.h"
+
+#define MSR_IA32_GS_BASE 0xc0000101
+
+#define KERNEL_STACK_SIZE 0x10000 // 64 KiB
+
+#define IOAPIC_MAX_PINS 24 // Redirection entries with affinity and per-CPU interrupt counts
+
+typedef uint8_t kernel_stack_t[KERNEL_STACK_SIZE];
+
+/* Data owned by one CPU, IA32_GS_BASE points at it */
+typedef struct percpu {
+        struct percpu   *self;                                // Linear address of this area (%gs:0)
+        uint64_t         cpu_id;
+        uint64_t         lapic_id;
+        gdt_t           *gdt;
+        tss_t           *tss;
+        tss_stack_t     *tss_stack;
+        kernel_stack_t  *kernel_stack;
+        uint64_t         ipi_count;                           // IPIs received
+        uint64_t         tlb_flush_count;                     // TLB shootdowns served
+        struct thread   *current_thread;                      // Thread running on this CPU
+        struct thread   *prev_thread;                         // Thread switched away from, until the switch completes
+        struct runqueue *runqueue;                            // Ready threads of this CPU
+        uint64_t         tick_deadline;                       // nano_time() the timer is programmed for, 0 when stopped
+        uint64_t         tick_sched_next;                     // Next scheduler tick, 0 while the tick is stopped
+        uint64_t         timer_irqs;                          // Timer interrupts taken
+        uint64_t         spin_qnode_depth;                    // Queue nodes in use by contended spin_lock() calls
+        spin_qnode_t     spin_qnodes[SPIN_QNODE_NEST];        // Spinlock queue nodes of this CPU
+        int32_t          rwlock_readers[RWLOCK_PERCPU_SLOTS]; // Reader counts of the rwlocks with a slot
+        uint64_t         preempt_count;                       // Nested preempt_disable() sections on this CPU
+        struct smp_call *volatile call_queue;                 // Cross-CPU calls queued for this CPU, newest first
+        uint64_t         call_count;                          // Cross-CPU calls run
+        uint64_t         rcu_qs_seq;                          // Last grace period this CPU passed a quiescent state in
+        struct thread   *fpu_owner;                           // Thread whose extended state the registers hold, lazy switching only
+        uint8_t         *fpu_kernel_state;                    // Registers saved by kernel_fpu_begin()
+        uint64_t         kernel_fpu;                          // KERNEL_FPU_* state of the section running on this CPU
+        uint64_t         irq_counts[IOAPIC_MAX_PINS];         // Device interrupts taken, per IOAPIC pin
+        uint64_t         irq_vector_counts[IDT_VECTORS];      // Interrupts taken through irq_dispatch(), per vector
+        uint64_t         softirq_pending;                     // Bit per softirq_nr_t raised on this CPU
+        uint64_t         softirq_active;                      // Softirqs are running, nested interrupt exits leave them alone
+        uint64_t         softirq_runs;                        // Softirq handlers run
+        uint64_t         softirq_deferred;                    // Interrupt exits that left work to ksoftirqd
+        struct thread   *ksoftirqd;                           // Runs the softirqs interrupt exits did not get to
+} __attribute__((aligned(64))) percpu_t;
+
+/* A field of the current CPU's area, as a %gs-relative lvalue */
+#define this_cpu_var(field) (*(__seg_gs __typeof__(((percpu_t *)0)->field) *)offsetof(percpu_t, field))
+
+/* Read a field of the current CPU's area */
+#define this_cpu_read(field) (this_cpu_var(field))
+
+/* Write a field of the current CPU's area */
+#define this_cpu_write(field, value) (this_cpu_var(field) = (value))
+
+/* Increment a 64-bit counter of the current CPU's area, safe against interrupts */
+#define this_cpu_inc(field) __asm__ volatile("incq %%gs:%c0" ::"i"(offsetof(percpu_t, field)) : "memory")
+
+/* Decrement a 64-bit counter of the current CPU's area, safe against interrupts */
+#define this_cpu_dec(field) __asm__ volatile("decq %%gs:%c0" ::"i"(offsetof(percpu_t, field)) : "memory")
+
+/* Returns the current CPU's area */
+#define this_cpu() (this_cpu_read(self))
+
+/* Returns the boot CPU's area */
+percpu_t *get_bsp_percpu(void);
+
+/* Point IA32_GS_BASE of the current CPU at its area, call after every GS reload */
+void percpu_init(percpu_t *cpu);
+
+#endif // INCLUDE_PERCPU_H_
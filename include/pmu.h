@@ -0,0 +1,40 @@
+/*
+ *
+ *      pmu.h
+ *      Performance monitoring unit header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_PMU_H_
+#define INCLUDE_PMU_H_
+
+#include "stdint.h"
+
+#define MSR_IA32_PMC0             0x0c1
+#define MSR_IA32_PERFEVTSEL0      0x186
+#define MSR_IA32_PERF_GLOBAL_CTRL 0x38f
+
+#define PMU_EVTSEL_USR (1 << 16)
+#define PMU_EVTSEL_OS  (1 << 17)
+#define PMU_EVTSEL_EN  (1 << 22)
+
+#define PMU_EVENT_ITLB_MISSES        0x85 // ITLB_MISSES
+#define PMU_UMASK_ITLB_WALK_COMPLETE 0x0e // .WALK_COMPLETED (Skylake and later)
+
+/* Detect the architectural PMU, returns the number of general counters */
+uint32_t pmu_init(void);
+
+/* Start counting an event in kernel mode on a general counter */
+void pmu_start(uint32_t counter, uint8_t event, uint8_t umask);
+
+/* Stop a general counter */
+void pmu_stop(uint32_t counter);
+
+/* Read a general counter */
+uint64_t pmu_read(uint32_t counter);
+
+#endif // INCLUDE_PMU_H_
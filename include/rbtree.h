@@ -0,0 +1,66 @@
+/*
+ *
+ *      rbtree.h
+ *      Augmented red-black tree header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_RBTREE_H_
+#define INCLUDE_RBTREE_H_
+
+#include "stddef.h"
+
+#define RB_RED   0
+#define RB_BLACK 1
+
+#define rb_entry(ptr, type, member) ((type *)((char *)(ptr) - offsetof(type, member)))
+
+typedef struct rb_node {
+        struct rb_node *parent;
+        struct rb_node *left;
+        struct rb_node *right;
+        int             color;
+} rb_node_t;
+
+typedef struct {
+        rb_node_t *node;
+} rb_root_t;
+
+/* Recompute the value cached in `node` from its own key and its children (0 for plain trees) */
+typedef void (*rb_augment_t)(rb_node_t *node);
+
+/* Initialize a red-black tree root */
+void rb_root_init(rb_root_t *root);
+
+/* Check if a red-black tree is empty */
+int rb_empty(const rb_root_t *root);
+
+/* Link a new node at the position found by a caller-side descent */
+void rb_link_node(rb_node_t *node, rb_node_t *parent, rb_node_t **link);
+
+/* Rebalance after rb_link_node(), keeping augmented values in sync */
+void rb_insert_color(rb_root_t *root, rb_node_t *node, rb_augment_t augment);
+
+/* Remove a node from the tree, keeping augmented values in sync */
+void rb_erase(rb_root_t *root, rb_node_t *node, rb_augment_t augment);
+
+/* Recompute augmented values from a node up to the root */
+void rb_propagate(rb_node_t *node, rb_augment_t augment);
+
+/* Returns the leftmost node of the tree */
+rb_node_t *rb_first(const rb_root_t *root);
+
+/* Returns the rightmost node of the tree */
+rb_node_t *rb_last(const rb_root_t *root);
+
+/* Returns the in-order successor */
+rb_node_t *rb_next(const rb_node_t *node);
+
+/* Returns the in-order predecessor */
+rb_node_t *rb_prev(const rb_node_t *node);
+
+#endif // INCLUDE_RBTREE_H_
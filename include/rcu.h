@@ -0,0 +1,65 @@
+/*
+ *
+ *      rcu.h
+ *      Read-copy-update header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_RCU_H_
+#define INCLUDE_RCU_H_
+
+#include "double_list.h"
+#include "sched.h"
+#include "stdint.h"
+
+struct rcu_head;
+
+typedef void (*rcu_callback_t)(struct rcu_head *head);
+
+/* Embedded in an object retired with call_rcu() */
+typedef struct rcu_head {
+        struct rcu_head *next;
+        rcu_callback_t   func;
+} rcu_head_t;
+
+/* Enter a read-side critical section, it must not block */
+#define rcu_read_lock() preempt_disable()
+
+/* Leave a read-side critical section */
+#define rcu_read_unlock() preempt_enable()
+
+/* Load an RCU-protected pointer inside a read-side critical section */
+#define rcu_dereference(ptr) __atomic_load_n(&(ptr), __ATOMIC_CONSUME)
+
+/* Publish an initialized object through an RCU-protected pointer */
+#define rcu_assign_pointer(ptr, value) __atomic_store_n(&(ptr), (value), __ATOMIC_RELEASE)
+
+/* Walk a list under rcu_read_lock() while writers insert and remove with the _rcu helpers */
+#define ilist_for_each_rcu(pos, head) for ((pos) = ilist_next_rcu(head); (pos) != (head); (pos) = ilist_next_rcu(pos))
+
+/* Run `func` once every CPU has passed a quiescent state, callable from interrupt handlers */
+void call_rcu(rcu_head_t *head, rcu_callback_t func);
+
+/* Wait until every read-side critical section running at the call has finished */
+void synchronize_rcu(void);
+
+/* Report a quiescent state of the current CPU, the caller holds no RCU references */
+void rcu_qs(void);
+
+/* Report the quiescent state of an idle CPU right before it halts, interrupts must be off */
+void rcu_idle_enter(void);
+
+/* Scheduler tick hook, reports a quiescent state and moves this CPU's callbacks on */
+void rcu_tick(void);
+
+/* Check whether the current CPU has callbacks and must keep its tick */
+int rcu_needs_cpu(void);
+
+/* Set up the per-CPU callback lists, needs the workqueues */
+void rcu_init(void);
+
+#endif // INCLUDE_RCU_H_
@@ -0,0 +1,46 @@
+/*
+ *
+ *      rwlock.h
+ *      Reader-writer lock header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_RWLOCK_H_
+#define INCLUDE_RWLOCK_H_
+
+#include "spin_lock.h"
+#include "stdint.h"
+
+#define RWLOCK_PERCPU_SLOTS 16         // Locks with per-CPU reader counts, later ones share one counter
+#define RWLOCK_SLOT_SHARED  0xffffffff // Slot value of a lock counting readers in `readers`
+
+typedef struct {
+        volatile uint32_t writer;  // 1 while a writer holds the lock or waits for readers to leave
+        volatile uint32_t slot;    // Per-CPU reader count index + 1, 0 until first use
+        volatile int32_t  readers; // Reader count of a lock without a per-CPU slot
+        spinlock_t        wlock;   // Serializes writers
+} rwlock_t;
+
+/* Static initializer of a lock, `lock_class` tracks the writers and may be 0 */
+#define RWLOCK_INIT(lock_class) {.writer = 0, .slot = 0, .readers = 0, .wlock = SPINLOCK_INIT(lock_class)}
+
+/* Initialize a reader-writer lock at runtime, `class` may be 0 */
+void rwlock_init(rwlock_t *lock, spin_lock_class_t *class);
+
+/* Lock for reading with preemption disabled, waits while a writer holds or wants the lock */
+void read_lock(rwlock_t *lock);
+
+/* Unlock after reading and enable preemption again */
+void read_unlock(rwlock_t *lock);
+
+/* Lock for writing, new readers back off and current ones drain */
+void write_lock(rwlock_t *lock);
+
+/* Unlock after writing */
+void write_unlock(rwlock_t *lock);
+
+#endif // INCLUDE_RWLOCK_H_
@@ -0,0 +1,157 @@
+/*
+ *
+ *      sched.h
+ *      Kernel thread scheduler header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_SCHED_H_
+#define INCLUDE_SCHED_H_
+
+#include "cpumask.h"
+#include "double_list.h"
+#include "hrtimer.h"
+#include "percpu.h"
+#include "rbtree.h"
+#include "spin_lock.h"
+#include "stddef.h"
+#include "stdint.h"
+
+#define THREAD_STACK_SIZE 0x4000 // 16 KiB
+#define SCHED_TIMESLICE   2      // LAPIC ticks (4 ms each) before a thread is preempted
+
+#define THREAD_PINNED (1 << 0) // Never migrated by work stealing
+
+#define SCHED_DL_BW_SHIFT 20                                  // Fraction bits of a deadline bandwidth
+#define SCHED_DL_BW_MAX   ((95ULL << SCHED_DL_BW_SHIFT) / 100) // Share of each CPU the deadline class may reserve
+#define SCHED_DL_MIN_NS   10000                               // Shortest runtime, budgets are enforced by hrtimer
+#define SCHED_DL_MAX_NS   ((uint64_t)1000000000 * 10)         // Longest period
+
+/* Keep the current thread on this CPU until preempt_enable(), it must not block meanwhile */
+#define preempt_disable() this_cpu_inc(preempt_count)
+
+/* End a preempt_disable() section, a preemption skipped meanwhile happens at the next tick */
+#define preempt_enable() this_cpu_dec(preempt_count)
+
+typedef enum {
+    SD_SMT,     // Threads of one core
+    SD_LLC,     // Cores sharing the last level cache
+    SD_PACKAGE, // Cores of one package
+    SD_SYSTEM,  // Every CPU
+    SD_LEVELS,
+} sched_domain_level_t;
+
+typedef enum {
+    SCHED_NORMAL,   // Round robin in FIFO order, runs when no deadline thread is ready
+    SCHED_DEADLINE, // Earliest deadline first with a constant bandwidth server per thread
+} sched_policy_t;
+
+typedef struct {
+        uint64_t runtime;  // Nanoseconds of CPU time reserved every period
+        uint64_t deadline; // Nanoseconds from the start of a period by which the runtime is delivered
+        uint64_t period;   // Nanoseconds between activations
+} sched_attr_t;
+
+typedef enum {
+    THREAD_READY,
+    THREAD_RUNNING,
+    THREAD_BLOCKED,
+    THREAD_DEAD,
+} thread_state_t;
+
+typedef struct thread {
+        uint64_t                rsp;     // Saved stack pointer, switch.s relies on this being first
+        uint64_t                tid;     // Thread ID
+        volatile thread_state_t state;   // THREAD_* state
+        volatile uint32_t       on_cpu;  // Still running on some CPU, must not be stolen
+        uint32_t                asleep;  // Switched out while blocked, a wakeup has to queue it
+        uint32_t                cpu;     // Run queue that owns the thread
+        uint32_t                slice;   // Ticks left in the current time slice
+        uint32_t                flags;   // THREAD_* flags
+        uint64_t                runtime; // Ticks spent running
+        void (*entry)(void *arg);
+        void        *arg;
+        uint8_t     *stack;
+        const char  *name;
+        ilist_node_t run_node;
+        uint8_t     *fpu_state; // Extended state area, sized by fpu_init()
+        uint32_t     fpu_cpu;   // CPU whose registers last loaded fpu_state, lazy switching only
+
+        sched_policy_t policy;        // SCHED_* class
+        sched_attr_t   dl;            // Deadline class reservation
+        uint64_t       dl_bw;         // runtime / period, SCHED_DL_BW_SHIFT fraction bits
+        uint64_t       dl_abs;        // Absolute deadline of the current period
+        int64_t        dl_budget;     // Runtime left in the current period, negative after an overrun
+        uint64_t       dl_exec_start; // nano_time() the budget was last charged up to
+        int            dl_throttled;  // Out of budget, off the run queue until dl_timer replenishes it
+        int            dl_yielded;    // Gave up the rest of the period with thread_yield()
+        uint32_t       dl_pinned;     // THREAD_PINNED as it was before the thread entered the deadline class
+        rb_node_t      dl_node;
+        hrtimer_t      dl_timer; // Replenishes the budget at the start of the next period
+
+        struct co_sched *co; // Coroutine executor co_run() is running on this thread, 0 outside it
+} __attribute__((aligned(64))) thread_t;
+
+typedef struct runqueue {
+        spinlock_t      lock;
+        ilist_node_t    ready;       // Ready threads, run in FIFO order
+        volatile size_t nr_ready;    // Read without the lock by work stealing
+        uint32_t        cpu;
+        thread_t       *idle;        // Runs when nothing else is ready
+        volatile int    tickless;    // Scheduler tick stopped, idle or isolated with one thread, needs a kick for new work
+        uint64_t        switches;    // Context switches done on this CPU
+        uint64_t        steals;      // Threads pulled from other CPUs
+        rb_root_t       dl_root;     // Ready deadline threads by absolute deadline, counted in nr_ready
+        thread_t       *dl_first;    // Earliest deadline, runs before any normal thread
+        uint32_t        nr_deadline; // Ready deadline threads
+        uint64_t        dl_bw;       // Bandwidth admitted on this CPU
+        hrtimer_t       dl_enforce;  // Expires when the running deadline thread has used up its budget
+        uint32_t        nr_domains;
+        uint32_t        domain_level[SD_LEVELS]; // SD_* level of each domain
+        cpumask_t       domains[SD_LEVELS];      // Nested CPU spans to balance over, nearest first
+} __attribute__((aligned(64))) runqueue_t;
+
+/* Returns the thread running on the current CPU */
+thread_t *get_current_thread(void);
+
+/* Create a kernel thread and queue it on the least loaded CPU */
+thread_t *thread_create(const char *name, void (*entry)(void *arg), void *arg);
+
+/* Create a kernel thread with THREAD_* flags and queue it on the given CPU */
+thread_t *thread_create_on(const char *name, void (*entry)(void *arg), void *arg, uint32_t cpu, uint32_t flags);
+
+/* Make a blocked thread runnable again, returns 1 if it was not blocked */
+int thread_wakeup(thread_t *thread);
+
+/* Check whether the current context may block */
+int thread_can_sleep(void);
+
+/* Move the current thread into the deadline class on its CPU, or back with a zero runtime, returns 1 if rejected */
+int sched_set_deadline(const sched_attr_t *attr);
+
+/* Give up the rest of the time slice, or of the period for a deadline thread */
+void thread_yield(void);
+
+/* Terminate the current thread */
+void thread_exit(void) __attribute__((noreturn));
+
+/* Pick the next thread and switch to it */
+void schedule(void);
+
+/* Timer tick on the current CPU, called from the timer interrupt */
+void sched_tick(void);
+
+/* Returns the run queue of a CPU */
+runqueue_t *sched_runqueue(uint32_t cpu);
+
+/* Attach an application processor to the scheduler and run its idle loop */
+void sched_ap_entry(void) __attribute__((noreturn));
+
+/* Initialize the scheduler, the caller becomes the first thread */
+void sched_init(void);
+
+#endif // INCLUDE_SCHED_H_
@@ -0,0 +1,59 @@
+/*
+ *
+ *      seqlock.h
+ *      Sequence counter and sequence lock header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_SEQLOCK_H_
+#define INCLUDE_SEQLOCK_H_
+
+#include "spin_lock.h"
+#include "stdint.h"
+
+/* Odd while a write is in progress, readers retry if it changed under them */
+typedef struct {
+        volatile uint32_t sequence;
+} seqcount_t;
+
+/* Sequence counter with a lock serializing the writers */
+typedef struct {
+        seqcount_t seqcount;
+        spinlock_t lock;
+} seqlock_t;
+
+/* Static initializer of a sequence lock, `lock_class` may be 0 */
+#define SEQLOCK_INIT(lock_class) {.seqcount = {0}, .lock = SPINLOCK_INIT(lock_class)}
+
+/* Start a read section, waits out a write in progress, returns the sequence to check */
+uint32_t read_seqcount_begin(const seqcount_t *seqcount);
+
+/* Returns 1 if a write happened since read_seqcount_begin() and the read must be repeated */
+int read_seqcount_retry(const seqcount_t *seqcount, uint32_t start);
+
+/* Start a write, the caller excludes other writers and readers on this CPU */
+void write_seqcount_begin(seqcount_t *seqcount);
+
+/* Finish a write */
+void write_seqcount_end(seqcount_t *seqcount);
+
+/* Initialize a sequence lock at runtime, `class` may be 0 */
+void seqlock_init(seqlock_t *seqlock, spin_lock_class_t *class);
+
+/* Start a read section of a sequence lock */
+uint32_t read_seqbegin(const seqlock_t *seqlock);
+
+/* Returns 1 if the read section of a sequence lock must be repeated */
+int read_seqretry(const seqlock_t *seqlock, uint32_t start);
+
+/* Lock for writing with interrupts off, returns the previous RFLAGS */
+uint64_t write_seqlock_irqsave(seqlock_t *seqlock);
+
+/* Unlock after writing and restore the interrupt flag */
+void write_sequnlock_irqrestore(seqlock_t *seqlock, uint64_t flags);
+
+#endif // INCLUDE_SEQLOCK_H_
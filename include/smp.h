@@ -12,26 +12,29 @@
 #ifndef INCLUDE_SMP_H_
 #define INCLUDE_SMP_H_
 
-#include "gdt.h"
+#include "cpumask.h"
 #include "limine.h"
+#include "percpu.h"
 #include "stdint.h"
 
-#define KERNEL_STACK_SIZE 0x10000 // 64 KiB
+typedef struct {
+        uint64_t  id;
+        uint64_t  lapic_id;
+        percpu_t *percpu; // Stacks, TSS and counters of this CPU
+} cpu_processor_t;
 
-#ifndef CPU_MAX_COUNT
-#    define CPU_MAX_COUNT 0
-#endif
+#define SMP_CALL_WAIT (1 << 0) // The sender waits for the function to return
 
-typedef uint8_t kernel_stack_t[KERNEL_STACK_SIZE];
+typedef void (*smp_call_func_t)(void *info);
 
-typedef struct {
-        uint64_t        id;
-        uint64_t        lapic_id;
-        gdt_t          *gdt;
-        tss_stack_t    *tss_stack;
-        tss_t          *tss;
-        kernel_stack_t *kernel_stack;
-} cpu_processor_t;
+/* A function call queued for another CPU, one slot per sender and target */
+typedef struct smp_call {
+        struct smp_call  *next;   // Next call in the target's queue
+        smp_call_func_t   func;
+        void             *info;
+        uint32_t          flags;  // SMP_CALL_* flags
+        volatile uint32_t locked; // Queued or running, the sender must not reuse it yet
+} __attribute__((aligned(64))) smp_call_t;
 
 /* Send an IPI to all CPUs */
 void send_ipi_all(uint8_t vector);
@@ -39,6 +42,21 @@ void send_ipi_all(uint8_t vector);
 /* Send an IPI to the specified CPU */
 void send_ipi_cpu(uint32_t cpu_id, uint8_t vector);
 
+/* Ask another CPU to reschedule, one waiting in MWAIT is woken by a flag write instead of an IPI */
+void smp_send_reschedule(uint32_t cpu_id);
+
+/* Reschedule the current CPU as soon as it enables interrupts, for a preemption decided with them off */
+void smp_send_reschedule_self(void);
+
+/* Run a function on a CPU with interrupts off, waiting for it if `wait` is set, returns 1 for a bad CPU */
+int smp_call_function_single(uint32_t cpu_id, smp_call_func_t func, void *info, int wait);
+
+/* Run a function on every other CPU set in `mask` (0 for all) with interrupts off, waiting for all if `wait` is set */
+void smp_call_function_many(const cpumask_t *mask, smp_call_func_t func, void *info, int wait);
+
+/* Run a function on every CPU, the current one included, waiting for all if `wait` is set */
+void smp_call_function_all(smp_call_func_t func, void *info, int wait);
+
 /* Flush TLBs of all CPUs */
 void flush_tlb_all(void);
 
@@ -51,10 +69,16 @@ uint32_t get_cpu_count(void);
 /* Get the ID of the current CPU */
 uint32_t get_current_cpu_id(void);
 
+/* Returns the per-CPU area of a CPU, the boot CPU's until SMP is up */
+percpu_t *get_cpu_percpu(uint32_t cpu_id);
+
 /* Multi-core boot entry */
 void ap_entry(struct limine_smp_info *info);
 
-/* Initializing Symmetric Multi-Processing */
+/* Initializing Symmetric Multi-Processing, releases the APs without waiting for them */
 void smp_init(void);
 
+/* Wait until every AP has its local APIC up, the boot CPU runs other init meanwhile */
+void smp_wait_ready(void);
+
 #endif // INCLUDE_SMP_H_
@@ -0,0 +1,45 @@
+/*
+ *
+ *      softirq.h
+ *      Deferred interrupt work header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_SOFTIRQ_H_
+#define INCLUDE_SOFTIRQ_H_
+
+#include "stdint.h"
+
+#define SOFTIRQ_RESTART_MAX 10      // Passes over the pending bits before the rest goes to ksoftirqd
+#define SOFTIRQ_TIME_MAX    2000000 // Nanoseconds at interrupt exit before the rest goes to ksoftirqd
+
+/* Lower numbers run first */
+typedef enum {
+    SOFTIRQ_TIMER, // Timer wheel callbacks
+    SOFTIRQ_BLOCK, // Block request completions
+    SOFTIRQ_COUNT,
+} softirq_nr_t;
+
+/* Runs with interrupts on and preemption off, it must not block */
+typedef void (*softirq_handler_t)(void);
+
+/* Install the handler of a softirq */
+void open_softirq(softirq_nr_t nr, softirq_handler_t handler);
+
+/* Mark a softirq pending on the current CPU from a hard interrupt, it runs at interrupt exit */
+void raise_softirq_irqoff(softirq_nr_t nr);
+
+/* Mark a softirq pending on the current CPU from any context, ksoftirqd runs it */
+void raise_softirq(softirq_nr_t nr);
+
+/* Run pending softirqs at the end of a hard interrupt, interrupts must be off */
+void irq_exit(void);
+
+/* Start the per-CPU ksoftirqd threads */
+void softirq_init(void);
+
+#endif // INCLUDE_SOFTIRQ_H_
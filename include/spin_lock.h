@@ -14,15 +14,72 @@
 
 #include "stdint.h"
 
+#ifndef LOCKSTAT
+#    define LOCKSTAT 0
+#endif
+
+#define SPIN_QNODE_NEST 4 // Queue nodes per CPU, one per context that can nest on it
+
+/* Queue node a waiter spins on, owned by its CPU while queued */
+typedef struct spin_qnode {
+        struct spin_qnode *volatile next; // Waiter queued behind this one
+        volatile uint32_t           wait; // Cleared when this waiter becomes the queue head
+} spin_qnode_t;
+
+/* Statistics shared by every lock of a class, times in TSC cycles */
+typedef struct spin_lock_class {
+        const char             *name;
+        struct spin_lock_class *next; // Registered classes, linked on first use
+        uint32_t                registered;
+        uint64_t                acquisitions;
+        uint64_t                contentions; // Acquisitions that had to queue
+        uint64_t                wait_total;
+        uint64_t                wait_max;
+        uint64_t                hold_total;
+        uint64_t                hold_max;
+} spin_lock_class_t;
+
 typedef struct {
-        volatile uint64_t lock;   // lock state
-        uint64_t          rflags; // stored rflags
+        volatile uint32_t      locked; // 1 while held
+        spin_qnode_t *volatile tail;   // Last queued waiter, 0 if none
+#if LOCKSTAT
+        spin_lock_class_t *class;       // Statistics class, 0 if not tracked
+        uint64_t           acquired_at; // TSC when the holder took the lock
+#endif
 } spinlock_t;
 
-/* Lock a spinlock */
+/* Static initializer of a lock, `lock_class` may be 0 */
+#if LOCKSTAT
+#    define SPINLOCK_INIT(lock_class) {.locked = 0, .tail = 0, .class = (lock_class), .acquired_at = 0}
+#else
+#    define SPINLOCK_INIT(lock_class) {.locked = 0, .tail = 0}
+#endif
+
+/* Define a statistics class */
+#define DEFINE_SPIN_LOCK_CLASS(var, class_name) spin_lock_class_t var __attribute__((unused)) = {.name = (class_name)}
+
+/* Initialize a lock at runtime, `class` may be 0 */
+void spin_lock_init(spinlock_t *lock, spin_lock_class_t *class);
+
+/* Lock a spinlock and disable preemption, a lock interrupt handlers or softirqs also take needs spin_lock_irqsave() everywhere */
 void spin_lock(spinlock_t *lock);
 
-/* Unlock a spinlock */
+/* Try to lock a spinlock without waiting, returns 1 on success */
+int spin_trylock(spinlock_t *lock);
+
+/* Unlock a spinlock and enable preemption again */
 void spin_unlock(spinlock_t *lock);
 
+/* Disable interrupts and lock a spinlock, returns the previous RFLAGS */
+uint64_t spin_lock_irqsave(spinlock_t *lock);
+
+/* Unlock a spinlock and restore the interrupt flag from spin_lock_irqsave() */
+void spin_unlock_irqrestore(spinlock_t *lock, uint64_t flags);
+
+/* Print the statistics of every lock class used so far */
+void lockstat_print(void);
+
+/* Clear the statistics of every lock class */
+void lockstat_reset(void);
+
 #endif // INCLUDE_SPIN_LOCK_H_
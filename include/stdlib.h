@@ -76,6 +76,7 @@ int utoa(unsigned int value, char *str, int base);
 
 int itoa(int value, char *str, int base);
 
+/* Built with SSE while the rest of the kernel is not, only call it inside kernel_fpu_begin() */
 int ftoa(double value, char *str, int precision);
 
 /* Skip numbers in a string and return the value of those consecutive numbers */
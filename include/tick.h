@@ -0,0 +1,60 @@
+/*
+ *
+ *      tick.h
+ *      Per-CPU timer tick header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_TICK_H_
+#define INCLUDE_TICK_H_
+
+#include "stdint.h"
+
+#ifndef TICKLESS
+#    define TICKLESS 0
+#endif
+
+#define MSR_IA32_TSC_DEADLINE 0x6e0
+
+#define TICK_HZ        250                        // Scheduler tick rate while a CPU is busy
+#define TICK_PERIOD_NS (1000000000 / TICK_HZ)     // 4 ms
+#define TICK_SLACK_NS  50000                      // Expiries this close are handled together
+#define TICK_MIN_NS    2000                       // Shortest delta programmed into the hardware
+#define TICK_MAX_NS    ((uint64_t)1000000000 * 3) // Longest delta, later expiries rearm on the way
+
+#define LAPIC_TIMER_ONESHOT      (0 << 17)
+#define LAPIC_TIMER_PERIODIC     (1 << 17)
+#define LAPIC_TIMER_TSC_DEADLINE (2 << 17)
+
+typedef enum {
+    TICK_MODE_PERIODIC,     // Fixed-rate LAPIC timer
+    TICK_MODE_ONESHOT,      // LAPIC count programmed per expiry
+    TICK_MODE_TSC_DEADLINE, // IA32_TSC_DEADLINE programmed per expiry
+} tick_mode_t;
+
+/* Returns the timer mode in use */
+tick_mode_t tick_get_mode(void);
+
+/* Returns the invariant TSC increments per millisecond, 0 if the TSC is not usable */
+uint64_t tick_tsc_per_ms(void);
+
+/* Program the LAPIC timer of the current CPU, takes the LAPIC timer counts per millisecond */
+void tick_cpu_init(uint64_t lapic_counts);
+
+/* Timer interrupt body, runs expired events and programs the next one */
+void tick_handle(void);
+
+/* Make sure the timer fires no later than a nano_time() deadline, interrupts must be off */
+void tick_arm(uint64_t deadline);
+
+/* Stop the scheduler tick before idling, returns 1 if it was stopped */
+int tick_sched_stop(void);
+
+/* Restart the scheduler tick when a thread starts running, interrupts must be off */
+void tick_sched_resume(void);
+
+#endif // INCLUDE_TICK_H_
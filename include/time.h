@@ -7,6 +7,10 @@
 typedef unsigned long time_t;
 typedef unsigned long time64_t;
 
+/* Read the CMOS clock once and keep time from the HPET afterwards */
+void time_init(void);
+
+/* Returns the Unix time without touching the CMOS */
 uint64_t get_current_time(void);
 
 #endif // INCLUDE_TIME_H_
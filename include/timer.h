@@ -12,8 +12,75 @@
 #ifndef INCLUDE_TIMER_H_
 #define INCLUDE_TIMER_H_
 
+#include "double_list.h"
+#include "spin_lock.h"
+#include "stddef.h"
 #include "stdint.h"
 
+#define WHEEL_LVL_CLK_SHIFT 3 // Each level is 8 times coarser than the one below
+#define WHEEL_LVL_BITS      6
+#define WHEEL_LVL_SIZE      (1 << WHEEL_LVL_BITS) // Buckets per level
+#define WHEEL_LVL_MASK      (WHEEL_LVL_SIZE - 1)
+#define WHEEL_LVL_DEPTH     8
+#define WHEEL_SIZE          (WHEEL_LVL_SIZE * WHEEL_LVL_DEPTH)
+#define WHEEL_TIMEOUT_MAX   (((uint64_t)WHEEL_LVL_SIZE - 2) << ((WHEEL_LVL_DEPTH - 1) * WHEEL_LVL_CLK_SHIFT)) // Longer timeouts are clamped
+
+struct timer_base;
+
+typedef struct timer_list {
+        ilist_node_t       entry;
+        uint64_t           expires; // Jiffies
+        void (*func)(struct timer_list *timer);
+        struct timer_base *base;    // Wheel the timer is queued on, 0 when not pending
+        uint32_t           idx;     // Bucket in that wheel
+} timer_list_t;
+
+typedef struct timer_base {
+        spinlock_t    lock;
+        uint64_t      clk;                      // Next jiffy to process
+        uint64_t      pending[WHEEL_LVL_DEPTH]; // Non-empty buckets, one bit each
+        ilist_node_t  buckets[WHEEL_SIZE];
+        size_t        count;                    // Queued timers
+        timer_list_t *running;                  // Callback being run, for del_timer_sync()
+        uint32_t      cpu;
+} __attribute__((aligned(64))) timer_base_t;
+
+/* Returns the current time in scheduler ticks */
+uint64_t jiffies_now(void);
+
+/* Convert milliseconds to jiffies, rounding up */
+uint64_t msecs_to_jiffies(uint64_t ms);
+
+/* Initialize a timer */
+void timer_setup(timer_list_t *timer, void (*func)(timer_list_t *timer));
+
+/* Check whether a timer is queued */
+int timer_pending(const timer_list_t *timer);
+
+/* Queue a timer on a CPU's wheel for an absolute expiry in jiffies */
+void add_timer_on(timer_list_t *timer, uint64_t expires, uint32_t cpu);
+
+/* Queue a timer on the current CPU's wheel for an absolute expiry in jiffies, a housekeeping CPU's if this one is isolated */
+void add_timer(timer_list_t *timer, uint64_t expires);
+
+/* Move a timer to a new expiry, returns 1 if it was pending */
+int mod_timer(timer_list_t *timer, uint64_t expires);
+
+/* Dequeue a timer, returns 1 if it was pending */
+int del_timer(timer_list_t *timer);
+
+/* Dequeue a timer and wait for a running callback to finish */
+int del_timer_sync(timer_list_t *timer);
+
+/* Returns the earliest wheel expiry of the current CPU in nano_time(), 0 if none */
+uint64_t timer_next_expiry(void);
+
+/* Run expired wheel timers of the current CPU, called from the timer softirq */
+void timer_run_expired(void);
+
+/* Set up the per-CPU timer wheels */
+void timer_init(void);
+
 /* Millisecond-based delay functions */
 void msleep(uint64_t ms);
 
@@ -0,0 +1,35 @@
+/*
+ *
+ *      topology.h
+ *      CPU topology header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_TOPOLOGY_H_
+#define INCLUDE_TOPOLOGY_H_
+
+#include "cpumask.h"
+#include "stdint.h"
+
+/* Where a CPU sits, the ids are APIC ID fields and unique system-wide */
+typedef struct cpu_topology {
+        uint32_t  package_id;
+        uint32_t  core_id;
+        uint32_t  llc_id;
+        uint32_t  thread_id;    // SMT thread within its core
+        cpumask_t smt_mask;     // CPUs on the same core
+        cpumask_t llc_mask;     // CPUs sharing the last level cache
+        cpumask_t package_mask; // CPUs in the same package
+} cpu_topology_t;
+
+/* Returns the topology of a CPU, 0 before topology_init() */
+const cpu_topology_t *cpu_topology(uint32_t cpu);
+
+/* Build the SMT, LLC and package maps from CPUID and the APIC IDs of `count` CPUs */
+void topology_init(uint32_t count);
+
+#endif // INCLUDE_TOPOLOGY_H_
@@ -0,0 +1,78 @@
+/*
+ *
+ *      vm_space.h
+ *      Virtual address space allocator header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_VM_SPACE_H_
+#define INCLUDE_VM_SPACE_H_
+
+#include "rbtree.h"
+#include "spin_lock.h"
+#include "stddef.h"
+#include "stdint.h"
+
+#define KERNEL_VM_START 0xffff900000000000 // Start of the tracked kernel virtual window
+#define KERNEL_VM_END   0xffffc00000000000 // End of the tracked kernel virtual window
+
+#define VM_AREA_NONE  0x0
+#define VM_AREA_HEAP  0x1 // Kernel heap
+#define VM_AREA_MMIO  0x2 // Device memory
+#define VM_AREA_STACK 0x4 // Thread stacks
+
+/* A reserved range [start, end) */
+typedef struct vm_area {
+        rb_node_t node;
+        uintptr_t start;   // First byte of the range
+        uintptr_t end;     // One past the last byte of the range
+        uintptr_t gap;     // Free bytes between the previous range (or base) and start
+        uintptr_t max_gap; // Largest `gap` in this subtree
+        uint64_t  flags;   // VM_AREA_* flags
+} vm_area_t;
+
+/* A copy of a reserved range, stays valid after the space lock is dropped */
+typedef struct {
+        uintptr_t start;
+        uintptr_t end;
+        uint64_t  flags;
+} vm_range_t;
+
+/* An address space, the ranges are kept in an interval tree sorted by start */
+typedef struct vm_space {
+        rb_root_t  root;
+        uintptr_t  base;  // Lowest usable address
+        uintptr_t  limit; // One past the highest usable address
+        size_t     count; // Number of reserved ranges
+        spinlock_t lock;
+} vm_space_t;
+
+/* Initialize an empty address space covering [base, limit) */
+void vm_space_init(vm_space_t *space, uintptr_t base, uintptr_t limit);
+
+/* Free every range of an address space */
+void vm_space_destroy(vm_space_t *space);
+
+/* Find (without reserving) the lowest free range of `size` bytes at or above `hint` */
+uintptr_t vm_space_find_free(vm_space_t *space, uintptr_t hint, size_t size);
+
+/* Reserve the lowest free range of `size` bytes at or above `hint`, aligned to `align` */
+uintptr_t vm_space_alloc(vm_space_t *space, uintptr_t hint, size_t size, size_t align, uint64_t flags);
+
+/* Reserve the fixed range [start, start + size) */
+int vm_space_reserve(vm_space_t *space, uintptr_t start, size_t size, uint64_t flags);
+
+/* Release the range starting at `start` */
+int vm_space_free(vm_space_t *space, uintptr_t start);
+
+/* Copy the range containing `addr` into `range`, returns 1 if no range contains it */
+int vm_space_find(vm_space_t *space, uintptr_t addr, vm_range_t *range);
+
+/* Returns the kernel address space */
+vm_space_t *get_kernel_vm_space(void);
+
+#endif // INCLUDE_VM_SPACE_H_
@@ -0,0 +1,106 @@
+/*
+ *
+ *      wait.h
+ *      Wait queues and completions header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_WAIT_H_
+#define INCLUDE_WAIT_H_
+
+#include "double_list.h"
+#include "sched.h"
+#include "spin_lock.h"
+#include "stdint.h"
+
+#define WAIT_EXCLUSIVE (1 << 0) // Woken one at a time, after every non-exclusive waiter
+
+typedef struct wait_queue_entry {
+        ilist_node_t node;   // Unlinked (next == 0) once woken
+        thread_t    *thread;
+        uint32_t     flags;  // WAIT_* flags
+        void (*func)(struct wait_queue_entry *entry); // Called under the queue lock instead of waking `thread`
+} wait_queue_entry_t;
+
+typedef struct wait_queue_head {
+        spinlock_t   lock;
+        ilist_node_t waiters; // Non-exclusive waiters first, exclusive ones at the tail
+} wait_queue_head_t;
+
+typedef struct completion {
+        wait_queue_head_t wait;
+        volatile uint32_t done; // complete() calls not consumed yet
+} completion_t;
+
+#define COMPLETION_ALL 0x7fffffff // done value left by complete_all()
+
+/* Sleep until `condition` holds, spins where the caller cannot block */
+#define wait_event(wq, condition)                                         \
+    do {                                                                  \
+        if (!thread_can_sleep()) {                                        \
+            while (!(condition)) __asm__ volatile("pause");               \
+            break;                                                        \
+        }                                                                 \
+        wait_queue_entry_t __entry;                                       \
+        wait_entry_init(&__entry, 0);                                     \
+        while (1) {                                                       \
+            prepare_to_wait(&(wq), &__entry);                             \
+            if (condition) break;                                         \
+            schedule();                                                   \
+        }                                                                 \
+        finish_wait(&(wq), &__entry);                                     \
+    } while (0)
+
+/* Initialize a wait queue */
+void wait_queue_init(wait_queue_head_t *wq);
+
+/* Initialize a wait entry for the current thread */
+void wait_entry_init(wait_queue_entry_t *entry, uint32_t flags);
+
+/* Initialize a wait entry whose wakeup calls `func` instead of waking a thread */
+void wait_entry_init_func(wait_queue_entry_t *entry, void (*func)(wait_queue_entry_t *entry), uint32_t flags);
+
+/* Queue an entry that is not queued yet without touching any thread state */
+void add_wait_queue(wait_queue_head_t *wq, wait_queue_entry_t *entry);
+
+/* Dequeue an entry, once it returns no wakeup is still using the entry */
+void remove_wait_queue(wait_queue_head_t *wq, wait_queue_entry_t *entry);
+
+/* Queue the entry if needed and mark the current thread blocked, check the condition afterwards */
+void prepare_to_wait(wait_queue_head_t *wq, wait_queue_entry_t *entry);
+
+/* Mark the current thread running again and dequeue the entry */
+void finish_wait(wait_queue_head_t *wq, wait_queue_entry_t *entry);
+
+/* Wake every non-exclusive waiter and one exclusive waiter, returns the number woken */
+int wake_up(wait_queue_head_t *wq);
+
+/* Wake every waiter, returns the number woken */
+int wake_up_all(wait_queue_head_t *wq);
+
+/* Block for up to `ns` nanoseconds or until woken, returns the time left */
+uint64_t schedule_timeout(uint64_t ns);
+
+/* Initialize a completion */
+void init_completion(completion_t *completion);
+
+/* Forget earlier complete() calls before reusing a completion */
+void reinit_completion(completion_t *completion);
+
+/* Signal one waiter, safe from interrupt handlers */
+void complete(completion_t *completion);
+
+/* Signal every current and future waiter */
+void complete_all(completion_t *completion);
+
+/* Block until the completion is signalled */
+void wait_for_completion(completion_t *completion);
+
+/* Block until the completion is signalled or the timeout expires, returns 0 on timeout */
+int wait_for_completion_timeout(completion_t *completion, uint64_t timeout_ms);
+
+#endif // INCLUDE_WAIT_H_
@@ -0,0 +1,102 @@
+/*
+ *
+ *      workqueue.h
+ *      Kernel workqueue header file
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#ifndef INCLUDE_WORKQUEUE_H_
+#define INCLUDE_WORKQUEUE_H_
+
+#include "double_list.h"
+#include "stdint.h"
+#include "timer.h"
+
+#define WORK_CPU_UNBOUND 0xffffffff // Let the workqueue pick the CPU
+
+#define WORK_PENDING (1 << 0) // Queued or armed, not started yet
+
+#define WQ_UNBOUND (1 << 0) // Items run on a shared pool that may migrate between CPUs
+
+struct work;
+struct worker_pool;
+
+typedef void (*work_func_t)(struct work *work);
+
+typedef struct work {
+        ilist_node_t        node;
+        work_func_t         func;
+        volatile uint32_t   flags;     // WORK_* flags
+        uint64_t            seq;       // Position in the pool's queue, used by flushing
+        struct worker_pool *pool;      // Pool the item was last queued on
+        uint64_t            queued_at; // nano_time() of the last enqueue
+} work_t;
+
+typedef struct delayed_work {
+        work_t            work;
+        timer_list_t      timer; // Queues the item when it expires
+        uint32_t          cpu;   // Target CPU or WORK_CPU_UNBOUND
+        struct workqueue *wq;
+} delayed_work_t;
+
+typedef struct workqueue {
+        const char *name;
+        uint32_t    flags; // WQ_* flags
+} workqueue_t;
+
+extern workqueue_t *system_wq;
+extern workqueue_t *system_unbound_wq;
+
+/* Initialize a work item */
+void init_work(work_t *work, work_func_t func);
+
+/* Initialize a delayed work item */
+void init_delayed_work(delayed_work_t *dwork, work_func_t func);
+
+/* Returns the delayed work item that contains a work item */
+delayed_work_t *to_delayed_work(work_t *work);
+
+/* Create a workqueue */
+workqueue_t *workqueue_create(const char *name, uint32_t flags);
+
+/* Queue a work item on a CPU, returns 1 if it was already pending */
+int queue_work_on(uint32_t cpu, workqueue_t *wq, work_t *work);
+
+/* Queue a work item on the current CPU, returns 1 if it was already pending */
+int queue_work(workqueue_t *wq, work_t *work);
+
+/* Queue a work item after a delay in milliseconds, returns 1 if it was already pending */
+int queue_delayed_work_on(uint32_t cpu, workqueue_t *wq, delayed_work_t *dwork, uint64_t delay_ms);
+
+/* Queue a work item on the current CPU after a delay in milliseconds */
+int queue_delayed_work(workqueue_t *wq, delayed_work_t *dwork, uint64_t delay_ms);
+
+/* Queue a work item on the system workqueue */
+int schedule_work(work_t *work);
+
+/* Remove a pending work item, returns 1 if it was removed before running */
+int cancel_work(work_t *work);
+
+/* Remove a pending work item and wait for a running instance to finish */
+int cancel_work_sync(work_t *work);
+
+/* Disarm or dequeue a delayed work item, returns 1 if it was removed before running */
+int cancel_delayed_work(delayed_work_t *dwork);
+
+/* Disarm a delayed work item and wait for a running instance to finish */
+int cancel_delayed_work_sync(delayed_work_t *dwork);
+
+/* Wait until a work item is neither pending nor running */
+void flush_work(work_t *work);
+
+/* Wait until every item queued on a workqueue before the call has finished */
+void flush_workqueue(workqueue_t *wq);
+
+/* Start the worker pools, needs the scheduler */
+void workqueue_init(void);
+
+#endif // INCLUDE_WORKQUEUE_H_
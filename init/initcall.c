@@ -0,0 +1,138 @@
+/*
+ *
+ *      initcall.c
+ *      Leveled initcalls with an asynchronous executor
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "initcall.h"
+#include "acpi.h"
+#include "debug.h"
+#include "printk.h"
+#include "sched.h"
+#include "smp.h"
+#include "stdint.h"
+#include "string.h"
+#include "wait.h"
+
+extern initcall_t __initcall_start[];
+extern initcall_t __initcall_end[];
+
+static const char *initcall_level_names[INITCALL_LEVELS] = {"subsys", "device", "late"};
+
+static completion_t initcall_finished; // Completed once per async initcall that returns
+static uint64_t     initcall_level_time[INITCALL_LEVELS];
+static uint32_t     initcall_next_cpu;
+
+/* Returns the initcall called `name`, 0 if there is none */
+static initcall_t *initcall_find(const char *name)
+{
+    for (initcall_t *call = __initcall_start; call < __initcall_end; call++)
+        if (!strcmp(call->name, name)) return call;
+    return 0;
+}
+
+/* Check whether everything an initcall depends on has finished */
+static int initcall_ready(initcall_t *call)
+{
+    for (uint32_t i = 0; i < INITCALL_MAX_DEPS && call->deps[i]; i++) {
+        initcall_t *dep = initcall_find(call->deps[i]);
+        if (!dep) continue; // Reported by do_initcalls()
+        if (__atomic_load_n(&dep->state, __ATOMIC_ACQUIRE) != INITCALL_DONE) return 0;
+    }
+    return 1;
+}
+
+/* Run an initcall on the current CPU and record its timing */
+static void initcall_run(initcall_t *call)
+{
+    uint64_t start = nano_time();
+    call->cpu      = get_current_cpu_id();
+    call->func();
+    call->time = nano_time() - start;
+    __atomic_store_n(&call->state, INITCALL_DONE, __ATOMIC_RELEASE);
+}
+
+/* Thread body of an async initcall */
+static void initcall_thread(void *arg)
+{
+    initcall_run((initcall_t *)arg);
+    complete(&initcall_finished);
+}
+
+/* Pick an AP for the next async initcall, round robin */
+static uint32_t initcall_pick_cpu(void)
+{
+    uint32_t cpus = get_cpu_count();
+    uint32_t self = get_current_cpu_id();
+    uint32_t cpu  = initcall_next_cpu++ % (cpus - 1);
+    return cpu >= self ? cpu + 1 : cpu;
+}
+
+/* Run every initcall of a level, async ones spread over the APs, returns once all have finished */
+void do_initcalls(initcall_level_t level)
+{
+    uint64_t start   = nano_time();
+    uint32_t pending = 0, running = 0;
+    int      async   = get_cpu_count() > 1 && thread_can_sleep();
+
+    init_completion(&initcall_finished); // Every earlier level consumed its completions
+    for (initcall_t *call = __initcall_start; call < __initcall_end; call++) {
+        if (call->level != level || call->state != INITCALL_WAITING) continue;
+        for (uint32_t i = 0; i < INITCALL_MAX_DEPS && call->deps[i]; i++) {
+            initcall_t *dep = initcall_find(call->deps[i]);
+            if (!dep)
+                plogk("init: %s depends on unknown initcall %s, ignored.\n", call->name, call->deps[i]);
+            else if (dep->level > level)
+                panic("init: %s depends on %s of a later level.", call->name, dep->name);
+        }
+        pending++;
+    }
+
+    while (pending) {
+        int started = 0;
+        for (initcall_t *call = __initcall_start; call < __initcall_end; call++) {
+            if (call->level != level || call->state != INITCALL_WAITING || !initcall_ready(call)) continue;
+            call->state = INITCALL_RUNNING;
+            started     = 1;
+            pending--;
+
+            /* Synchronous ones and everything on a single CPU run here, in link order */
+            if (async && (call->flags & INITCALL_ASYNC) &&
+                thread_create_on(call->name, initcall_thread, call, initcall_pick_cpu(), 0)) {
+                running++;
+                continue;
+            }
+            initcall_run(call);
+        }
+        if (started) continue;
+        if (!running) panic("init: Dependency cycle among the %s initcalls.", initcall_level_names[level]);
+
+        /* Only an async initcall finishing can make more of them ready */
+        wait_for_completion(&initcall_finished);
+        running--;
+    }
+    while (running--) wait_for_completion(&initcall_finished);
+
+    initcall_level_time[level] = nano_time() - start;
+}
+
+/* Print how long each initcall and level took */
+void initcall_report(void)
+{
+    for (uint32_t level = 0; level < INITCALL_LEVELS; level++) {
+        uint64_t serial = 0;
+        for (initcall_t *call = __initcall_start; call < __initcall_end; call++) {
+            if (call->level != level || call->state != INITCALL_DONE) continue;
+            serial += call->time;
+            plogk("init: %-6s %-16s cpu %3u %8llu us%s\n", initcall_level_names[level], call->name, call->cpu,
+                  call->time / 1000, (call->flags & INITCALL_ASYNC) ? " async" : "");
+        }
+        plogk("init: %-6s level took %llu us, %llu us if run in sequence.\n", initcall_level_names[level],
+              initcall_level_time[level] / 1000, serial / 1000);
+    }
+}
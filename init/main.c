@@ -10,29 +10,38 @@
  */
 
 #include "acpi.h"
+#include "bench.h"
 #include "cmdline.h"
 #include "common.h"
 #include "cpuid.h"
 #include "debug.h"
 #include "eis.h"
+#include "fpu.h"
 #include "frame.h"
 #include "fs/superblock.h"
 #include "gdt.h"
 #include "heap.h"
+#include "hrtimer.h"
 #include "hhdm.h"
-#include "ide.h"
+#include "idle.h"
+#include "initcall.h"
 #include "interrupt.h"
-#include "limine_module.h"
+#include "isolation.h"
+#include "kernel_map.h"
 #include "page.h"
-#include "parallel.h"
-#include "pci.h"
+#include "parallel_for.h"
+#include "percpu.h"
 #include "printk.h"
-#include "ps2.h"
+#include "rcu.h"
 #include "rinx.h"
-#include "serial.h"
+#include "sched.h"
 #include "smbios.h"
 #include "smp.h"
+#include "softirq.h"
+#include "time.h"
+#include "timer.h"
 #include "video.h"
+#include "workqueue.h"
 
 /* Executable entry */
 void executable_entry(void)
@@ -54,9 +63,12 @@ void executable_entry(void)
 /* Kernel entry */
 void kernel_entry(void)
 {
-    init_fpu(); // Initialize FPU/MMX
-    init_sse(); // Initialize SSE/SSE2
-    init_avx(); // Initialize AVX/AVX2
+    percpu_init(get_bsp_percpu()); // this_cpu_*() is valid from here on, init_gdt() points GS at it again
+
+    init_fpu();   // Initialize FPU/MMX
+    init_sse();   // Initialize SSE/SSE2
+    init_xsave(); // Initialize XSAVE
+    init_avx();   // Initialize AVX/AVX2
 
     init_frame(); // Initialize memory frame
     page_init();  // Initialize memory page
@@ -83,22 +95,37 @@ void kernel_entry(void)
     plogk("x86/PAT: Configuration [0-7]: %s\n", get_pat_config().pat_str);
     plogk("dmi: %s %s, BIOS %s %s\n", smbios_sys_manufacturer(), smbios_sys_product_name(), smbios_bios_version(), smbios_bios_release_date());
 
+    kernel_map_init();            // Remap the kernel image with large pages
     init_gdt();                   // Initialize global descriptors
     init_idt();                   // Initialize interrupt descriptor
     isr_registe_handle();         // Register ISR interrupt processing
     acpi_init();                  // Initialize ACPI
+    time_init();                  // Start the wall clock
+    fpu_init();                   // Size the per-thread extended state
     smp_init();                   // Initialize SMP
+    isolation_init();             // Set aside the CPUs named by isolcpus=
+    idle_init();                  // Pick the idle instruction and C-states
+    sched_init();                 // Initialize the scheduler
+    timer_init();                 // Set up the timer wheels
+    hrtimer_init();               // Set up the high-resolution timer trees
+    smp_wait_ready();             // Wait for the APs started by smp_init()
+    workqueue_init();             // Start the workqueue worker pools
+    softirq_init();               // Start the per-CPU ksoftirqd threads
+    rcu_init();                   // Start RCU callback processing
+    parallel_for_init();          // Start the parallel_for() helper threads
     print_memory_map();           // Print memory map information
     log_buffer_print(&frame_log); // Print frame log
 
     superblock_init();
-    pci_init();      // Initialize PCI
-    lmodule_init();  // Initialize the passed-in resource module list
-    init_ide();      // Initialize ATA/ATAPI driver
-    init_serial();   // Initialize the serial port
-    init_parallel(); // Initialize the parallel port
-    init_ps2();      // Initialize PS/2 controller
-    enable_intr();
+    enable_intr(); // Async initcalls sleep on completions
+
+    /* PCI, IDE, serial, parallel and PS/2 probes run in parallel on the APs */
+    for (uint32_t level = 0; level < INITCALL_LEVELS; level++) do_initcalls(level);
+    initcall_report();
+
+#if KERNEL_BENCH
+    bench_run_all(); // Run in-kernel benchmarks
+#endif
 
     panic("No operation.");
 }
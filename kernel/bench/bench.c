@@ -0,0 +1,30 @@
+/*
+ *
+ *      bench.c
+ *      In-kernel benchmarks
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "bench.h"
+#include "printk.h"
+
+/* Run every in-kernel benchmark */
+void bench_run_all(void)
+{
+    plogk("bench: Running in-kernel benchmarks.\n");
+    bench_sched();
+    bench_workqueue();
+    bench_timer();
+    bench_spinlock();
+    bench_rcu();
+    bench_smp_call();
+    bench_deadline();
+    bench_isolation();
+    bench_coroutine();
+    bench_parallel_for();
+    plogk("bench: All benchmarks finished.\n");
+}
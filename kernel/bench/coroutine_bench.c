@@ -0,0 +1,99 @@
+/*
+ *
+ *      coroutine_bench.c
+ *      Coroutine and thread switch cost
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "acpi.h"
+#include "bench.h"
+#include "coroutine.h"
+#include "printk.h"
+#include "sched.h"
+#include "smp.h"
+#include "stdint.h"
+#include "wait.h"
+
+#define CO_BENCH_SWITCHES 100000 // Yields per side of a ping-pong
+#define CO_BENCH_INFLIGHT 1000   // Coroutines waiting at once
+
+static co_sched_t        co_bench_sched;
+static wait_queue_head_t co_bench_wait;
+static volatile int      co_bench_released;
+static volatile uint32_t co_bench_done;
+static volatile uint64_t co_bench_release_at;
+
+/* One side of a ping-pong, every yield switches to the other side */
+static void co_bench_yield(void *arg)
+{
+    (void)arg;
+    for (uint32_t i = 0; i < CO_BENCH_SWITCHES; i++) co_yield();
+}
+
+/* Thread side of a ping-pong, both run pinned to one CPU */
+static void co_bench_thread_yield(void *arg)
+{
+    (void)arg;
+    for (uint32_t i = 0; i < CO_BENCH_SWITCHES; i++) thread_yield();
+    __atomic_add_fetch(&co_bench_done, 1, __ATOMIC_RELEASE);
+}
+
+/* An in-flight operation waiting for its event */
+static void co_bench_waiter(void *arg)
+{
+    (void)arg;
+    co_await(co_bench_wait, co_bench_released);
+}
+
+/* Runs after every waiter has suspended, FIFO order puts it last */
+static void co_bench_release(void *arg)
+{
+    (void)arg;
+    co_bench_release_at = nano_time();
+    co_bench_released   = 1;
+    wake_up_all(&co_bench_wait);
+}
+
+/* Measure coroutine switches against thread switches, and the cost of many coroutines waiting on one event */
+void bench_coroutine(void)
+{
+    uint32_t cpus = get_cpu_count() ? get_cpu_count() : 1;
+    uint32_t cpu  = cpus - 1; // Away from the boot CPU running the benchmarks where there is a choice
+
+    co_sched_init(&co_bench_sched);
+    if (!co_create(&co_bench_sched, co_bench_yield, 0) || !co_create(&co_bench_sched, co_bench_yield, 0)) {
+        plogk("bench: coroutine: Cannot allocate coroutine stacks.\n");
+        return;
+    }
+    uint64_t start = nano_time();
+    co_run(&co_bench_sched);
+    uint64_t co_time = nano_time() - start;
+
+    uint32_t threads = 0;
+    co_bench_done    = 0;
+    start            = nano_time();
+    for (uint32_t i = 0; i < 2; i++) threads += thread_create_on("co_bench", co_bench_thread_yield, 0, cpu, THREAD_PINNED) != 0;
+    while (__atomic_load_n(&co_bench_done, __ATOMIC_ACQUIRE) < threads) thread_yield();
+    uint64_t thread_time = nano_time() - start;
+
+    plogk("bench: coroutine: co_yield %llu ns, thread_yield %llu ns per switch (%u switches).\n", co_time / (2 * CO_BENCH_SWITCHES),
+          threads == 2 ? thread_time / (2 * CO_BENCH_SWITCHES) : 0, 2 * CO_BENCH_SWITCHES);
+
+    /* Many operations in flight at once, each one written as a plain sequential wait */
+    wait_queue_init(&co_bench_wait);
+    co_bench_released = 0;
+    uint32_t created  = 0;
+    start             = nano_time();
+    for (uint32_t i = 0; i < CO_BENCH_INFLIGHT; i++) created += co_create(&co_bench_sched, co_bench_waiter, 0) != 0;
+    uint64_t create_time = nano_time() - start;
+    if (!co_create(&co_bench_sched, co_bench_release, 0)) co_bench_released = 1; // Nothing to release them, let them pass
+    co_run(&co_bench_sched);
+    uint64_t wake_time = co_bench_release_at ? nano_time() - co_bench_release_at : 0;
+
+    plogk("bench: coroutine: %u in flight, %llu ns to create, %llu ns from wake_up_all() to finish, per coroutine.\n", created,
+          created ? create_time / created : 0, created ? wake_time / created : 0);
+}
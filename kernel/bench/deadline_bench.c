@@ -0,0 +1,138 @@
+/*
+ *
+ *      deadline_bench.c
+ *      Periodic release jitter of the deadline and normal classes
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "acpi.h"
+#include "bench.h"
+#include "hrtimer.h"
+#include "printk.h"
+#include "sched.h"
+#include "smp.h"
+#include "stdint.h"
+#include "wait.h"
+
+#define DL_BENCH_PERIOD  1000000 // Nanoseconds between releases
+#define DL_BENCH_RUNTIME 200000  // Reserved runtime per period
+#define DL_BENCH_WORK    50000   // Nanoseconds of work per job
+#define DL_BENCH_JOBS    1000
+#define DL_BENCH_HOGS    3 // CPU-bound normal threads sharing the CPU
+
+typedef struct {
+        uint64_t min;    // Release to start of a job, nanoseconds
+        uint64_t max;
+        uint64_t sum;
+        uint64_t misses; // Jobs that finished after their deadline
+        int      failed; // The deadline class rejected the reservation
+} dl_bench_stats_t;
+
+static volatile int      dl_bench_stop;
+static volatile uint32_t dl_bench_done;
+static dl_bench_stats_t  dl_bench_stats;
+static completion_t      dl_bench_release;
+static hrtimer_t         dl_bench_timer;
+
+/* Keep the CPU busy until the measurement is over */
+static void dl_bench_hog(void *arg)
+{
+    (void)arg;
+    while (!dl_bench_stop) __asm__ volatile("pause");
+    __atomic_add_fetch(&dl_bench_done, 1, __ATOMIC_RELEASE);
+}
+
+/* Record the release latency of a job, then run its work */
+static void dl_bench_job(uint64_t release, uint64_t deadline)
+{
+    uint64_t start   = nano_time();
+    uint64_t latency = start > release ? start - release : 0;
+    if (latency < dl_bench_stats.min) dl_bench_stats.min = latency;
+    if (latency > dl_bench_stats.max) dl_bench_stats.max = latency;
+    dl_bench_stats.sum += latency;
+
+    while (nano_time() - start < DL_BENCH_WORK) __asm__ volatile("pause");
+    if (nano_time() > deadline) dl_bench_stats.misses++;
+}
+
+/* Deadline class, each job is released by the replenishment timer of its reservation */
+static void dl_bench_deadline(void *arg)
+{
+    (void)arg;
+    sched_attr_t attr = {.runtime = DL_BENCH_RUNTIME, .deadline = DL_BENCH_PERIOD, .period = DL_BENCH_PERIOD};
+    if (sched_set_deadline(&attr)) {
+        dl_bench_stats.failed = 1;
+        __atomic_add_fetch(&dl_bench_done, 1, __ATOMIC_RELEASE);
+        return;
+    }
+
+    thread_t *self = get_current_thread();
+    thread_yield(); // Start on a period boundary
+    for (uint32_t i = 0; i < DL_BENCH_JOBS; i++) {
+        dl_bench_job(self->dl_abs - self->dl.deadline, self->dl_abs);
+        thread_yield();
+    }
+    __atomic_add_fetch(&dl_bench_done, 1, __ATOMIC_RELEASE);
+}
+
+/* Releases the normal class job */
+static hrtimer_restart_t dl_bench_timer_func(hrtimer_t *timer)
+{
+    (void)timer;
+    complete(&dl_bench_release);
+    return HRTIMER_NORESTART;
+}
+
+/* Normal class, each job is released by an hrtimer waking the thread */
+static void dl_bench_normal(void *arg)
+{
+    (void)arg;
+    uint64_t release = nano_time() + DL_BENCH_PERIOD;
+    for (uint32_t i = 0; i < DL_BENCH_JOBS; i++) {
+        hrtimer_start(&dl_bench_timer, release);
+        wait_for_completion(&dl_bench_release);
+        dl_bench_job(release, release + DL_BENCH_PERIOD);
+        release += DL_BENCH_PERIOD;
+    }
+    __atomic_add_fetch(&dl_bench_done, 1, __ATOMIC_RELEASE);
+}
+
+/* Run the periodic thread against the hogs on one CPU, returns 1 if a thread could not be created */
+static int dl_bench_round(const char *name, void (*entry)(void *arg), uint32_t cpu)
+{
+    dl_bench_stop  = 0;
+    dl_bench_done  = 0;
+    dl_bench_stats = (dl_bench_stats_t) {.min = ~(uint64_t)0};
+    init_completion(&dl_bench_release);
+    hrtimer_setup(&dl_bench_timer, dl_bench_timer_func);
+
+    uint32_t threads = 0;
+    for (uint32_t i = 0; i < DL_BENCH_HOGS; i++) threads += thread_create_on("dl_bench_hog", dl_bench_hog, 0, cpu, THREAD_PINNED) != 0;
+    int failed = !thread_create_on("dl_bench", entry, 0, cpu, THREAD_PINNED);
+
+    if (!failed)
+        while (__atomic_load_n(&dl_bench_done, __ATOMIC_ACQUIRE) < 1) thread_yield();
+    dl_bench_stop = 1;
+    while (__atomic_load_n(&dl_bench_done, __ATOMIC_ACQUIRE) < threads + !failed) thread_yield();
+
+    if (failed || dl_bench_stats.failed) return 1;
+    plogk("bench: deadline: %-8s latency min=%6llu avg=%6llu max=%8llu ns, %llu/%u deadlines missed\n", name, dl_bench_stats.min,
+          dl_bench_stats.sum / DL_BENCH_JOBS, dl_bench_stats.max, dl_bench_stats.misses, DL_BENCH_JOBS);
+    return 0;
+}
+
+/* Measure periodic release jitter of the deadline and normal classes next to CPU-bound threads */
+void bench_deadline(void)
+{
+    uint32_t cpus = get_cpu_count() ? get_cpu_count() : 1;
+    uint32_t cpu  = cpus - 1; // Away from the boot CPU running the benchmarks where there is a choice
+
+    plogk("bench: deadline: CPU %u, %u jobs of %u us every %u us (%u us reserved), %u CPU-bound threads.\n", cpu, DL_BENCH_JOBS,
+          DL_BENCH_WORK / 1000, DL_BENCH_PERIOD / 1000, DL_BENCH_RUNTIME / 1000, DL_BENCH_HOGS);
+    if (dl_bench_round("normal", dl_bench_normal, cpu) || dl_bench_round("deadline", dl_bench_deadline, cpu))
+        plogk("bench: deadline: Cannot start the periodic thread.\n");
+}
@@ -0,0 +1,111 @@
+/*
+ *
+ *      isolation_bench.c
+ *      Interruptions seen by isolated CPUs
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "acpi.h"
+#include "alloc.h"
+#include "bench.h"
+#include "isolation.h"
+#include "percpu.h"
+#include "printk.h"
+#include "sched.h"
+#include "smp.h"
+#include "stdint.h"
+#include "string.h"
+
+#define ISOLATION_BENCH_SETTLE 20000000   // Nanoseconds for the tick to stop before counting
+#define ISOLATION_BENCH_TIME   1000000000 // Nanoseconds of polling per CPU
+#define ISOLATION_BENCH_GAP    2000       // A longer gap between two clock reads is an interruption
+
+typedef struct {
+        uint64_t timer;    // Timer interrupts
+        uint64_t ipi;      // IPIs
+        uint64_t device;   // Interrupts through irq_dispatch()
+        uint64_t softirq;  // Softirq handlers run
+        uint64_t switches; // Context switches
+        uint64_t gaps;     // Clock gaps over ISOLATION_BENCH_GAP
+        uint64_t max_gap;  // Longest of them in nanoseconds
+} isolation_bench_stats_t;
+
+static isolation_bench_stats_t *isolation_bench_stats;
+static volatile uint32_t        isolation_bench_done;
+
+/* Snapshot the interrupt counters of the current CPU */
+static void isolation_bench_sample(isolation_bench_stats_t *stats)
+{
+    percpu_t *cpu   = this_cpu();
+    stats->timer    = cpu->timer_irqs;
+    stats->ipi      = cpu->ipi_count;
+    stats->softirq  = cpu->softirq_runs;
+    stats->switches = sched_runqueue((uint32_t)cpu->cpu_id)->switches;
+    stats->device   = 0;
+    for (uint32_t i = 0; i < IDT_VECTORS; i++) stats->device += cpu->irq_vector_counts[i];
+}
+
+/* Poll the clock on an isolated CPU, anything that takes the CPU away shows up as a gap */
+static void isolation_bench_poll(void *arg)
+{
+    isolation_bench_stats_t *stats = (isolation_bench_stats_t *)arg, start;
+
+    uint64_t now = nano_time(), last, end = now + ISOLATION_BENCH_SETTLE;
+    while (nano_time() < end) __asm__ volatile("pause");
+
+    isolation_bench_sample(&start);
+    last = nano_time();
+    end  = last + ISOLATION_BENCH_TIME;
+    while ((now = nano_time()) < end) {
+        if (now - last > ISOLATION_BENCH_GAP) {
+            stats->gaps++;
+            if (now - last > stats->max_gap) stats->max_gap = now - last;
+        }
+        last = now;
+    }
+    isolation_bench_sample(stats);
+
+    stats->timer -= start.timer;
+    stats->ipi -= start.ipi;
+    stats->device -= start.device;
+    stats->softirq -= start.softirq;
+    stats->switches -= start.switches;
+    __atomic_add_fetch(&isolation_bench_done, 1, __ATOMIC_RELEASE);
+}
+
+/* Count the interruptions each isolated CPU takes while a single thread keeps it busy */
+void bench_isolation(void)
+{
+    uint32_t  cpus = get_cpu_count() ? get_cpu_count() : 1, count = 0, cpu;
+    cpumask_t isolated, online;
+    cpumask_fill(&online, cpus);
+    for (uint32_t i = 0; i < CPUMASK_WORDS; i++) isolated.bits[i] = ~housekeeping_mask()->bits[i];
+    cpumask_and(&isolated, &isolated, &online);
+    if (cpumask_empty(&isolated)) {
+        plogk("bench: isolation: No CPU isolated, boot with isolcpus= to measure.\n");
+        return;
+    }
+
+    isolation_bench_stats = (isolation_bench_stats_t *)malloc(sizeof(isolation_bench_stats_t) * cpus);
+    if (!isolation_bench_stats) return;
+    memset(isolation_bench_stats, 0, sizeof(isolation_bench_stats_t) * cpus);
+
+    /* All CPUs at once, an interruption one of them causes the others shows up as well */
+    isolation_bench_done = 0;
+    for_each_cpu(cpu, &isolated) {
+        if (thread_create_on("isolation_bench", isolation_bench_poll, &isolation_bench_stats[cpu], cpu, THREAD_PINNED)) count++;
+    }
+    while (__atomic_load_n(&isolation_bench_done, __ATOMIC_ACQUIRE) < count) thread_yield();
+
+    plogk("bench: isolation: %u ms of polling per CPU, gaps over %u ns counted.\n", ISOLATION_BENCH_TIME / 1000000, ISOLATION_BENCH_GAP);
+    for_each_cpu(cpu, &isolated) {
+        isolation_bench_stats_t *stats = &isolation_bench_stats[cpu];
+        plogk("bench: isolation: CPU %u timer %llu IPI %llu device %llu softirq %llu switches %llu, %llu gaps, longest %llu ns\n", cpu,
+              stats->timer, stats->ipi, stats->device, stats->softirq, stats->switches, stats->gaps, stats->max_gap);
+    }
+    free(isolation_bench_stats);
+}
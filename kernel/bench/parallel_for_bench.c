@@ -0,0 +1,90 @@
+/*
+ *
+ *      parallel_for_bench.c
+ *      Speedup of the parallel_for() sites
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "acpi.h"
+#include "alloc.h"
+#include "bench.h"
+#include "heap.h"
+#include "parallel_for.h"
+#include "pci.h"
+#include "printk.h"
+#include "stdint.h"
+#include "video.h"
+
+#define PFOR_BENCH_ROUNDS 4         // Runs averaged per site and CPU count
+#define PFOR_BENCH_CALLOC 0x1000000 // 16 MiB zeroed by calloc()
+
+typedef struct {
+        const char *name;
+        void (*run)(void);
+} pfor_bench_site_t;
+
+/* Clear the frame buffer */
+static void pfor_bench_video(void)
+{
+    video_clear();
+}
+
+/* Allocate and zero a large block */
+static void pfor_bench_calloc(void)
+{
+    free(calloc(1, PFOR_BENCH_CALLOC));
+}
+
+/* Scan every PCI bus, only MCFG scans are spread */
+static void pfor_bench_pci(void)
+{
+    pci_count_devices();
+}
+
+static const pfor_bench_site_t pfor_bench_sites[] = {
+    {"video_clear", pfor_bench_video},
+    {"calloc", pfor_bench_calloc},
+    {"pci_scan", pfor_bench_pci},
+};
+
+/* Double the worker count, stopping once at `max`, returns max + 1 when done */
+static uint32_t pfor_bench_next(uint32_t workers, uint32_t max)
+{
+    if (workers == max) return max + 1;
+    return workers * 2 < max ? workers * 2 : max;
+}
+
+/* Run a site with at most `workers` CPUs, returns the average time in nanoseconds */
+static uint64_t pfor_bench_round(const pfor_bench_site_t *site, uint32_t workers)
+{
+    parallel_for_set_helpers(workers - 1);
+    uint64_t start = nano_time();
+    for (uint32_t i = 0; i < PFOR_BENCH_ROUNDS; i++) site->run();
+    return (nano_time() - start) / PFOR_BENCH_ROUNDS;
+}
+
+/* Time every parallel_for() site over growing CPU counts and report the speedup over one CPU */
+void bench_parallel_for(void)
+{
+    uint32_t helpers = parallel_for_helpers();
+    uint32_t cap     = parallel_for_set_helpers(0);
+
+    plogk("bench: pfor: %u helpers, the screen is cleared while video_clear runs.\n", helpers);
+    for (uint32_t i = 0; i < sizeof(pfor_bench_sites) / sizeof(pfor_bench_sites[0]); i++) {
+        const pfor_bench_site_t *site = &pfor_bench_sites[i];
+        uint64_t                 base = pfor_bench_round(site, 1);
+        if (!base) base = 1;
+
+        /* The caller works too, so `helpers` helpers make helpers + 1 workers */
+        for (uint32_t workers = 1; workers <= helpers + 1; workers = pfor_bench_next(workers, helpers + 1)) {
+            uint64_t time    = workers == 1 ? base : pfor_bench_round(site, workers);
+            uint64_t speedup = base * 100 / (time ? time : 1);
+            plogk("bench: pfor: %-11s workers=%3u time=%8llu us speedup=%llu.%02llu\n", site->name, workers, time / 1000, BENCH_FIX2(speedup));
+        }
+    }
+    parallel_for_set_helpers(cap);
+}
@@ -0,0 +1,192 @@
+/*
+ *
+ *      rcu_bench.c
+ *      RCU reader scaling against reader-writer and spin locks
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "acpi.h"
+#include "alloc.h"
+#include "bench.h"
+#include "common.h"
+#include "double_list.h"
+#include "printk.h"
+#include "rcu.h"
+#include "rwlock.h"
+#include "sched.h"
+#include "smp.h"
+#include "spin_lock.h"
+#include "stdint.h"
+
+#define RCU_BENCH_KEYS 32     // Entries in the looked-up list
+#define RCU_BENCH_OPS  100000 // Lookups per thread
+#define RCU_BENCH_SYNC 64     // synchronize_rcu() calls timed
+
+typedef enum {
+    RCU_BENCH_RCU,
+    RCU_BENCH_RWLOCK,
+    RCU_BENCH_SPINLOCK,
+} rcu_bench_mode_t;
+
+typedef struct rcu_bench_entry {
+        ilist_node_t node;
+        uint64_t     key;
+        uint64_t     value;
+        rcu_head_t   rcu;
+} rcu_bench_entry_t;
+
+static const char *rcu_bench_names[] = {"rcu", "rwlock", "spinlock"};
+
+static ilist_node_t      rcu_bench_list;
+static rwlock_t          rcu_bench_rwlock = RWLOCK_INIT(0);
+static spinlock_t        rcu_bench_lock   = SPINLOCK_INIT(0);
+static rcu_bench_mode_t  rcu_bench_mode;
+static volatile uint64_t rcu_bench_ready;
+static volatile uint64_t rcu_bench_go;
+static volatile uint64_t rcu_bench_done;
+static volatile uint64_t rcu_bench_sum; // Keeps the lookups from being optimized out
+
+/* Walk the list for a key, the caller holds whatever protects it */
+static uint64_t rcu_bench_lookup(uint64_t key)
+{
+    ilist_node_t *pos;
+    ilist_for_each_rcu(pos, &rcu_bench_list) {
+        rcu_bench_entry_t *entry = ilist_entry(pos, rcu_bench_entry_t, node);
+        if (entry->key == key) return entry->value;
+    }
+    return 0;
+}
+
+/* Look keys up under the mode's read-side protection once every thread is ready */
+static void rcu_bench_worker(void *arg)
+{
+    pointer_cast_t cast;
+    uint64_t       sum = 0;
+    cast.ptr           = arg;
+
+    __atomic_add_fetch(&rcu_bench_ready, 1, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(&rcu_bench_go, __ATOMIC_ACQUIRE)) __asm__ volatile("pause");
+
+    for (uint32_t i = 0; i < RCU_BENCH_OPS; i++) {
+        uint64_t key = (cast.val + i) % RCU_BENCH_KEYS;
+        if (rcu_bench_mode == RCU_BENCH_RCU) {
+            rcu_read_lock();
+            sum += rcu_bench_lookup(key);
+            rcu_read_unlock();
+        } else if (rcu_bench_mode == RCU_BENCH_RWLOCK) {
+            read_lock(&rcu_bench_rwlock);
+            sum += rcu_bench_lookup(key);
+            read_unlock(&rcu_bench_rwlock);
+        } else {
+            uint64_t flags = spin_lock_irqsave(&rcu_bench_lock);
+            sum += rcu_bench_lookup(key);
+            spin_unlock_irqrestore(&rcu_bench_lock, flags);
+        }
+    }
+    __atomic_add_fetch(&rcu_bench_sum, sum, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&rcu_bench_done, 1, __ATOMIC_RELEASE);
+}
+
+/* Run one reader per CPU on `count` CPUs, returns the wall time in nanoseconds */
+static uint64_t rcu_bench_round(rcu_bench_mode_t mode, uint32_t count)
+{
+    pointer_cast_t cast;
+
+    rcu_bench_mode  = mode;
+    rcu_bench_ready = 0;
+    rcu_bench_go    = 0;
+    rcu_bench_done  = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        cast.val = i;
+        if (!thread_create_on("rcu_bench", rcu_bench_worker, cast.ptr, i, THREAD_PINNED)) return 0;
+    }
+    while (__atomic_load_n(&rcu_bench_ready, __ATOMIC_ACQUIRE) < count) thread_yield();
+
+    uint64_t start = nano_time();
+    __atomic_store_n(&rcu_bench_go, 1, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&rcu_bench_done, __ATOMIC_ACQUIRE) < count) thread_yield();
+    return nano_time() - start;
+}
+
+/* Free an entry retired by the update test */
+static void rcu_bench_free(rcu_head_t *head)
+{
+    free(ilist_entry(head, rcu_bench_entry_t, rcu));
+}
+
+/* Replace entries one at a time and time the grace period each waits for */
+static void rcu_bench_update(void)
+{
+    uint64_t total = 0, max = 0;
+    for (uint32_t i = 0; i < RCU_BENCH_SYNC; i++) {
+        rcu_bench_entry_t *entry = (rcu_bench_entry_t *)malloc(sizeof(rcu_bench_entry_t));
+        if (!entry) break;
+        entry->key   = i % RCU_BENCH_KEYS;
+        entry->value = i + 1;
+
+        /* Writers still serialize among themselves */
+        uint64_t           flags = spin_lock_irqsave(&rcu_bench_lock);
+        rcu_bench_entry_t *old   = ilist_entry(rcu_bench_list.next, rcu_bench_entry_t, node);
+        ilist_remove_rcu(&old->node);
+        ilist_insert_before_rcu(&rcu_bench_list, &entry->node);
+        spin_unlock_irqrestore(&rcu_bench_lock, flags);
+
+        uint64_t start = nano_time();
+        synchronize_rcu();
+        uint64_t spent = nano_time() - start;
+        total += spent;
+        if (spent > max) max = spent;
+        free(old);
+    }
+    plogk("bench: rcu: synchronize_rcu() avg %llu us, max %llu us over %u updates.\n", total / RCU_BENCH_SYNC / 1000,
+          max / 1000, RCU_BENCH_SYNC);
+}
+
+/* Measure RCU list lookups against reader-writer and spin locks over growing CPU counts */
+void bench_rcu(void)
+{
+    uint32_t cpus = get_cpu_count() ? get_cpu_count() : 1;
+
+    ilist_init(&rcu_bench_list);
+    for (uint32_t i = 0; i < RCU_BENCH_KEYS; i++) {
+        rcu_bench_entry_t *entry = (rcu_bench_entry_t *)malloc(sizeof(rcu_bench_entry_t));
+        if (!entry) {
+            plogk("bench: rcu: Cannot allocate the list.\n");
+            return;
+        }
+        entry->key   = i;
+        entry->value = i + 1;
+        ilist_insert_before_rcu(&rcu_bench_list, &entry->node);
+    }
+    plogk("bench: rcu: %u CPUs, %u lookups per thread in a %u entry list.\n", cpus, RCU_BENCH_OPS, RCU_BENCH_KEYS);
+
+    for (uint32_t mode = RCU_BENCH_RCU; mode <= RCU_BENCH_SPINLOCK; mode++) {
+        uint64_t base = 0;
+        for (uint32_t count = 1; count <= cpus; count *= 2) {
+            uint64_t time = rcu_bench_round((rcu_bench_mode_t)mode, count);
+            if (!time) {
+                plogk("bench: rcu: Cannot create reader threads.\n");
+                return;
+            }
+
+            /* Lookups per second and the speedup over one reader, x100 */
+            uint64_t rate = (uint64_t)RCU_BENCH_OPS * count * 1000000000 / time;
+            if (!base) base = rate;
+            uint64_t scale = rate * 100 / base;
+            plogk("bench: rcu: %-8s readers=%3u %10llu lookups/s scaling x%llu.%02llu\n", rcu_bench_names[mode], count,
+                  rate, BENCH_FIX2(scale));
+        }
+    }
+    rcu_bench_update();
+
+    /* Hand the remaining entries to call_rcu() the way a real writer would */
+    while (!ilist_is_empty(&rcu_bench_list)) {
+        rcu_bench_entry_t *entry = ilist_entry(rcu_bench_list.next, rcu_bench_entry_t, node);
+        ilist_remove_rcu(&entry->node);
+        call_rcu(&entry->rcu, rcu_bench_free);
+    }
+}
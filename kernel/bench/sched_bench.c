@@ -0,0 +1,77 @@
+/*
+ *
+ *      sched_bench.c
+ *      Scheduler scaling benchmark
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "acpi.h"
+#include "bench.h"
+#include "printk.h"
+#include "sched.h"
+#include "smp.h"
+#include "stdint.h"
+
+#define SCHED_BENCH_WORK 50000000 // xorshift rounds per thread
+
+static volatile uint64_t sched_bench_done;
+static volatile uint64_t sched_bench_sink;
+
+/* A fixed amount of CPU-bound work with no shared state */
+static void sched_bench_worker(void *arg)
+{
+    pointer_cast_t cast;
+    cast.ptr       = arg;
+    uint64_t value = cast.val | 1;
+
+    for (uint64_t i = 0; i < SCHED_BENCH_WORK; i++) {
+        value ^= value << 13;
+        value ^= value >> 7;
+        value ^= value << 17;
+    }
+    __atomic_add_fetch(&sched_bench_sink, value, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&sched_bench_done, 1, __ATOMIC_RELEASE);
+}
+
+/* Run `count` workers to completion, returns the wall time in nanoseconds */
+static uint64_t sched_bench_round(uint32_t count)
+{
+    pointer_cast_t cast;
+
+    sched_bench_done = 0;
+    uint64_t start   = nano_time();
+    for (uint32_t i = 0; i < count; i++) {
+        cast.val = i + 1;
+        if (!thread_create("sched_bench", sched_bench_worker, cast.ptr)) return 0;
+    }
+    while (__atomic_load_n(&sched_bench_done, __ATOMIC_ACQUIRE) < count) thread_yield();
+    return nano_time() - start;
+}
+
+/* Spread CPU-bound threads over the run queues and report scaling */
+void bench_sched(void)
+{
+    uint32_t cpus = get_cpu_count() ? get_cpu_count() : 1;
+    uint64_t base = sched_bench_round(1);
+
+    if (!base) {
+        plogk("bench: sched: Cannot create worker threads.\n");
+        return;
+    }
+    plogk("bench: sched: %u CPUs, %u rounds of work per thread.\n", cpus, SCHED_BENCH_WORK);
+    plogk("bench: sched: threads=%3u time=%8llu us speedup=1.00 efficiency=100%%\n", 1, base / 1000);
+
+    /* Ideal scaling keeps the time flat until the threads outnumber the CPUs */
+    for (uint32_t count = 2; count <= cpus * 2; count *= 2) {
+        uint64_t time = sched_bench_round(count);
+        if (!time) break;
+        uint64_t speedup    = base * count * 100 / time;
+        uint64_t efficiency = speedup / (count < cpus ? count : cpus);
+        plogk("bench: sched: threads=%3u time=%8llu us speedup=%llu.%02llu efficiency=%llu%%\n", count, time / 1000, BENCH_FIX2(speedup),
+              efficiency);
+    }
+}
@@ -0,0 +1,93 @@
+/*
+ *
+ *      smp_call_bench.c
+ *      Cross-CPU function call latency and throughput
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "acpi.h"
+#include "bench.h"
+#include "cpumask.h"
+#include "printk.h"
+#include "sched.h"
+#include "smp.h"
+#include "stdint.h"
+#include "wait.h"
+
+#define SMP_BENCH_SYNC  2000  // Waited-for calls per target count
+#define SMP_BENCH_ASYNC 20000 // Fire-and-forget calls per target count
+
+static volatile uint64_t smp_bench_calls;
+
+/* Returns straight away, measures the call path alone */
+static void smp_bench_nop(void *info)
+{
+    (void)info;
+}
+
+/* Count one executed call */
+static void smp_bench_count(void *info)
+{
+    (void)info;
+    __atomic_add_fetch(&smp_bench_calls, 1, __ATOMIC_RELAXED);
+}
+
+/* Time calls to the CPUs in `mask` (0 for every other CPU) and print the results */
+static void smp_bench_round(const char *name, const cpumask_t *mask, uint32_t count)
+{
+    uint64_t start = nano_time();
+    for (uint32_t i = 0; i < SMP_BENCH_SYNC; i++) smp_call_function_many(mask, smp_bench_nop, 0, 1);
+    uint64_t round_trip = (nano_time() - start) / SMP_BENCH_SYNC;
+
+    /* Back-to-back asynchronous calls pile up in the queues and drain in batches */
+    uint64_t expected = (uint64_t)SMP_BENCH_ASYNC * count;
+    smp_bench_calls   = 0;
+    start             = nano_time();
+    for (uint32_t i = 0; i < SMP_BENCH_ASYNC; i++) smp_call_function_many(mask, smp_bench_count, 0, 0);
+    while (__atomic_load_n(&smp_bench_calls, __ATOMIC_ACQUIRE) < expected) __asm__ volatile("pause");
+    uint64_t time = nano_time() - start;
+
+    plogk("bench: smp_call: %-9s targets=%3u round trip %6llu ns, %9llu calls/s\n", name, count, round_trip,
+          expected * 1000000000 / (time ? time : 1));
+}
+
+/* Sweep the target counts from CPU 0, where no migration can change the calling CPU */
+static void smp_bench_worker(void *arg)
+{
+    completion_t *done = (completion_t *)arg;
+    uint32_t      cpus = get_cpu_count();
+    cpumask_t     mask;
+
+    for (uint32_t count = 1; count < cpus; count *= 2) {
+        cpumask_fill(&mask, count + 1); // CPUs 1..count, the caller is CPU 0
+        cpumask_clear_cpu(&mask, 0);
+        smp_bench_round("unicast", &mask, count);
+    }
+    smp_bench_round("broadcast", 0, cpus - 1);
+
+    complete(done);
+}
+
+/* Measure cross-CPU call round trips and throughput over growing target counts */
+void bench_smp_call(void)
+{
+    uint32_t cpus = get_cpu_count();
+    if (cpus < 2) {
+        plogk("bench: smp_call: Needs at least 2 CPUs.\n");
+        return;
+    }
+    plogk("bench: smp_call: %u CPUs, %u synchronous and %u asynchronous calls per round.\n", cpus, SMP_BENCH_SYNC,
+          SMP_BENCH_ASYNC);
+
+    completion_t done;
+    init_completion(&done);
+    if (!thread_create_on("smp_call_bench", smp_bench_worker, &done, 0, THREAD_PINNED)) {
+        plogk("bench: smp_call: Cannot create the benchmark thread.\n");
+        return;
+    }
+    wait_for_completion(&done);
+}
@@ -0,0 +1,156 @@
+/*
+ *
+ *      spinlock_bench.c
+ *      Queued spinlock against the previous xchg lock
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "acpi.h"
+#include "alloc.h"
+#include "bench.h"
+#include "common.h"
+#include "printk.h"
+#include "sched.h"
+#include "smp.h"
+#include "spin_lock.h"
+#include "stdint.h"
+
+#define LOCK_BENCH_OPS  200000 // Lock/unlock pairs per thread
+#define LOCK_BENCH_HOLD 16     // Shared cache line updates inside each critical section
+
+/* The previous lock, an xchg loop that keeps the saved RFLAGS in the lock itself */
+typedef struct {
+        volatile uint64_t lock;
+        uint64_t          rflags;
+} legacy_spinlock_t;
+
+extern spinlock_t printk_lock;
+extern spinlock_t superblock_lock;
+
+static legacy_spinlock_t legacy_lock;
+static spinlock_t       *lock_bench_lock; // 0 runs the previous lock
+static volatile uint64_t lock_bench_shared[8];
+static volatile uint64_t lock_bench_ready;
+static volatile uint64_t lock_bench_go;
+static volatile uint64_t lock_bench_done;
+static uint64_t         *lock_bench_finish; // nano_time() each thread finished at
+
+/* Lock the previous way */
+static void legacy_spin_lock(legacy_spinlock_t *lock)
+{
+    __asm__ volatile("pushfq; pop %0; cli" : "=r"(lock->rflags));
+    while (1) {
+        uint64_t desired = 1;
+        __asm__ volatile("lock xchg %[desired], %[lock];" : [lock] "+m"(lock->lock), [desired] "+r"(desired)::"memory");
+        if (!desired) break;
+        __asm__ volatile("pause");
+    }
+}
+
+/* Unlock the previous way */
+static void legacy_spin_unlock(legacy_spinlock_t *lock)
+{
+    lock->lock = 0;
+    __asm__ volatile("push %0; popfq" ::"r"(lock->rflags));
+}
+
+/* A short critical section that moves one shared cache line between CPUs */
+static inline void lock_bench_section(void)
+{
+    for (uint32_t i = 0; i < LOCK_BENCH_HOLD; i++) lock_bench_shared[i & 7]++;
+}
+
+/* Hammer the lock under test once every thread is ready */
+static void lock_bench_worker(void *arg)
+{
+    pointer_cast_t cast;
+    cast.ptr = arg;
+
+    __atomic_add_fetch(&lock_bench_ready, 1, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(&lock_bench_go, __ATOMIC_ACQUIRE)) __asm__ volatile("pause");
+
+    for (uint32_t i = 0; i < LOCK_BENCH_OPS; i++) {
+        if (lock_bench_lock) {
+            uint64_t flags = spin_lock_irqsave(lock_bench_lock);
+            lock_bench_section();
+            spin_unlock_irqrestore(lock_bench_lock, flags);
+        } else {
+            legacy_spin_lock(&legacy_lock);
+            lock_bench_section();
+            legacy_spin_unlock(&legacy_lock);
+        }
+    }
+    lock_bench_finish[cast.val] = nano_time();
+    __atomic_add_fetch(&lock_bench_done, 1, __ATOMIC_RELEASE);
+}
+
+/* Run one thread per CPU on `count` CPUs, returns the wall time and the finish spread in nanoseconds */
+static uint64_t lock_bench_round(spinlock_t *lock, uint32_t count, uint64_t *spread)
+{
+    pointer_cast_t cast;
+
+    lock_bench_lock  = lock;
+    lock_bench_ready = 0;
+    lock_bench_go    = 0;
+    lock_bench_done  = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        cast.val = i;
+        if (!thread_create_on("lock_bench", lock_bench_worker, cast.ptr, i, THREAD_PINNED)) return 0;
+    }
+    while (__atomic_load_n(&lock_bench_ready, __ATOMIC_ACQUIRE) < count) thread_yield();
+
+    uint64_t start = nano_time();
+    __atomic_store_n(&lock_bench_go, 1, __ATOMIC_RELEASE);
+    while (__atomic_load_n(&lock_bench_done, __ATOMIC_ACQUIRE) < count) thread_yield();
+
+    /* A fair lock lets every thread finish at about the same time */
+    uint64_t first = ~(uint64_t)0, last = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (lock_bench_finish[i] < first) first = lock_bench_finish[i];
+        if (lock_bench_finish[i] > last) last = lock_bench_finish[i];
+    }
+    *spread = last - first;
+    return last - start;
+}
+
+/* Compare both locks on one lock instance over growing CPU counts */
+static void lock_bench_compare(const char *name, spinlock_t *lock, uint32_t cpus)
+{
+    for (uint32_t count = 1; count <= cpus; count *= 2) {
+        uint64_t old_spread = 0, new_spread = 0;
+        uint64_t old_time = lock_bench_round(0, count, &old_spread);
+        uint64_t new_time = lock_bench_round(lock, count, &new_spread);
+        if (!old_time || !new_time) {
+            plogk("bench: spinlock: Cannot create worker threads.\n");
+            return;
+        }
+
+        uint64_t ops = (uint64_t)LOCK_BENCH_OPS * count;
+        plogk("bench: spinlock: %-15s cpus=%3u xchg %5llu ns/op spread=%7llu us, queued %5llu ns/op spread=%7llu us\n", name,
+              count, old_time / ops, old_spread / 1000, new_time / ops, new_spread / 1000);
+    }
+}
+
+/* Measure the queued spinlock against the previous xchg lock */
+void bench_spinlock(void)
+{
+    uint32_t cpus = get_cpu_count() ? get_cpu_count() : 1;
+
+    lock_bench_finish = (uint64_t *)malloc(sizeof(uint64_t) * cpus);
+    if (!lock_bench_finish) {
+        plogk("bench: spinlock: Cannot allocate the result table.\n");
+        return;
+    }
+    plogk("bench: spinlock: %u CPUs, %u lock/unlock pairs per thread.\n", cpus, LOCK_BENCH_OPS);
+
+    lockstat_reset();
+    lock_bench_compare("printk_lock", &printk_lock, cpus);
+    lock_bench_compare("superblock_lock", &superblock_lock, cpus); // Only its writers lock
+    lockstat_print();
+
+    free(lock_bench_finish);
+}
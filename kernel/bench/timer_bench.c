@@ -0,0 +1,110 @@
+/*
+ *
+ *      timer_bench.c
+ *      Timer wheel and hrtimer arm/cancel benchmark
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "acpi.h"
+#include "alloc.h"
+#include "bench.h"
+#include "hrtimer.h"
+#include "printk.h"
+#include "stdint.h"
+#include "timer.h"
+
+#define TIMER_BENCH_CYCLES     1000000 // Arm/cancel pairs per structure
+#define TIMER_BENCH_BACKGROUND 1024    // Far-future timers keeping the structures populated
+
+/* Never runs, every timer is cancelled first */
+static void timer_bench_func(timer_list_t *timer)
+{
+    (void)timer;
+}
+
+/* Never runs, every timer is cancelled first */
+static hrtimer_restart_t hrtimer_bench_func(hrtimer_t *timer)
+{
+    (void)timer;
+    return HRTIMER_NORESTART;
+}
+
+/* Spread of expiries over every wheel level, from a multiplicative hash */
+static inline uint64_t timer_bench_delta(uint64_t i, uint64_t range)
+{
+    return (i * 2654435761u) % range + 1;
+}
+
+/* Arm and cancel wheel timers, returns the wall time in nanoseconds */
+static uint64_t timer_bench_wheel(timer_list_t *background)
+{
+    timer_list_t timer;
+    uint64_t     now = jiffies_now();
+
+    timer_setup(&timer, timer_bench_func);
+    for (uint32_t i = 0; i < TIMER_BENCH_BACKGROUND; i++) {
+        timer_setup(&background[i], timer_bench_func);
+        add_timer(&background[i], now + 1000000 + timer_bench_delta(i, 1000000));
+    }
+
+    uint64_t start = nano_time();
+    for (uint64_t i = 0; i < TIMER_BENCH_CYCLES; i++) {
+        add_timer(&timer, now + timer_bench_delta(i, WHEEL_TIMEOUT_MAX / 2));
+        del_timer(&timer);
+    }
+    uint64_t time = nano_time() - start;
+
+    for (uint32_t i = 0; i < TIMER_BENCH_BACKGROUND; i++) del_timer(&background[i]);
+    return time;
+}
+
+/* Arm and cancel hrtimers, returns the wall time in nanoseconds */
+static uint64_t timer_bench_hrtimer(hrtimer_t *background)
+{
+    hrtimer_t timer;
+    uint64_t  now = nano_time();
+
+    hrtimer_setup(&timer, hrtimer_bench_func);
+    for (uint32_t i = 0; i < TIMER_BENCH_BACKGROUND; i++) {
+        hrtimer_setup(&background[i], hrtimer_bench_func);
+        hrtimer_start(&background[i], now + 3600000000000 + timer_bench_delta(i, 1000000000));
+    }
+
+    uint64_t start = nano_time();
+    for (uint64_t i = 0; i < TIMER_BENCH_CYCLES; i++) {
+        hrtimer_start(&timer, now + 1000000000 + timer_bench_delta(i, 1000000000));
+        hrtimer_try_cancel(&timer);
+    }
+    uint64_t time = nano_time() - start;
+
+    for (uint32_t i = 0; i < TIMER_BENCH_BACKGROUND; i++) hrtimer_try_cancel(&background[i]);
+    return time;
+}
+
+/* Measure timer wheel and hrtimer arm/cancel cycles */
+void bench_timer(void)
+{
+    timer_list_t *wheel_background = (timer_list_t *)malloc(sizeof(timer_list_t) * TIMER_BENCH_BACKGROUND);
+    hrtimer_t    *hr_background    = (hrtimer_t *)malloc(sizeof(hrtimer_t) * TIMER_BENCH_BACKGROUND);
+
+    if (!wheel_background || !hr_background) {
+        plogk("bench: timer: Cannot allocate the background timers.\n");
+        if (wheel_background) free(wheel_background);
+        if (hr_background) free(hr_background);
+        return;
+    }
+    plogk("bench: timer: %u arm/cancel cycles, %u background timers.\n", TIMER_BENCH_CYCLES, TIMER_BENCH_BACKGROUND);
+
+    uint64_t wheel = timer_bench_wheel(wheel_background);
+    plogk("bench: timer: wheel   time=%8llu us cycle=%4llu ns\n", wheel / 1000, wheel / TIMER_BENCH_CYCLES);
+
+    uint64_t hr = timer_bench_hrtimer(hr_background);
+    plogk("bench: timer: hrtimer time=%8llu us cycle=%4llu ns\n", hr / 1000, hr / TIMER_BENCH_CYCLES);
+
+    free(wheel_background);
+    free(hr_background);
+}
@@ -0,0 +1,89 @@
+/*
+ *
+ *      workqueue_bench.c
+ *      Workqueue latency and throughput benchmark
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "acpi.h"
+#include "bench.h"
+#include "printk.h"
+#include "sched.h"
+#include "smp.h"
+#include "stdint.h"
+#include "workqueue.h"
+
+#define WQ_BENCH_LATENCY_ROUNDS 256  // Items queued one at a time per CPU
+#define WQ_BENCH_BATCH          4096 // Items in flight for the throughput run
+
+static work_t            wq_bench_items[WQ_BENCH_BATCH];
+static volatile uint64_t wq_bench_done;
+static volatile uint64_t wq_bench_latency;
+
+/* Record how long the item waited between enqueue and execution */
+static void wq_bench_func(work_t *work)
+{
+    wq_bench_latency = nano_time() - work->queued_at;
+    __atomic_add_fetch(&wq_bench_done, 1, __ATOMIC_RELEASE);
+}
+
+/* Wait until `count` items have run */
+static void wq_bench_wait(uint64_t count)
+{
+    while (__atomic_load_n(&wq_bench_done, __ATOMIC_ACQUIRE) < count) thread_yield();
+}
+
+/* Queue single items on one CPU and report the latency spread */
+static void wq_bench_latency_cpu(uint32_t cpu)
+{
+    uint64_t min = ~(uint64_t)0, max = 0, sum = 0;
+
+    wq_bench_done = 0;
+    for (uint32_t i = 0; i < WQ_BENCH_LATENCY_ROUNDS; i++) {
+        init_work(&wq_bench_items[0], wq_bench_func);
+        queue_work_on(cpu, system_wq, &wq_bench_items[0]);
+        wq_bench_wait(i + 1);
+        flush_work(&wq_bench_items[0]);
+
+        uint64_t latency = wq_bench_latency;
+        sum += latency;
+        if (latency < min) min = latency;
+        if (latency > max) max = latency;
+    }
+    plogk("bench: workqueue: cpu=%3u %s latency avg=%6llu ns min=%6llu ns max=%8llu ns\n", cpu,
+          cpu == get_current_cpu_id() ? "local " : "remote", sum / WQ_BENCH_LATENCY_ROUNDS, min, max);
+}
+
+/* Queue a batch spread over `cpus` CPUs, returns items per second */
+static uint64_t wq_bench_throughput(workqueue_t *wq, uint32_t cpus)
+{
+    wq_bench_done  = 0;
+    uint64_t start = nano_time();
+    for (uint32_t i = 0; i < WQ_BENCH_BATCH; i++) {
+        init_work(&wq_bench_items[i], wq_bench_func);
+        queue_work_on(i % cpus, wq, &wq_bench_items[i]);
+    }
+    wq_bench_wait(WQ_BENCH_BATCH);
+    flush_workqueue(wq);
+
+    uint64_t time = nano_time() - start;
+    return time ? (uint64_t)WQ_BENCH_BATCH * 1000000000 / time : 0;
+}
+
+/* Measure workqueue enqueue-to-execution latency and throughput */
+void bench_workqueue(void)
+{
+    uint32_t cpus = get_cpu_count() ? get_cpu_count() : 1;
+
+    plogk("bench: workqueue: %u CPUs, %u latency rounds, batch of %u items.\n", cpus, WQ_BENCH_LATENCY_ROUNDS, WQ_BENCH_BATCH);
+    for (uint32_t cpu = 0; cpu < cpus; cpu++) wq_bench_latency_cpu(cpu);
+
+    /* Bound pools scale with the CPUs that receive items, the unbound pool shares one list */
+    for (uint32_t count = 1; count <= cpus; count *= 2)
+        plogk("bench: workqueue: bound   cpus=%3u throughput=%8llu items/s\n", count, wq_bench_throughput(system_wq, count));
+    plogk("bench: workqueue: unbound cpus=%3u throughput=%8llu items/s\n", cpus, wq_bench_throughput(system_unbound_wq, cpus));
+}
@@ -17,6 +17,12 @@ void cpuid(uint32_t code, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t
     __asm__ volatile("cpuid" : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx) : "a"(code) : "memory");
 }
 
+/* Get a sub-leaf of CPUID */
+void cpuid_count(uint32_t code, uint32_t subleaf, uint32_t *eax, uint32_t *ebx, uint32_t *ecx, uint32_t *edx) // NOLINT
+{
+    __asm__ volatile("cpuid" : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx) : "a"(code), "c"(subleaf) : "memory");
+}
+
 /* Get CPU manufacturer name */
 char *get_vendor_name(void)
 {
@@ -166,3 +172,37 @@ int cpu_support_avx2(void)
     cpuid(0x00000007, &eax, &ebx, &ecx, &edx);
     return ((ebx & (1 << 5)) != 0);
 }
+
+/* Check CPU supports CLFLUSH */
+int cpu_support_clflush(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(0x00000001, &eax, &ebx, &ecx, &edx);
+    return ((edx & (1 << 19)) != 0);
+}
+
+/* Check CPU supports the TSC-deadline timer mode */
+int cpu_support_tsc_deadline(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(0x00000001, &eax, &ebx, &ecx, &edx);
+    return ((ecx & (1 << 24)) != 0);
+}
+
+/* Check CPU has an invariant TSC */
+int cpu_support_invariant_tsc(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(0x80000000, &eax, &ebx, &ecx, &edx);
+    if (eax < 0x80000007) return 0;
+    cpuid(0x80000007, &eax, &ebx, &ecx, &edx);
+    return ((edx & (1 << 8)) != 0);
+}
+
+/* Get the CLFLUSH line size in bytes */
+uint32_t get_cpu_clflush_size(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(0x00000001, &eax, &ebx, &ecx, &edx);
+    return ((ebx >> 8) & 0xff) * 8;
+}
@@ -0,0 +1,134 @@
+/*
+ *
+ *      cpumask.c
+ *      CPU sets
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "cpumask.h"
+#include "stdint.h"
+
+/* Remove every CPU from a mask */
+void cpumask_clear(cpumask_t *mask)
+{
+    for (uint32_t i = 0; i < CPUMASK_WORDS; i++) mask->bits[i] = 0;
+}
+
+/* Put CPUs 0 to count - 1 in a mask and nothing else */
+void cpumask_fill(cpumask_t *mask, uint32_t count)
+{
+    if (count > CPUMASK_BITS) count = CPUMASK_BITS;
+    for (uint32_t i = 0; i < CPUMASK_WORDS; i++) {
+        if (count >= (i + 1) * 64)
+            mask->bits[i] = ~(uint64_t)0;
+        else if (count > i * 64)
+            mask->bits[i] = ((uint64_t)1 << (count - i * 64)) - 1;
+        else
+            mask->bits[i] = 0;
+    }
+}
+
+/* Add a CPU to a mask */
+void cpumask_set_cpu(cpumask_t *mask, uint32_t cpu)
+{
+    if (cpu < CPUMASK_BITS) mask->bits[cpu / 64] |= (uint64_t)1 << (cpu % 64);
+}
+
+/* Remove a CPU from a mask */
+void cpumask_clear_cpu(cpumask_t *mask, uint32_t cpu)
+{
+    if (cpu < CPUMASK_BITS) mask->bits[cpu / 64] &= ~((uint64_t)1 << (cpu % 64));
+}
+
+/* Check whether a CPU is in a mask */
+int cpumask_test_cpu(const cpumask_t *mask, uint32_t cpu)
+{
+    return cpu < CPUMASK_BITS && (mask->bits[cpu / 64] >> (cpu % 64)) & 1;
+}
+
+/* Returns the number of CPUs in a mask */
+uint32_t cpumask_weight(const cpumask_t *mask)
+{
+    uint32_t weight = 0;
+    for (uint32_t i = 0; i < CPUMASK_WORDS; i++)
+        for (uint64_t bits = mask->bits[i]; bits; bits &= bits - 1) weight++; // No libgcc for __builtin_popcountll
+    return weight;
+}
+
+/* Returns the lowest CPU in a mask, CPUMASK_BITS if it is empty */
+uint32_t cpumask_first(const cpumask_t *mask)
+{
+    for (uint32_t i = 0; i < CPUMASK_WORDS; i++)
+        if (mask->bits[i]) return i * 64 + __builtin_ctzll(mask->bits[i]);
+    return CPUMASK_BITS;
+}
+
+/* Returns the lowest CPU above `cpu` in a mask, CPUMASK_BITS if there is none */
+uint32_t cpumask_next(const cpumask_t *mask, uint32_t cpu)
+{
+    if (++cpu >= CPUMASK_BITS) return CPUMASK_BITS;
+
+    uint32_t word = cpu / 64;
+    uint64_t bits = mask->bits[word] & (~(uint64_t)0 << (cpu % 64));
+    while (1) {
+        if (bits) return word * 64 + __builtin_ctzll(bits);
+        if (++word >= CPUMASK_WORDS) return CPUMASK_BITS;
+        bits = mask->bits[word];
+    }
+}
+
+/* Store the CPUs in both masks */
+void cpumask_and(cpumask_t *dst, const cpumask_t *a, const cpumask_t *b)
+{
+    for (uint32_t i = 0; i < CPUMASK_WORDS; i++) dst->bits[i] = a->bits[i] & b->bits[i];
+}
+
+/* Store the CPUs in either mask */
+void cpumask_or(cpumask_t *dst, const cpumask_t *a, const cpumask_t *b)
+{
+    for (uint32_t i = 0; i < CPUMASK_WORDS; i++) dst->bits[i] = a->bits[i] | b->bits[i];
+}
+
+/* Check whether two masks hold the same CPUs */
+int cpumask_equal(const cpumask_t *a, const cpumask_t *b)
+{
+    for (uint32_t i = 0; i < CPUMASK_WORDS; i++)
+        if (a->bits[i] != b->bits[i]) return 0;
+    return 1;
+}
+
+/* Check whether a mask holds no CPU */
+int cpumask_empty(const cpumask_t *mask)
+{
+    for (uint32_t i = 0; i < CPUMASK_WORDS; i++)
+        if (mask->bits[i]) return 0;
+    return 1;
+}
+
+/* Fill a mask from a CPU list such as "1,3-5", returns 1 on a malformed list */
+int cpumask_parse(cpumask_t *mask, const char *list)
+{
+    cpumask_clear(mask);
+    while (*list) {
+        uint32_t first = 0, last;
+        if (*list < '0' || *list > '9') return 1;
+        while (*list >= '0' && *list <= '9') first = first * 10 + (uint32_t)(*list++ - '0');
+        last = first;
+        if (*list == '-') {
+            list++;
+            if (*list < '0' || *list > '9') return 1;
+            for (last = 0; *list >= '0' && *list <= '9';) last = last * 10 + (uint32_t)(*list++ - '0');
+        }
+        if (first > last || last >= CPUMASK_BITS) return 1;
+        for (uint32_t cpu = first; cpu <= last; cpu++) cpumask_set_cpu(mask, cpu);
+        if (*list == ',')
+            list++;
+        else if (*list)
+            return 1;
+    }
+    return 0;
+}
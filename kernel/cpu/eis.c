@@ -9,6 +9,7 @@
  *
  */
 
+#include "eis.h"
 #include "cpuid.h"
 #include "stdint.h"
 
@@ -48,19 +49,45 @@ void init_sse(void)
 #endif
 }
 
-/* Initialize the AVX, including AVX2 (if any) */
+/* Initialize XSAVE with the x87 and SSE state components (if any) */
+void init_xsave(void)
+{
+#if CPU_FEATURE_SSE
+    uint32_t eax, ebx, ecx, edx;
+    cpuid(0x00000001, &eax, &ebx, &ecx, &edx);
+    if (!(ecx & (1 << 26))) return; // No XSAVE, threads fall back to FXSAVE
+
+    uint64_t cr4;
+    uint64_t xcr0 = XFEATURE_X87 | XFEATURE_SSE;
+    __asm__ volatile("mov %%cr4, %0" : "=r"(cr4)::"memory");
+
+    cr4 |= CR4_OSXSAVE; // OSXSAVE = 1
+
+    __asm__ volatile("mov %0, %%cr4" ::"r"(cr4) : "memory");
+    __asm__ volatile("xsetbv" ::"a"((uint32_t)xcr0), "d"((uint32_t)(xcr0 >> 32)), "c"(0) : "memory");
+#else
+    return;
+#endif
+}
+
+/* Initialize the AVX, including AVX2 and the AVX-512 state (if any) */
 void init_avx(void)
 {
 #if CPU_FEATURE_AVX
     if (!cpu_support_avx()) return;
 
     uint64_t cr4;
-    uint64_t xcr0 = 0x7;
     __asm__ volatile("mov %%cr4, %0" : "=r"(cr4)::"memory");
+    if (!(cr4 & CR4_OSXSAVE)) return; // AVX state can only be managed through XSAVE
 
-    cr4 |= (1 << 18); // OSXSAVE = 1
+    uint32_t eax, ebx, ecx, edx, xcr0_low, xcr0_high;
+    cpuid_count(0x0000000d, 0, &eax, &ebx, &ecx, &edx);
+    uint64_t supported = ((uint64_t)edx << 32) | eax;
+
+    __asm__ volatile("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+    uint64_t xcr0 = ((uint64_t)xcr0_high << 32) | xcr0_low | XFEATURE_AVX;
+    if ((supported & XFEATURE_AVX512) == XFEATURE_AVX512) xcr0 |= XFEATURE_AVX512;
 
-    __asm__ volatile("mov %0, %%cr4" ::"r"(cr4) : "memory");
     __asm__ volatile("xsetbv" ::"a"((uint32_t)xcr0), "d"((uint32_t)(xcr0 >> 32)), "c"(0) : "memory");
 #else
     return;
@@ -0,0 +1,241 @@
+/*
+ *
+ *      fpu.c
+ *      Extended processor state
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "fpu.h"
+#include "alloc.h"
+#include "common.h"
+#include "cpuid.h"
+#include "debug.h"
+#include "eis.h"
+#include "interrupt.h"
+#include "percpu.h"
+#include "printk.h"
+#include "sched.h"
+#include "smp.h"
+#include "stddef.h"
+#include "stdint.h"
+#include "string.h"
+
+#define RFLAGS_IF (1 << 9)
+#define CR0_TS    (1 << 3)
+
+#define XSAVE_HEADER_OFFSET 512
+#define XCOMP_BV_COMPACTED  (1ULL << 63)
+
+#define KERNEL_FPU_NONE  0 // No section on this CPU
+#define KERNEL_FPU_SAVED 1 // The registers were live, restore them at the end
+#define KERNEL_FPU_TRAP  2 // TS was set, nothing live to restore, set it again at the end
+
+static const char *fpu_save_names[] = {"fxsave", "xsave", "xsaveopt", "xsaves"};
+
+static fpu_save_mode_t fpu_save_mode = FPU_FXSAVE;
+static uint64_t        fpu_xfeatures = XFEATURE_X87 | XFEATURE_SSE; // Requested-feature bitmap of every save
+static size_t          fpu_size      = 512;
+static uint8_t        *fpu_init_state; // Copied into every new state area
+
+/* Save the extended state into an area */
+static void fpu_save(uint8_t *state)
+{
+    uint32_t low  = (uint32_t)fpu_xfeatures;
+    uint32_t high = (uint32_t)(fpu_xfeatures >> 32);
+    switch (fpu_save_mode) {
+        case FPU_XSAVES :
+            __asm__ volatile("xsaves64 (%0)" ::"r"(state), "a"(low), "d"(high) : "memory");
+            break;
+        case FPU_XSAVEOPT :
+            __asm__ volatile("xsaveopt64 (%0)" ::"r"(state), "a"(low), "d"(high) : "memory");
+            break;
+        case FPU_XSAVE :
+            __asm__ volatile("xsave64 (%0)" ::"r"(state), "a"(low), "d"(high) : "memory");
+            break;
+        default :
+            __asm__ volatile("fxsave64 (%0)" ::"r"(state) : "memory");
+            break;
+    }
+}
+
+/* Load the extended state from an area */
+static void fpu_restore(uint8_t *state)
+{
+    uint32_t low  = (uint32_t)fpu_xfeatures;
+    uint32_t high = (uint32_t)(fpu_xfeatures >> 32);
+    switch (fpu_save_mode) {
+        case FPU_XSAVES :
+            __asm__ volatile("xrstors64 (%0)" ::"r"(state), "a"(low), "d"(high) : "memory");
+            break;
+        case FPU_XSAVEOPT :
+        case FPU_XSAVE :
+            __asm__ volatile("xrstor64 (%0)" ::"r"(state), "a"(low), "d"(high) : "memory");
+            break;
+        default :
+            __asm__ volatile("fxrstor64 (%0)" ::"r"(state) : "memory");
+            break;
+    }
+}
+
+/* Check whether CR0.TS is set, SIMD instructions trap to #NM while it is */
+static int fpu_trap_armed(void)
+{
+    uint64_t cr0;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+    return (cr0 & CR0_TS) != 0;
+}
+
+/* Set CR0.TS so the next SIMD instruction traps to #NM */
+static void fpu_arm_trap(void)
+{
+    uint64_t cr0;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+    if (!(cr0 & CR0_TS)) __asm__ volatile("mov %0, %%cr0" ::"r"(cr0 | CR0_TS) : "memory");
+}
+
+/* Pick the save instruction and size the per-thread state from CPUID leaf 0xd, call once on the boot CPU */
+void fpu_init(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+    uint64_t cr4;
+    __asm__ volatile("mov %%cr4, %0" : "=r"(cr4));
+
+    /* init_xsave() only sets OSXSAVE on CPUs that have XSAVE */
+    if (cr4 & CR4_OSXSAVE) {
+        uint32_t xcr0_low, xcr0_high;
+        __asm__ volatile("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+        fpu_xfeatures = ((uint64_t)xcr0_high << 32) | xcr0_low;
+
+        cpuid_count(0x0000000d, 1, &eax, &ebx, &ecx, &edx);
+        if (eax & (1 << 3)) {
+            fpu_save_mode = FPU_XSAVES;
+            fpu_size      = ebx; // Compacted size of XCR0 | IA32_XSS, no supervisor state is enabled
+        } else {
+            fpu_save_mode = (eax & (1 << 0)) ? FPU_XSAVEOPT : FPU_XSAVE;
+            cpuid_count(0x0000000d, 0, &eax, &ebx, &ecx, &edx);
+            fpu_size = ebx; // Standard size of the components enabled in XCR0
+        }
+    }
+
+    /* Default x87 control word and MXCSR, every other component in its init state */
+    fpu_init_state = (uint8_t *)aligned_alloc(64, fpu_size);
+    if (!fpu_init_state) panic("fpu: Cannot allocate the initial state.");
+    memset(fpu_init_state, 0, fpu_size);
+    *(uint16_t *)&fpu_init_state[0]  = 0x037f;
+    *(uint32_t *)&fpu_init_state[24] = 0x1f80;
+    if (fpu_save_mode == FPU_XSAVES)
+        *(uint64_t *)&fpu_init_state[XSAVE_HEADER_OFFSET + 8] = XCOMP_BV_COMPACTED | fpu_xfeatures;
+
+    this_cpu_write(fpu_kernel_state, fpu_state_alloc());
+    plogk("fpu: %s, features %#llx, %llu bytes per thread, %s switching.\n", fpu_save_names[fpu_save_mode],
+          fpu_xfeatures, fpu_size, FPU_LAZY ? "lazy" : "eager");
+}
+
+/* Allocate a state area holding the initial x87, SSE and AVX state, 0 if out of memory */
+uint8_t *fpu_state_alloc(void)
+{
+    uint8_t *state = (uint8_t *)aligned_alloc(64, fpu_size);
+    if (state) memcpy(state, fpu_init_state, fpu_size);
+    return state;
+}
+
+/* Free a state area */
+void fpu_state_free(uint8_t *state)
+{
+    free(state);
+}
+
+/* Hand the extended state over from `prev` to `next`, called by schedule() with interrupts off */
+void fpu_switch(thread_t *prev, thread_t *next)
+{
+#if FPU_LAZY
+    /* Only a thread that took the trap (or was preloaded) has live registers, save them before it can migrate */
+    uint32_t cpu = get_current_cpu_id();
+    if (this_cpu_read(fpu_owner) == prev && !fpu_trap_armed()) {
+        if (prev->state == THREAD_DEAD)
+            this_cpu_write(fpu_owner, 0);
+        else
+            fpu_save(prev->fpu_state);
+    }
+
+    /* The registers still hold next's state if nothing else was loaded here since it last ran */
+    if (this_cpu_read(fpu_owner) == next && next->fpu_cpu == cpu)
+        __asm__ volatile("clts");
+    else
+        fpu_arm_trap();
+#else
+    if (prev->state != THREAD_DEAD) fpu_save(prev->fpu_state);
+    fpu_restore(next->fpu_state);
+#endif
+}
+
+/* #NM handler, loads the current thread's state on its first SIMD use after a switch */
+INTERRUPT_BEGIN void fpu_nm_handle(interrupt_frame_t *frame)
+{
+    (void)frame;
+#if FPU_LAZY
+    __asm__ volatile("clts");
+    thread_t *current = this_cpu_read(current_thread);
+    uint32_t  cpu     = get_current_cpu_id();
+    if (!current || (this_cpu_read(fpu_owner) == current && current->fpu_cpu == cpu)) return;
+
+    fpu_restore(current->fpu_state);
+    current->fpu_cpu = cpu;
+    this_cpu_write(fpu_owner, current);
+#else
+    panic("Kernel exception: #NM");
+#endif
+}
+INTERRUPT_END
+
+/* Let the current context use SIMD registers until kernel_fpu_end(), returns 1 if it may not */
+int kernel_fpu_begin(void)
+{
+    if (!fpu_init_state) return 0; // Before fpu_init() there is no thread state to protect yet
+
+    uint64_t flags = get_rflags();
+    disable_intr();
+
+    /* One section per CPU, an interrupt that hits one has to take its scalar path */
+    uint8_t *saved = this_cpu_read(fpu_kernel_state);
+    if (this_cpu_read(kernel_fpu) != KERNEL_FPU_NONE || !saved) {
+        if (flags & RFLAGS_IF) enable_intr();
+        return 1;
+    }
+    preempt_disable();
+
+    if (fpu_trap_armed()) {
+        /* Whatever the registers hold was saved at the last switch, and they are about to be clobbered */
+        __asm__ volatile("clts");
+        this_cpu_write(fpu_owner, 0);
+        this_cpu_write(kernel_fpu, KERNEL_FPU_TRAP);
+    } else {
+        fpu_save(saved);
+        this_cpu_write(kernel_fpu, KERNEL_FPU_SAVED);
+    }
+
+    if (flags & RFLAGS_IF) enable_intr();
+    return 0;
+}
+
+/* End a kernel_fpu_begin() section and give the registers back to their owner */
+void kernel_fpu_end(void)
+{
+    if (!fpu_init_state) return;
+
+    uint64_t flags = get_rflags();
+    disable_intr();
+
+    if (this_cpu_read(kernel_fpu) == KERNEL_FPU_SAVED)
+        fpu_restore(this_cpu_read(fpu_kernel_state));
+    else
+        fpu_arm_trap(); // The current thread reloads its state on its next SIMD use
+    this_cpu_write(kernel_fpu, KERNEL_FPU_NONE);
+
+    preempt_enable();
+    if (flags & RFLAGS_IF) enable_intr();
+}
@@ -0,0 +1,173 @@
+/*
+ *
+ *      idle.c
+ *      CPU idle states
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "idle.h"
+#include "acpi.h"
+#include "alloc.h"
+#include "common.h"
+#include "cpuid.h"
+#include "percpu.h"
+#include "printk.h"
+#include "smp.h"
+#include "stdint.h"
+#include "string.h"
+#include "tick.h"
+
+#define CPUID_MONITOR       (1 << 3) // CPUID.1:ECX, MONITOR/MWAIT
+#define CPUID_MWAIT_EXT     (1 << 0) // CPUID.5:ECX, extensions enumerated
+#define CPUID_MWAIT_IRQ     (1 << 1) // CPUID.5:ECX, interrupts break MWAIT even while masked
+#define MWAIT_ECX_IRQ_BREAK (1 << 0) // MWAIT ECX, wake on a masked interrupt
+
+/* Exit latency and target residency by MWAIT C-state, estimates for when _CST has nothing to say */
+static const uint32_t idle_default_latency[8]   = {0, 2, 70, 85, 124, 200, 480, 890};
+static const uint32_t idle_default_residency[8] = {0, 2, 100, 200, 800, 800, 5000, 5000};
+
+static idle_state_t idle_states[IDLE_STATES_MAX];
+static uint32_t     idle_state_count;
+static idle_cpu_t  *idle_cpus; // Per-CPU wake flags, 0 while idling is done with HLT
+static uint32_t     idle_cpu_count;
+static int          idle_irq_break; // MWAIT can sleep with interrupts masked and still wake on one
+
+/* Check an MWAIT hint against the sub-state counts of CPUID leaf 5 */
+static int idle_hint_valid(uint32_t substates, uint32_t hint)
+{
+    uint32_t cstate = ((hint >> 4) & 0xf) + 1;
+    return cstate < 8 && (hint & 0xf) < ((substates >> (4 * cstate)) & 0xf);
+}
+
+/* Fill the state table from _CST, or from the C-states CPUID enumerates */
+static void idle_probe_states(uint32_t substates)
+{
+    acpi_cstate_t cst[IDLE_STATES_MAX];
+    uint32_t      count = acpi_cst_read(cst, IDLE_STATES_MAX);
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (!idle_hint_valid(substates, cst[i].hint)) continue;
+        idle_state_t *state     = &idle_states[idle_state_count++];
+        state->type             = cst[i].type;
+        state->hint             = cst[i].hint;
+        state->exit_latency     = cst[i].latency;
+        state->target_residency = cst[i].latency * 2;
+    }
+    if (idle_state_count) return;
+
+    /* Sub-state 0 of every C-state the processor has, C1 at least */
+    for (uint32_t cstate = 1; cstate < 8; cstate++) {
+        if (!((substates >> (4 * cstate)) & 0xf) && cstate > 1) continue;
+        idle_state_t *state     = &idle_states[idle_state_count++];
+        state->type             = cstate;
+        state->hint             = (cstate - 1) << 4;
+        state->exit_latency     = idle_default_latency[cstate];
+        state->target_residency = idle_default_residency[cstate];
+    }
+}
+
+/* Pick the deepest state whose target residency fits the idle period expected from the next timer and recent history */
+static uint32_t idle_select(idle_cpu_t *idle, uint64_t now)
+{
+    uint64_t deadline = this_cpu_read(tick_deadline);
+    uint64_t expected = idle->predicted;
+    if (deadline && deadline <= now) return 0;
+    if (deadline && deadline - now < expected) expected = deadline - now;
+
+    uint32_t index = 0;
+    for (uint32_t i = 1; i < idle_state_count; i++)
+        if ((uint64_t)idle_states[i].target_residency * 1000 <= expected) index = i;
+    return index;
+}
+
+/* Pick the idle instruction and C-states from CPUID and ACPI _CST, call once after smp_init() */
+void idle_init(void)
+{
+    uint32_t eax, ebx, ecx, edx, max_leaf;
+    cpuid(0x00000000, &max_leaf, &ebx, &ecx, &edx);
+    cpuid(0x00000001, &eax, &ebx, &ecx, &edx);
+    if (!IDLE_MWAIT || !(ecx & CPUID_MONITOR) || max_leaf < 0x05) {
+        plogk("idle: Using HLT, wakeups take an IPI.\n");
+        return;
+    }
+
+    cpuid(0x00000005, &eax, &ebx, &ecx, &edx);
+    idle_irq_break = (ecx & CPUID_MWAIT_EXT) && (ecx & CPUID_MWAIT_IRQ);
+    idle_probe_states((ecx & CPUID_MWAIT_EXT) ? edx : 0x10); // Without the extensions only C1 is known
+
+    uint32_t    cpus = get_cpu_count() ? get_cpu_count() : 1;
+    idle_cpu_t *map  = (idle_cpu_t *)aligned_alloc(64, sizeof(idle_cpu_t) * cpus);
+    if (!map) {
+        plogk("idle: Cannot allocate the wake flags, using HLT.\n");
+        return;
+    }
+    memset(map, 0, sizeof(idle_cpu_t) * cpus);
+    for (uint32_t i = 0; i < cpus; i++) map[i].predicted = TICK_PERIOD_NS;
+
+    idle_cpu_count = cpus;
+    __atomic_store_n(&idle_cpus, map, __ATOMIC_RELEASE); // CPUs already idling switch over on their next pass
+
+    for (uint32_t i = 0; i < idle_state_count; i++)
+        plogk("idle: C%u hint %#x, exit latency %u us, target residency %u us.\n", idle_states[i].type, idle_states[i].hint,
+              idle_states[i].exit_latency, idle_states[i].target_residency);
+    plogk("idle: Using MWAIT, %u states, monitor line %u bytes%s.\n", idle_state_count, ebx & 0xffff,
+          idle_irq_break ? ", masked interrupts break out" : "");
+}
+
+/* Idle the current CPU until an interrupt or a wake flag write, called with interrupts off, returns with them on */
+void idle_enter(void)
+{
+    idle_cpu_t *idle = __atomic_load_n(&idle_cpus, __ATOMIC_ACQUIRE);
+    if (!idle) {
+        __asm__ volatile("sti; hlt"); // STI holds interrupts off until HLT has started
+        return;
+    }
+    idle += get_current_cpu_id();
+
+    uint64_t start = nano_time();
+    uint32_t index = idle_select(idle, start);
+
+    /* A waker that still sees polling clear sends an IPI, which stays pending until MWAIT */
+    idle->wake = 0;
+    __atomic_store_n(&idle->polling, 1, __ATOMIC_SEQ_CST);
+    __asm__ volatile("monitor" ::"a"(&idle->wake), "c"(0), "d"(0));
+    if (!idle->wake) {
+        if (idle_irq_break)
+            __asm__ volatile("mwait" ::"a"(idle_states[index].hint), "c"(MWAIT_ECX_IRQ_BREAK) : "memory");
+        else
+            __asm__ volatile("sti; mwait" ::"a"(idle_states[index].hint), "c"(0) : "memory");
+    }
+
+    /* Pairs with idle_wake_cpu(), a waker that saw polling set has its work visible to the next check */
+    if (__atomic_exchange_n(&idle->polling, 0, __ATOMIC_SEQ_CST)) {
+        uint64_t slept = nano_time() - start;
+        idle->predicted += (int64_t)(slept - idle->predicted) >> IDLE_EMA_SHIFT;
+    }
+    if (idle->wake) idle->wakeups++;
+    idle->usage[index]++;
+    enable_intr();
+}
+
+/* Stop taking flag wakeups for the current CPU, called by schedule() when an interrupt switches away from idle_enter() */
+void idle_exit(void)
+{
+    idle_cpu_t *idle = __atomic_load_n(&idle_cpus, __ATOMIC_ACQUIRE);
+    if (idle) __atomic_store_n(&idle[get_current_cpu_id()].polling, 0, __ATOMIC_SEQ_CST); // The period measured there is not idle
+}
+
+/* Wake a CPU waiting in MWAIT by writing its flag, returns 1 if it is not waiting there and needs an IPI */
+int idle_wake_cpu(uint32_t cpu)
+{
+    idle_cpu_t *idle = __atomic_load_n(&idle_cpus, __ATOMIC_ACQUIRE);
+    if (!idle || cpu >= idle_cpu_count) return 1;
+
+    /* The work being signalled must be visible before polling is read */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&idle[cpu].polling, __ATOMIC_RELAXED)) return 1;
+    __atomic_store_n(&idle[cpu].wake, 1, __ATOMIC_RELEASE);
+    return 0;
+}
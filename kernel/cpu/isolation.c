@@ -0,0 +1,82 @@
+/*
+ *
+ *      isolation.c
+ *      CPU isolation
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "isolation.h"
+#include "apic.h"
+#include "cmdline.h"
+#include "cpumask.h"
+#include "percpu.h"
+#include "printk.h"
+#include "smp.h"
+#include "stdint.h"
+#include "topology.h"
+
+static cpumask_t isolated_mask; // Empty unless isolcpus= names a CPU
+static cpumask_t housekeeping = {.bits = {[0 ... CPUMASK_WORDS - 1] = ~(uint64_t)0}};
+
+/* Read isolcpus= from the command line, call once after smp_init() and before sched_init() */
+void isolation_init(void)
+{
+    char      list[ISOLATION_ARG_MAX];
+    cpumask_t mask, online;
+    if (cmdline_get_arg("isolcpus", list, sizeof(list))) return;
+    if (cpumask_parse(&mask, list)) {
+        plogk("isolation: Malformed CPU list \"%s\", nothing isolated.\n", list);
+        return;
+    }
+
+    /* The boot CPU runs initialization and the platform timer, it always stays for housekeeping */
+    uint32_t cpus = get_cpu_count() ? get_cpu_count() : 1;
+    cpumask_fill(&online, cpus);
+    cpumask_and(&mask, &mask, &online);
+    cpumask_clear_cpu(&mask, get_current_cpu_id());
+    if (cpumask_empty(&mask)) {
+        plogk("isolation: No CPU of \"%s\" can be isolated.\n", list);
+        return;
+    }
+
+    isolated_mask = mask;
+    for (uint32_t i = 0; i < CPUMASK_WORDS; i++) housekeeping.bits[i] = ~mask.bits[i];
+
+    /* Pins routed during ACPI setup were given every CPU */
+    for (uint32_t irq = 0; irq < IOAPIC_MAX_PINS; irq++)
+        if (ioapic_pin_routed(irq)) ioapic_set_affinity(irq, &housekeeping);
+
+    uint32_t cpu;
+    for_each_cpu(cpu, &isolated_mask) plogk("isolation: CPU %u isolated.\n", cpu);
+}
+
+/* Check whether a CPU was isolated on the command line */
+int cpu_isolated(uint32_t cpu)
+{
+    return cpumask_test_cpu(&isolated_mask, cpu);
+}
+
+/* Returns the CPUs left for the tick, unbound work, timers and device interrupts */
+const cpumask_t *housekeeping_mask(void)
+{
+    return &housekeeping;
+}
+
+/* Returns the current CPU, or the nearest housekeeping CPU if the current one is isolated */
+uint32_t housekeeping_cpu(void)
+{
+    uint32_t self = get_current_cpu_id(), cpu;
+    if (!cpu_isolated(self)) return self;
+
+    /* One sharing the cache first, the work handed over is likely still in it */
+    const cpu_topology_t *topology = cpu_topology(self);
+    if (topology) {
+        for_each_cpu(cpu, &topology->llc_mask)
+            if (cpumask_test_cpu(&housekeeping, cpu)) return cpu;
+    }
+    return cpumask_first(&housekeeping);
+}
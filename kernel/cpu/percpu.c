@@ -0,0 +1,33 @@
+/*
+ *
+ *      percpu.c
+ *      Per-CPU data area
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "percpu.h"
+#include "common.h"
+#include "stdint.h"
+
+/* The boot CPU needs its area before the heap exists */
+static percpu_t bsp_percpu;
+
+/* Returns the boot CPU's area */
+percpu_t *get_bsp_percpu(void)
+{
+    return &bsp_percpu;
+}
+
+/* Point IA32_GS_BASE of the current CPU at its area, call after every GS reload */
+void percpu_init(percpu_t *cpu)
+{
+    pointer_cast_t cast;
+
+    cpu->self = cpu;
+    cast.ptr  = cpu;
+    wrmsr(MSR_IA32_GS_BASE, cast.val);
+}
@@ -0,0 +1,62 @@
+/*
+ *
+ *      pmu.c
+ *      Performance monitoring unit
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "pmu.h"
+#include "common.h"
+#include "cpuid.h"
+#include "stdint.h"
+#include "string.h"
+
+static uint32_t pmu_version  = 0;
+static uint32_t pmu_counters = 0;
+
+/* Detect the architectural PMU, returns the number of general counters */
+uint32_t pmu_init(void)
+{
+    uint32_t eax, ebx, ecx, edx;
+
+    /* The event encodings used here are Intel specific */
+    if (strcmp(get_vendor_name(), "GenuineIntel")) return 0;
+    cpuid(0x00000000, &eax, &ebx, &ecx, &edx);
+    if (eax < 0x0a) return 0;
+
+    cpuid(0x0000000a, &eax, &ebx, &ecx, &edx);
+    pmu_version  = eax & 0xff;
+    pmu_counters = pmu_version ? (eax >> 8) & 0xff : 0;
+    return pmu_counters;
+}
+
+/* Start counting an event in kernel mode on a general counter */
+void pmu_start(uint32_t counter, uint8_t event, uint8_t umask)
+{
+    if (counter >= pmu_counters) return;
+
+    wrmsr(MSR_IA32_PERFEVTSEL0 + counter, 0);
+    wrmsr(MSR_IA32_PMC0 + counter, 0);
+    wrmsr(MSR_IA32_PERFEVTSEL0 + counter, event | ((uint64_t)umask << 8) | PMU_EVTSEL_OS | PMU_EVTSEL_EN);
+
+    /* Version 2 added a global enable that gates every counter */
+    if (pmu_version >= 2) wrmsr(MSR_IA32_PERF_GLOBAL_CTRL, rdmsr(MSR_IA32_PERF_GLOBAL_CTRL) | (1ULL << counter));
+}
+
+/* Stop a general counter */
+void pmu_stop(uint32_t counter)
+{
+    if (counter >= pmu_counters) return;
+    wrmsr(MSR_IA32_PERFEVTSEL0 + counter, 0);
+}
+
+/* Read a general counter */
+uint64_t pmu_read(uint32_t counter)
+{
+    if (counter >= pmu_counters) return 0;
+    return rdmsr(MSR_IA32_PMC0 + counter);
+}
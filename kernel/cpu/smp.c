@@ -10,38 +10,147 @@
  */
 
 #include "smp.h"
+#include "acpi.h"
 #include "alloc.h"
 #include "apic.h"
 #include "common.h"
+#include "cpumask.h"
 #include "debug.h"
 #include "eis.h"
+#include "fpu.h"
 #include "frame.h"
 #include "gdt.h"
 #include "hhdm.h"
+#include "idle.h"
 #include "interrupt.h"
 #include "limine.h"
 #include "page.h"
+#include "percpu.h"
 #include "printk.h"
 #include "rinx.h"
+#include "sched.h"
 #include "spin_lock.h"
 #include "stddef.h"
 #include "stdint.h"
 #include "stdlib.h"
 #include "string.h"
+#include "topology.h"
+
+#define RFLAGS_IF (1 << 9)
 
 static cpu_processor_t *cpus;
-static size_t           cpu_count = 0;
+static size_t           cpu_count     = 0;
+static int              ipi_broadcast = 0; // Every CPU in the system is ours, the all-but-self shorthand is usable
+static smp_call_t      *call_slots;        // cpu_count * cpu_count, indexed by sender then target
 
 static volatile uint64_t ap_ready_count = 0;
+static uint64_t          smp_start_time = 0; // nano_time() the APs were released at
 spinlock_t               ap_start_lock  = {0};
 
+/* Run the calls queued for this CPU in the order they were queued */
+static void smp_call_drain(void)
+{
+    uint64_t flags = get_rflags();
+    disable_intr();
+
+    smp_call_t *list = __atomic_exchange_n(&this_cpu()->call_queue, 0, __ATOMIC_ACQUIRE);
+    smp_call_t *fifo = 0;
+    while (list) {
+        smp_call_t *next = list->next;
+        list->next       = fifo;
+        fifo             = list;
+        list             = next;
+    }
+
+    while (fifo) {
+        smp_call_t     *call       = fifo;
+        smp_call_func_t func       = call->func;
+        void           *info       = call->info;
+        uint32_t        call_flags = call->flags;
+        fifo                       = call->next;
+
+        /* An asynchronous sender may refill the slot as soon as it is released */
+        if (!(call_flags & SMP_CALL_WAIT)) __atomic_store_n(&call->locked, 0, __ATOMIC_RELEASE);
+        func(info);
+        if (call_flags & SMP_CALL_WAIT) __atomic_store_n(&call->locked, 0, __ATOMIC_RELEASE);
+        this_cpu_inc(call_count);
+    }
+    if (flags & RFLAGS_IF) enable_intr();
+}
+
+/* Wait until the target released a call slot, serving this CPU's own calls meanwhile */
+static void smp_call_wait(smp_call_t *call)
+{
+    while (__atomic_load_n(&call->locked, __ATOMIC_ACQUIRE)) {
+        smp_call_drain(); // Two CPUs waiting on each other still make progress
+        __asm__ volatile("pause");
+    }
+}
+
+/* Queue a call from CPU `self` on CPU `cpu_id`, returns 1 if its queue was empty and it needs an IPI */
+static int smp_call_queue(uint32_t self, uint32_t cpu_id, smp_call_func_t func, void *info, int wait)
+{
+    smp_call_t *call = &call_slots[self * cpu_count + cpu_id];
+    smp_call_wait(call); // An earlier asynchronous call may still hold the slot
+
+    call->func   = func;
+    call->info   = info;
+    call->flags  = wait ? SMP_CALL_WAIT : 0;
+    call->locked = 1;
+
+    percpu_t   *target = cpus[cpu_id].percpu;
+    smp_call_t *head   = __atomic_load_n(&target->call_queue, __ATOMIC_RELAXED);
+    do call->next = head;
+    while (!__atomic_compare_exchange_n(&target->call_queue, &head, call, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    return !head;
+}
+
+/* Queue a call on every other CPU in `mask` (0 for all of them), kicking each queue that was idle */
+static void smp_call_send(const cpumask_t *mask, smp_call_func_t func, void *info, int wait)
+{
+    uint32_t self = get_current_cpu_id();
+
+    /* Everyone is a target, queue first and kick them all with one ICR write */
+    if (!mask && ipi_broadcast) {
+        for (uint32_t i = 0; i < cpu_count; i++)
+            if (i != self) smp_call_queue(self, i, func, info, wait);
+        send_ipi_all_but_self(IPI_CALL_FUNCTION | IPI_FIXED);
+        return;
+    }
+
+    for (uint32_t i = 0; i < cpu_count; i++) {
+        if (i == self || (mask && !cpumask_test_cpu(mask, i))) continue;
+        if (smp_call_queue(self, i, func, info, wait)) send_ipi(cpus[i].lapic_id, IPI_CALL_FUNCTION | IPI_FIXED | APIC_ICR_PHYSICAL);
+    }
+}
+
+/* Wait for the calls CPU `self` queued on every other CPU in `mask` (0 for all of them) */
+static void smp_call_wait_all(uint32_t self, const cpumask_t *mask)
+{
+    for (uint32_t i = 0; i < cpu_count; i++)
+        if (i != self && (!mask || cpumask_test_cpu(mask, i))) smp_call_wait(&call_slots[self * cpu_count + i]);
+}
+
+/* Cross-CPU function calls */
+INTERRUPT_BEGIN static void ipi_call_function_handler(interrupt_frame_t *frame)
+{
+    (void)frame;
+    disable_intr();
+    this_cpu_inc(ipi_count);
+    send_eoi();
+    smp_call_drain();
+    enable_intr();
+}
+INTERRUPT_END
+
 /* Rescheduling Requests */
 INTERRUPT_BEGIN static void ipi_reschedule_handler(interrupt_frame_t *frame)
 {
     (void)frame;
     disable_intr();
-    /* TODO: Handle rescheduling */
+    this_cpu_inc(ipi_count);
     send_eoi();
+    schedule();
     enable_intr();
 }
 INTERRUPT_END
@@ -51,6 +160,7 @@ INTERRUPT_BEGIN static void ipi_halt_handler(interrupt_frame_t *frame)
 {
     (void)frame;
     disable_intr();
+    this_cpu_inc(ipi_count);
     /* TODO: Handle halting */
     send_eoi();
     enable_intr();
@@ -62,7 +172,9 @@ INTERRUPT_BEGIN static void ipi_tlb_shootdown_handler(interrupt_frame_t *frame)
 {
     (void)frame;
     disable_intr();
-    /* TODO: Handle TLB shootdown */
+    this_cpu_inc(ipi_count);
+    this_cpu_inc(tlb_flush_count);
+    flush_tlb_local();
     send_eoi();
     enable_intr();
 }
@@ -73,6 +185,7 @@ INTERRUPT_BEGIN static void ipi_panic_handler(interrupt_frame_t *frame)
 {
     (void)frame;
     disable_intr();
+    this_cpu_inc(ipi_count);
     /* TODO: Handle panic */
     send_eoi();
     enable_intr();
@@ -82,9 +195,14 @@ INTERRUPT_END
 /* Send an IPI to all CPUs */
 void send_ipi_all(uint8_t vector)
 {
-    vector |= IPI_FIXED | APIC_ICR_PHYSICAL;
+    uint32_t self = get_current_cpu_id();
+
+    if (ipi_broadcast) {
+        send_ipi_all_but_self(vector | IPI_FIXED);
+        return;
+    }
     for (size_t i = 0; i < cpu_count; i++)
-        if (cpus[i].id != get_current_cpu_id()) send_ipi(cpus[i].lapic_id, vector);
+        if (cpus[i].id != self) send_ipi(cpus[i].lapic_id, vector | IPI_FIXED | APIC_ICR_PHYSICAL);
 }
 
 /* Send an IPI to the specified CPU */
@@ -94,6 +212,67 @@ void send_ipi_cpu(uint32_t cpu_id, uint8_t vector)
     if (cpu_id < cpu_count && cpu_id != get_current_cpu_id()) send_ipi(cpus[cpu_id].lapic_id, vector);
 }
 
+/* Ask another CPU to reschedule, one waiting in MWAIT is woken by a flag write instead of an IPI */
+void smp_send_reschedule(uint32_t cpu_id)
+{
+    if (cpu_id < cpu_count && cpu_id != get_current_cpu_id() && idle_wake_cpu(cpu_id)) send_ipi_cpu(cpu_id, IPI_RESCHEDULE);
+}
+
+/* Reschedule the current CPU as soon as it enables interrupts, for a preemption decided with them off */
+void smp_send_reschedule_self(void)
+{
+    send_ipi(0, IPI_RESCHEDULE | IPI_FIXED | APIC_ICR_SELF);
+}
+
+/* Run a function on a CPU with interrupts off, waiting for it if `wait` is set, returns 1 for a bad CPU */
+int smp_call_function_single(uint32_t cpu_id, smp_call_func_t func, void *info, int wait)
+{
+    /* The slots belong to this CPU, so nothing else may run on it while they are filled */
+    uint64_t flags = get_rflags();
+    disable_intr();
+    uint32_t self = get_current_cpu_id();
+    if (cpu_id != self && (!call_slots || cpu_id >= cpu_count)) {
+        if (flags & RFLAGS_IF) enable_intr();
+        return 1;
+    }
+    if (cpu_id == self) {
+        func(info);
+    } else if (smp_call_queue(self, cpu_id, func, info, wait)) {
+        send_ipi(cpus[cpu_id].lapic_id, IPI_CALL_FUNCTION | IPI_FIXED | APIC_ICR_PHYSICAL);
+    }
+    if (flags & RFLAGS_IF) enable_intr();
+
+    if (wait && cpu_id != self) smp_call_wait(&call_slots[self * cpu_count + cpu_id]);
+    return 0;
+}
+
+/* Run a function on every other CPU set in `mask` (0 for all) with interrupts off, waiting for all if `wait` is set */
+void smp_call_function_many(const cpumask_t *mask, smp_call_func_t func, void *info, int wait)
+{
+    if (!call_slots) return;
+
+    uint64_t flags = get_rflags();
+    disable_intr();
+    uint32_t self = get_current_cpu_id();
+    smp_call_send(mask, func, info, wait);
+    if (flags & RFLAGS_IF) enable_intr();
+
+    if (wait) smp_call_wait_all(self, mask);
+}
+
+/* Run a function on every CPU, the current one included, waiting for all if `wait` is set */
+void smp_call_function_all(smp_call_func_t func, void *info, int wait)
+{
+    uint64_t flags = get_rflags();
+    disable_intr();
+    uint32_t self = get_current_cpu_id();
+    if (call_slots) smp_call_send(0, func, info, wait);
+    func(info); // Overlaps with the remote calls
+    if (flags & RFLAGS_IF) enable_intr();
+
+    if (wait && call_slots) smp_call_wait_all(self, 0);
+}
+
 /* Flush TLBs of all CPUs */
 void flush_tlb_all(void)
 {
@@ -115,13 +294,18 @@ uint32_t get_cpu_count(void)
 /* Get the ID of the current CPU */
 uint32_t get_current_cpu_id(void)
 {
-    for (size_t i = 0; i < cpu_count; i++)
-        if (cpus[i].lapic_id == lapic_id()) return i;
-    return 0; // Default to CPU 0 if not found
+    return this_cpu_read(cpu_id);
+}
+
+/* Returns the per-CPU area of a CPU, the boot CPU's until SMP is up */
+percpu_t *get_cpu_percpu(uint32_t cpu_id)
+{
+    if (!cpus || cpu_id >= cpu_count) return get_bsp_percpu();
+    return cpus[cpu_id].percpu;
 }
 
 /* Initialize the TSS for the AP  */
-void ap_init_tss(cpu_processor_t *cpu)
+void ap_init_tss(percpu_t *cpu)
 {
     compiler_barrier();
     uint64_t address     = (uint64_t)(cpu->tss);
@@ -144,7 +328,7 @@ void ap_init_tss(cpu_processor_t *cpu)
 }
 
 /* Initialize the GDT for the AP */
-void ap_init_gdt(cpu_processor_t *cpu)
+void ap_init_gdt(percpu_t *cpu)
 {
     cpu->gdt->entries[0] = 0x0000000000000000; // NULL descriptor
     cpu->gdt->entries[1] = 0x00a09a0000000000; // Kernel code segment
@@ -166,25 +350,29 @@ void ap_init_gdt(cpu_processor_t *cpu)
                      "mov %[dseg], %%ss;" ::[ptr] "m"(cpu->gdt->pointer),
                      [cseg] "rm"((uint64_t)0x8), [dseg] "rm"((uint64_t)0x10)
                      : "memory");
+    percpu_init(cpu);
     ap_init_tss(cpu);
 }
 
 /* Multi-core boot entry */
 void ap_entry(struct limine_smp_info *info)
 {
+    pointer_cast_t cast;
+    cast.val      = info->extra_argument;
+    percpu_t *cpu = (percpu_t *)cast.ptr;
+    percpu_init(cpu); // this_cpu_*() is valid from here on, ap_init_gdt() points GS at it again
+
     init_fpu();
     init_sse();
+    init_xsave();
     init_avx();
 
     /* load page table */
     page_directory_t *krnl_pagedir = get_kernel_pagedir();
-    pointer_cast_t    cast;
-    cast.ptr = krnl_pagedir->table;
-    cast.ptr = virt_to_phys(cast.val);
+    cast.ptr                       = krnl_pagedir->table;
+    cast.ptr                       = virt_to_phys(cast.val);
     enable_paging(cast.val);
-
-    cast.val             = info->extra_argument;
-    cpu_processor_t *cpu = (cpu_processor_t *)cast.ptr;
+    pat_init();
 
     /* Initializing the GDT */
     ap_init_gdt(cpu);
@@ -195,16 +383,15 @@ void ap_entry(struct limine_smp_info *info)
     /* Initializing Local APIC */
     local_apic_init();
 
-    spin_lock(&ap_start_lock);
+    uint64_t flags = spin_lock_irqsave(&ap_start_lock);
     ap_ready_count++;
-    spin_unlock(&ap_start_lock);
+    spin_unlock_irqrestore(&ap_start_lock, flags);
 
-    /* TODO: Implement the scheduler loop */
-    enable_intr();
-    while (1) __asm__ volatile("hlt");
+    /* Become this CPU's idle thread, the timer and IPI_RESCHEDULE pull work in */
+    sched_ap_entry();
 
     /* Shouldn't reach here */
-    panic("AP %d scheduler exited.", cpu->id);
+    panic("AP %d scheduler exited.", cpu->cpu_id);
 }
 
 /* Initializing Symmetric Multi-Processing */
@@ -217,37 +404,51 @@ void smp_init(void)
         return;
     }
 
-    cpu_count = (!CPU_MAX_COUNT) ? smp->cpu_count : (smp->cpu_count > CPU_MAX_COUNT ? CPU_MAX_COUNT : smp->cpu_count);
+    cpu_count = smp->cpu_count > CPUMASK_BITS ? CPUMASK_BITS : smp->cpu_count; // Every CPU has to fit in a cpumask_t
     cpus      = (cpu_processor_t *)aligned_alloc(16, sizeof(cpu_processor_t) * cpu_count);
     plogk("smp: Found %d CPUs.\n", cpu_count);
 
+    smp_start_time = nano_time();
+
+    /* The shorthand would also hit CPUs left out by the cap */
+    ipi_broadcast = cpu_count > 1 && cpu_count == smp->cpu_count;
+
     /* Init BootStrap Processor */
     for (uint32_t i = 0; i < cpu_count; i++) {
         struct limine_smp_info *cpu = smp->cpus[i];
         cpus[i].id                  = i;
         cpus[i].lapic_id            = cpu->lapic_id;
-        /* Allocate kernel stack for each CPU */
-        cpus[i].kernel_stack = malloc(sizeof(kernel_stack_t)); // 64 KiB stack
 
-        /* Special handling for BSP */
+        /* Special handling for BSP, its area is already live in GS */
         if (cpu->lapic_id == smp->bsp_lapic_id) {
-            cpus[i].gdt       = &gdt0;
-            cpus[i].tss_stack = &tss_stack;
-            cpus[i].tss       = &tss0;
+            percpu_t *percpu = get_bsp_percpu();
+            cpus[i].percpu   = percpu;
+            percpu->cpu_id   = i;
+            percpu->lapic_id = cpu->lapic_id;
+
+            /* Allocate kernel stack for each CPU */
+            percpu->kernel_stack = malloc(sizeof(kernel_stack_t)); // 64 KiB stack
 
             pointer_cast_t cast;
-            cast.ptr = cpus[i].kernel_stack;
+            cast.ptr = percpu->kernel_stack;
             set_kernel_stack(ALIGN_DOWN((uint64_t)cast.val + sizeof(kernel_stack_t), 16));
             continue;
         } else {
-            cpus[i].gdt = (gdt_t *)aligned_alloc(16, ALIGN_UP(sizeof(gdt_t), 16));
-            memset(cpus[i].gdt, 0, sizeof(gdt_t)); // Clear dirty data
-            cpus[i].tss_stack = malloc(sizeof(tss_stack_t));
-            cpus[i].tss       = (tss_t *)aligned_alloc(16, ALIGN_UP(sizeof(tss_t), 16));
-            memset(cpus[i].tss, 0, sizeof(tss_t)); // Clear dirty data
+            percpu_t *percpu = (percpu_t *)aligned_alloc(64, sizeof(percpu_t));
+            memset(percpu, 0, sizeof(percpu_t)); // Clear dirty data
+            cpus[i].percpu       = percpu;
+            percpu->cpu_id       = i;
+            percpu->lapic_id     = cpu->lapic_id;
+            percpu->kernel_stack = malloc(sizeof(kernel_stack_t)); // 64 KiB stack
+            percpu->gdt          = (gdt_t *)aligned_alloc(16, ALIGN_UP(sizeof(gdt_t), 16));
+            memset(percpu->gdt, 0, sizeof(gdt_t)); // Clear dirty data
+            percpu->tss_stack = malloc(sizeof(tss_stack_t));
+            percpu->tss       = (tss_t *)aligned_alloc(16, ALIGN_UP(sizeof(tss_t), 16));
+            memset(percpu->tss, 0, sizeof(tss_t)); // Clear dirty data
+            percpu->fpu_kernel_state = fpu_state_alloc(); // Registers saved by kernel_fpu_begin()
 
             /* Configure the AP entry point */
-            cpu->extra_argument = (uint64_t)&cpus[i];
+            cpu->extra_argument = (uint64_t)percpu;
             cpu->goto_address   = (limine_goto_address)ap_entry;
         }
     }
@@ -257,11 +458,24 @@ void smp_init(void)
     register_interrupt_handler(IPI_HALT, (void *)ipi_halt_handler, 0, 0x8e);
     register_interrupt_handler(IPI_TLB_SHOOTDOWN, (void *)ipi_tlb_shootdown_handler, 0, 0x8e);
     register_interrupt_handler(IPI_PANIC, (void *)ipi_panic_handler, 0, 0x8e);
+    register_interrupt_handler(IPI_CALL_FUNCTION, (void *)ipi_call_function_handler, 0, 0x8e);
     plogk("smp: IPI handlers registered.\n");
 
-    /* Wait for all APs to be ready */
-    while (ap_ready_count < cpu_count - 1) __asm__ volatile("pause");
+    topology_init(cpu_count);
+}
+
+/* Wait until every AP has its local APIC up, the boot CPU runs other init meanwhile */
+void smp_wait_ready(void)
+{
+    if (!cpus) return;
+    while (__atomic_load_n(&ap_ready_count, __ATOMIC_ACQUIRE) < cpu_count - 1) __asm__ volatile("pause");
+    uint64_t bringup = nano_time() - smp_start_time;
+
+    /* Cross-CPU calls need every AP to have its IDT loaded */
+    smp_call_t *slots = (smp_call_t *)aligned_alloc(64, sizeof(smp_call_t) * cpu_count * cpu_count);
+    memset(slots, 0, sizeof(smp_call_t) * cpu_count * cpu_count);
+    __atomic_store_n(&call_slots, slots, __ATOMIC_RELEASE);
     for (size_t i = 0; i < cpu_count; i++)
-        plogk("smp: CPU %03u: tss_stack = %p, kernel_stack = %p\n", cpus[i].id, cpus[i].tss_stack, cpus[i].kernel_stack);
-    plogk("smp: All APs are up, total %llu CPUs.\n", cpu_count);
+        plogk("smp: CPU %03u: tss_stack = %p, kernel_stack = %p\n", cpus[i].id, cpus[i].percpu->tss_stack, cpus[i].percpu->kernel_stack);
+    plogk("smp: All APs are up, total %llu CPUs, %llu us after they were started.\n", cpu_count, bringup / 1000);
 }
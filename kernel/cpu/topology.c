@@ -0,0 +1,150 @@
+/*
+ *
+ *      topology.c
+ *      CPU topology
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "topology.h"
+#include "alloc.h"
+#include "cpuid.h"
+#include "cpumask.h"
+#include "printk.h"
+#include "smp.h"
+#include "stdint.h"
+#include "string.h"
+
+#define TOPO_LEVEL_SMT 1 // Level type of CPUID leaves 0xb and 0x1f
+
+static cpu_topology_t *topology;
+static uint32_t        topology_count;
+
+/* Returns the number of APIC ID bits needed for `count` ids */
+static uint32_t topology_order(uint32_t count)
+{
+    return count <= 1 ? 0 : 32 - __builtin_clz(count - 1);
+}
+
+/* Read the SMT and package shifts from leaf 0x1f or 0xb, returns 0 if the leaf is not enumerated */
+static int topology_extended_leaf(uint32_t leaf, uint32_t *smt_shift, uint32_t *package_shift)
+{
+    uint32_t eax, ebx, ecx, edx;
+    int      found = 0;
+
+    for (uint32_t subleaf = 0;; subleaf++) {
+        cpuid_count(leaf, subleaf, &eax, &ebx, &ecx, &edx);
+        uint32_t type = (ecx >> 8) & 0xff;
+        if (!type || !ebx) break;
+        if (type == TOPO_LEVEL_SMT) *smt_shift = eax & 0x1f;
+        *package_shift = eax & 0x1f; // The last level ends below the package
+        found          = 1;
+    }
+    return found;
+}
+
+/* Read the shift of the last level cache from the deterministic cache leaf (0x4 or 0x8000001d) */
+static int topology_cache_leaf(uint32_t leaf, uint32_t *llc_shift)
+{
+    uint32_t eax, ebx, ecx, edx, best_level = 0;
+
+    for (uint32_t subleaf = 0; subleaf < 16; subleaf++) {
+        cpuid_count(leaf, subleaf, &eax, &ebx, &ecx, &edx);
+        if (!(eax & 0x1f)) break; // No more caches
+        uint32_t level = (eax >> 5) & 0x7;
+        if (level < best_level) continue;
+        best_level = level;
+        *llc_shift = topology_order(((eax >> 14) & 0xfff) + 1);
+    }
+    return best_level != 0;
+}
+
+/* Work out how the APIC ID splits into thread, core, cache and package fields */
+static void topology_shifts(uint32_t *smt_shift, uint32_t *llc_shift, uint32_t *package_shift)
+{
+    uint32_t eax, ebx, ecx, edx;
+    uint32_t max_leaf, max_ext;
+    char    *vendor = get_vendor_name();
+    int      amd    = !strcmp(vendor, "AuthenticAMD") || !strcmp(vendor, "HygonGenuine");
+
+    cpuid(0x00000000, &max_leaf, &ebx, &ecx, &edx);
+    cpuid(0x80000000, &max_ext, &ebx, &ecx, &edx);
+    cpuid(0x80000001, &eax, &ebx, &ecx, &edx);
+    int topoext = amd && (ecx & (1 << 22)); // AMD topology extensions
+
+    *smt_shift     = 0;
+    *package_shift = 0;
+    int found      = (max_leaf >= 0x1f && topology_extended_leaf(0x1f, smt_shift, package_shift)) ||
+                (max_leaf >= 0x0b && topology_extended_leaf(0x0b, smt_shift, package_shift));
+
+    if (!found && amd && max_ext >= 0x80000008) {
+        cpuid(0x80000008, &eax, &ebx, &ecx, &edx);
+        uint32_t core_bits = (ecx >> 12) & 0xf;
+        *package_shift     = core_bits ? core_bits : topology_order((ecx & 0xff) + 1);
+        if (topoext && max_ext >= 0x8000001e) {
+            cpuid(0x8000001e, &eax, &ebx, &ecx, &edx);
+            *smt_shift = topology_order(((ebx >> 8) & 0xff) + 1);
+        }
+        found = 1;
+    }
+    if (!found) { // Legacy: only the logical processor count of the package is known
+        cpuid(0x00000001, &eax, &ebx, &ecx, &edx);
+        if (edx & (1 << 28)) *package_shift = topology_order((ebx >> 16) & 0xff);
+    }
+
+    *llc_shift = *package_shift;
+    if (!(topoext && max_ext >= 0x8000001d && topology_cache_leaf(0x8000001d, llc_shift)) && !amd && max_leaf >= 0x04)
+        topology_cache_leaf(0x04, llc_shift);
+    if (*llc_shift < *smt_shift) *llc_shift = *smt_shift;
+    if (*llc_shift > *package_shift) *llc_shift = *package_shift;
+}
+
+/* Returns the topology of a CPU, 0 before topology_init() */
+const cpu_topology_t *cpu_topology(uint32_t cpu)
+{
+    return topology && cpu < topology_count ? &topology[cpu] : 0;
+}
+
+/* Build the SMT, LLC and package maps from CPUID and the APIC IDs of `count` CPUs */
+void topology_init(uint32_t count)
+{
+    uint32_t smt_shift, llc_shift, package_shift;
+    topology_shifts(&smt_shift, &llc_shift, &package_shift);
+
+    if (!count) count = 1;
+    cpu_topology_t *map = (cpu_topology_t *)malloc(sizeof(cpu_topology_t) * count);
+    if (!map) {
+        plogk("topology: Cannot allocate the CPU map.\n");
+        return;
+    }
+    memset(map, 0, sizeof(cpu_topology_t) * count);
+
+    /* Every CPU runs the same CPUID, so the BSP's field widths hold for all of them */
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t apic_id  = (uint32_t)get_cpu_percpu(i)->lapic_id;
+        map[i].thread_id  = apic_id & ((1u << smt_shift) - 1);
+        map[i].core_id    = apic_id >> smt_shift;
+        map[i].llc_id     = apic_id >> llc_shift;
+        map[i].package_id = apic_id >> package_shift;
+    }
+
+    uint32_t cores = 0, llcs = 0, packages = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        for (uint32_t j = 0; j < count; j++) {
+            if (map[j].core_id == map[i].core_id) cpumask_set_cpu(&map[i].smt_mask, j);
+            if (map[j].llc_id == map[i].llc_id) cpumask_set_cpu(&map[i].llc_mask, j);
+            if (map[j].package_id == map[i].package_id) cpumask_set_cpu(&map[i].package_mask, j);
+        }
+        cores += cpumask_first(&map[i].smt_mask) == i;
+        llcs += cpumask_first(&map[i].llc_mask) == i;
+        packages += cpumask_first(&map[i].package_mask) == i;
+    }
+
+    topology_count = count;
+    topology       = map;
+    plogk("topology: %u packages, %u LLCs, %u cores, %u threads (APIC ID shifts: SMT %u, LLC %u, package %u).\n",
+          packages, llcs, cores, count, smt_shift, llc_shift, package_shift);
+}
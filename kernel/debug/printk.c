@@ -24,40 +24,37 @@
 
 #define BUF_SIZE 2048 // least 2 bytes (1 byte is for '\0')
 
+static DEFINE_SPIN_LOCK_CLASS(printk_lock_class, "printk");
+static DEFINE_SPIN_LOCK_CLASS(plogk_lock_class, "plogk");
+
 /* Lock for printk */
-spinlock_t printk_lock = {
-    .lock   = 0,
-    .rflags = 0,
-};
+spinlock_t printk_lock = SPINLOCK_INIT(&printk_lock_class);
 
 /* Lock for plogk */
-spinlock_t plogk_lock = {
-    .lock   = 0,
-    .rflags = 0,
-};
+spinlock_t plogk_lock = SPINLOCK_INIT(&plogk_lock_class);
 
 /* Kernel print string */
 void printk(const char *format, ...)
 {
-    spin_lock(&printk_lock); // Lock
+    uint64_t flags = spin_lock_irqsave(&printk_lock); // Lock
     va_list args;
     va_start(args, format);
     vwprintf(&tty_writer, format, args);
     va_end(args);
-    spin_unlock(&printk_lock); // Unlock
+    spin_unlock_irqrestore(&printk_lock, flags); // Unlock
 }
 
 /* Kernel print log */
 void plogk(const char *format, ...)
 {
 #if KERNEL_LOG
-    spin_lock(&plogk_lock); // Lock
+    uint64_t flags = spin_lock_irqsave(&plogk_lock); // Lock
     printk("[%5d.%06d] ", nano_time() / 1000000000, (nano_time() / 1000) % 1000000);
     va_list args;
     va_start(args, format);
     vwprintf(&tty_writer, format, args);
     va_end(args);
-    spin_unlock(&plogk_lock); // Unlock
+    spin_unlock_irqrestore(&plogk_lock, flags); // Unlock
 #else
     (void)format;
 #endif
@@ -465,17 +462,6 @@ int snprintf(char *str, size_t size, const char *format, ...)
                     }
                     break;
                 }
-                case 'f' : {
-                    double num = va_arg(args, double);
-                    char   num_str[50];
-                    int    num_len = ftoa(num, num_str, 6);
-
-                    for (int i = 0; i < num_len && count < size - 1; i++) {
-                        *ptr++ = num_str[i];
-                        count++;
-                    }
-                    break;
-                }
                 case '%' : {
                     if (count < size - 1) {
                         *ptr++ = '%';
@@ -10,6 +10,7 @@
  */
 
 #include "gdt.h"
+#include "percpu.h"
 #include "printk.h"
 #include "stdint.h"
 
@@ -41,6 +42,13 @@ void init_gdt(void)
                      [cseg] "rm"((uint64_t)0x8), [dseg] "rm"((uint64_t)0x10)
                      : "memory");
 
+    /* Loading GS cleared its base, point it at the boot CPU's area */
+    percpu_t *cpu  = get_bsp_percpu();
+    cpu->gdt       = &gdt0;
+    cpu->tss       = &tss0;
+    cpu->tss_stack = &tss_stack;
+    percpu_init(cpu);
+
     plogk("gdt: CS reloaded with 0x%04x, DS/ES/FS/GS/SS = 0x%04x\n", 0x8, 0x10);
     plogk("gdt: GDT initialized at %p (6 entries)\n", &gdt0.entries);
     tss_init();
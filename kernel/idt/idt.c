@@ -11,10 +11,28 @@
 
 #include "interrupt.h"
 #include "printk.h"
+#include "spin_lock.h"
 #include "stdint.h"
 
 idt_register_t idt_pointer;
-idt_entry_t    idt_entries[256];
+idt_entry_t    idt_entries[IDT_VECTORS];
+
+static DEFINE_SPIN_LOCK_CLASS(idt_vector_lock_class, "idt_vector");
+
+static spinlock_t idt_vector_lock = SPINLOCK_INIT(&idt_vector_lock_class);
+static uint64_t   idt_vector_used[IDT_VECTORS / 64]; // Bit per vector with an owner, a gate of its own or idt_alloc_vector()
+
+/* Point a gate at a handler */
+static void idt_set_gate(uint16_t vector, void *handler, uint8_t ist, uint8_t flags)
+{
+    uint64_t addr                  = (uint64_t)handler;
+    idt_entries[vector].offset_low = (uint16_t)addr;
+    idt_entries[vector].ist        = ist;
+    idt_entries[vector].flags      = flags;
+    idt_entries[vector].selector   = 0x08;
+    idt_entries[vector].offset_mid = (uint16_t)(addr >> 16);
+    idt_entries[vector].offset_hi  = (uint32_t)(addr >> 32);
+}
 
 /* Initialize the interrupt descriptor table */
 void init_idt(void)
@@ -26,8 +44,8 @@ void init_idt(void)
     plogk("idt: IDT initialized at %p (limit = 0x%04x)\n", idt_entries, idt_pointer.size);
     plogk("idt: Loaded IDTR with base = %p, limit = %hu\n", idt_pointer.ptr, idt_pointer.size + 1);
 
-    for (int i = 0; i < 256; i++) register_interrupt_handler(i, (void *)empty_handle[i], 0, 0x8e);
-    plogk("idt: Empty handler functions for interrupt vectors 0-255 registered.\n");
+    for (int i = 0; i < IDT_VECTORS; i++) idt_set_gate(i, irq_entry_stub(i), 0, 0x8e);
+    plogk("idt: Common entry stubs for interrupt vectors 0-255 registered.\n");
 }
 
 /* NOLINTBEGIN(bugprone-easily-swappable-parameters) */
@@ -36,11 +54,36 @@ void init_idt(void)
 void register_interrupt_handler(uint16_t vector, void *handler, uint8_t ist, uint8_t flags)
 {
     /* NOLINTEND(bugprone-easily-swappable-parameters) */
-    uint64_t addr                  = (uint64_t)handler;
-    idt_entries[vector].offset_low = (uint16_t)addr;
-    idt_entries[vector].ist        = ist;
-    idt_entries[vector].flags      = flags;
-    idt_entries[vector].selector   = 0x08;
-    idt_entries[vector].offset_mid = (uint16_t)(addr >> 16);
-    idt_entries[vector].offset_hi  = (uint32_t)(addr >> 32);
+    uint64_t irq_flags = spin_lock_irqsave(&idt_vector_lock);
+    idt_set_gate(vector, handler, ist, flags);
+    idt_vector_used[vector / 64] |= 1ULL << (vector % 64);
+    spin_unlock_irqrestore(&idt_vector_lock, irq_flags);
+}
+
+/* Allocate a free device vector and install `handler` on it (0 keeps irq_dispatch()), returns 0 if none is left */
+uint8_t idt_alloc_vector(void *handler)
+{
+    uint8_t  vector = 0;
+    uint64_t flags  = spin_lock_irqsave(&idt_vector_lock);
+
+    for (uint32_t i = IDT_VECTOR_DYNAMIC_FIRST; i <= IDT_VECTOR_DYNAMIC_LAST; i++) {
+        if (idt_vector_used[i / 64] & (1ULL << (i % 64))) continue;
+        idt_vector_used[i / 64] |= 1ULL << (i % 64);
+        if (handler) idt_set_gate(i, handler, 0, 0x8e);
+        vector = (uint8_t)i;
+        break;
+    }
+    spin_unlock_irqrestore(&idt_vector_lock, flags);
+    return vector;
+}
+
+/* Give a vector from idt_alloc_vector() back and point it at irq_dispatch() again */
+void idt_free_vector(uint8_t vector)
+{
+    if (vector < IDT_VECTOR_DYNAMIC_FIRST || vector > IDT_VECTOR_DYNAMIC_LAST) return;
+
+    uint64_t flags = spin_lock_irqsave(&idt_vector_lock);
+    idt_set_gate(vector, irq_entry_stub(vector), 0, 0x8e);
+    idt_vector_used[vector / 64] &= ~(1ULL << (vector % 64));
+    spin_unlock_irqrestore(&idt_vector_lock, flags);
 }
@@ -10,6 +10,7 @@
  */
 
 #include "debug.h"
+#include "fpu.h"
 #include "interrupt.h"
 #include "printk.h"
 #include "stdint.h"
@@ -65,13 +66,6 @@ INTERRUPT_BEGIN static void ISR_6_handle(interrupt_frame_t *frame)
 }
 INTERRUPT_END
 
-INTERRUPT_BEGIN static void ISR_7_handle(interrupt_frame_t *frame)
-{
-    (void)frame;
-    panic("Kernel exception: #NM");
-}
-INTERRUPT_END
-
 INTERRUPT_BEGIN static void ISR_8_handle(interrupt_frame_t *frame)
 {
     (void)frame;
@@ -161,7 +155,7 @@ void isr_registe_handle(void)
     register_interrupt_handler(ISR_4, (void *)ISR_4_handle, 0, 0x8e);
     register_interrupt_handler(ISR_5, (void *)ISR_5_handle, 0, 0x8e);
     register_interrupt_handler(ISR_6, (void *)ISR_6_handle, 0, 0x8e);
-    register_interrupt_handler(ISR_7, (void *)ISR_7_handle, 0, 0x8e);
+    register_interrupt_handler(ISR_7, (void *)fpu_nm_handle, 0, 0x8e);
     register_interrupt_handler(ISR_8, (void *)ISR_8_handle, 0, 0x8e);
     register_interrupt_handler(ISR_9, (void *)ISR_9_handle, 0, 0x8e);
     register_interrupt_handler(ISR_10, (void *)ISR_10_handle, 0, 0x8e);
@@ -0,0 +1,197 @@
+/*
+ *
+ *      irq.c
+ *      Interrupt dispatch through per-vector handler chains
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "irq.h"
+#include "acpi.h"
+#include "alloc.h"
+#include "apic.h"
+#include "interrupt.h"
+#include "percpu.h"
+#include "printk.h"
+#include "rcu.h"
+#include "sched.h"
+#include "smp.h"
+#include "softirq.h"
+#include "spin_lock.h"
+#include "stdint.h"
+#include "string.h"
+
+#define IRQ_SPURIOUS_BURST    10            // Reports allowed per interval
+#define IRQ_SPURIOUS_INTERVAL 5000000000ULL // Nanoseconds
+
+static DEFINE_SPIN_LOCK_CLASS(irq_action_lock_class, "irq_action");
+static DEFINE_SPIN_LOCK_CLASS(irq_spurious_lock_class, "irq_spurious");
+
+static irq_action_t *irq_actions[IDT_VECTORS]; // Read locklessly by irq_dispatch(), changed under irq_action_lock
+static spinlock_t    irq_action_lock   = SPINLOCK_INIT(&irq_action_lock_class);
+static spinlock_t    irq_spurious_lock = SPINLOCK_INIT(&irq_spurious_lock_class);
+static uint64_t      irq_spurious_window;     // nano_time() the current interval began at
+static uint32_t      irq_spurious_reported;   // Reports printed in the current interval
+static uint64_t      irq_spurious_suppressed; // Reports dropped in the current interval
+
+/* Thread of a threaded handler, runs `thread_fn` once per wakeup from irq_dispatch() */
+static void irq_thread(void *arg)
+{
+    irq_action_t *action = (irq_action_t *)arg;
+    thread_t     *self   = get_current_thread();
+
+    while (1) {
+        /* Blocked before the check, so a wakeup in between leaves it running and nothing is lost */
+        self->state = THREAD_BLOCKED;
+        if (__atomic_exchange_n(&action->thread_pending, 0, __ATOMIC_SEQ_CST)) {
+            self->state = THREAD_RUNNING;
+            action->thread_fn(action->vector, action->data);
+            continue;
+        }
+        if (__atomic_load_n(&action->thread_stop, __ATOMIC_ACQUIRE)) break;
+        schedule();
+    }
+    self->state = THREAD_RUNNING;
+    __atomic_store_n(&action->thread, 0, __ATOMIC_RELEASE); // The action is freed from here on
+    thread_exit();
+}
+
+/* Chain a handler onto a vector dispatched by irq_dispatch(), returns 1 if out of memory */
+int irq_request(uint8_t vector, irq_handler_t handler, void *data, const char *name)
+{
+    return irq_request_threaded(vector, handler, 0, data, name);
+}
+
+/* Chain a handler whose `thread_fn` runs in a thread of its own, a 0 handler always wakes it, returns 1 on failure */
+int irq_request_threaded(uint8_t vector, irq_handler_t handler, irq_handler_t thread_fn, void *data, const char *name)
+{
+    if (!handler && !thread_fn) return 1;
+    irq_action_t *action = (irq_action_t *)malloc(sizeof(irq_action_t));
+    if (!action) return 1;
+    memset(action, 0, sizeof(irq_action_t));
+    action->handler   = handler;
+    action->thread_fn = thread_fn;
+    action->data      = data;
+    action->name      = name;
+    action->vector    = vector;
+
+    if (thread_fn) {
+        action->thread = thread_create(name, irq_thread, action);
+        if (!action->thread) {
+            free(action);
+            return 1;
+        }
+    }
+
+    /* Appended so handlers run in the order they were requested */
+    uint64_t       flags = spin_lock_irqsave(&irq_action_lock);
+    irq_action_t **link  = &irq_actions[vector];
+    while (*link) link = &(*link)->next;
+    rcu_assign_pointer(*link, action);
+    spin_unlock_irqrestore(&irq_action_lock, flags);
+    return 0;
+}
+
+/* Unchain a handler, returns once no CPU can still be running it */
+void irq_release(uint8_t vector, irq_handler_t handler, void *data)
+{
+    irq_action_t *action = 0;
+    uint64_t      flags  = spin_lock_irqsave(&irq_action_lock);
+    for (irq_action_t **link = &irq_actions[vector]; *link; link = &(*link)->next) {
+        if ((*link)->handler != handler || (*link)->data != data) continue;
+        action = *link;
+        rcu_assign_pointer(*link, action->next);
+        break;
+    }
+    spin_unlock_irqrestore(&irq_action_lock, flags);
+    if (!action) return;
+
+    /* A dispatch runs with interrupts off, which holds off the grace period */
+    synchronize_rcu();
+    thread_t *thread = __atomic_load_n(&action->thread, __ATOMIC_ACQUIRE);
+    if (thread) {
+        __atomic_store_n(&action->thread_stop, 1, __ATOMIC_SEQ_CST);
+        thread_wakeup(thread);
+        while (__atomic_load_n(&action->thread, __ATOMIC_ACQUIRE)) thread_yield();
+    }
+    free(action);
+}
+
+/* Allocate a free vector and chain a handler onto it, returns 0 if none is left */
+uint8_t irq_alloc_vector(irq_handler_t handler, void *data, const char *name)
+{
+    uint8_t vector = idt_alloc_vector(0);
+    if (!vector) return 0;
+    if (irq_request(vector, handler, data, name)) {
+        idt_free_vector(vector);
+        return 0;
+    }
+    return vector;
+}
+
+/* Unchain the handler of a vector from irq_alloc_vector() and give the vector back */
+void irq_free_vector(uint8_t vector, irq_handler_t handler, void *data)
+{
+    irq_release(vector, handler, data);
+    idt_free_vector(vector);
+}
+
+/* Returns how often a vector was dispatched, summed over all CPUs */
+uint64_t irq_vector_count(uint8_t vector)
+{
+    uint64_t total = 0;
+    for (uint32_t cpu = 0; cpu < get_cpu_count(); cpu++) total += get_cpu_percpu(cpu)->irq_vector_counts[vector];
+    return total;
+}
+
+/* Report an interrupt no handler claimed, at most IRQ_SPURIOUS_BURST times per interval */
+static void irq_spurious(uint64_t vector, interrupt_frame_t *frame)
+{
+    uint64_t now        = nano_time();
+    uint64_t suppressed = 0;
+    int      report     = 0;
+
+    spin_lock(&irq_spurious_lock);
+    if (!irq_spurious_window || now - irq_spurious_window >= IRQ_SPURIOUS_INTERVAL) {
+        suppressed              = irq_spurious_suppressed;
+        irq_spurious_window     = now;
+        irq_spurious_reported   = 0;
+        irq_spurious_suppressed = 0;
+    }
+    if (irq_spurious_reported < IRQ_SPURIOUS_BURST) {
+        irq_spurious_reported++;
+        report = 1;
+    } else {
+        irq_spurious_suppressed++;
+    }
+    spin_unlock(&irq_spurious_lock);
+
+    if (suppressed) plogk("irq: %llu unhandled interrupt reports suppressed.\n", suppressed);
+    if (report)
+        plogk("irq: Unhandled interrupt %llu on CPU %u at %#llx.\n", vector, (uint32_t)this_cpu_read(cpu_id), frame->rip);
+}
+
+/* Entered from the stubs of irq_entry.s, runs the handlers chained on a vector */
+__attribute__((target("general-regs-only"))) void irq_dispatch(uint64_t vector, interrupt_frame_t *frame)
+{
+    int handled = 0;
+    this_cpu()->irq_vector_counts[vector]++;
+
+    for (irq_action_t *action = rcu_dereference(irq_actions[vector]); action; action = rcu_dereference(action->next)) {
+        int result = action->handler ? action->handler((uint8_t)vector, action->data) : IRQ_WAKE_THREAD;
+        if (result == IRQ_WAKE_THREAD && action->thread) {
+            __atomic_store_n(&action->thread_pending, 1, __ATOMIC_SEQ_CST);
+            thread_wakeup(action->thread);
+        }
+        handled |= result != IRQ_NONE;
+    }
+
+    if (!handled) irq_spurious(vector, frame);
+    if (vector < IRQ_0) return; // Exceptions have no in-service bit and no softirq exit
+
+    if (vector != LAPIC_SPURIOUS_VECTOR) send_eoi();
+    irq_exit();
+}
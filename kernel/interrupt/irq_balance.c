@@ -0,0 +1,106 @@
+/*
+ *
+ *      irq_balance.c
+ *      Device interrupt balancing across CPUs
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "apic.h"
+#include "cpumask.h"
+#include "initcall.h"
+#include "isolation.h"
+#include "percpu.h"
+#include "printk.h"
+#include "smp.h"
+#include "stdint.h"
+#include "string.h"
+#include "workqueue.h"
+
+#define IRQ_BALANCE_INTERVAL  1000 // Milliseconds between passes
+#define IRQ_BALANCE_THRESHOLD 64   // Interrupts per pass the busiest CPU must lead the idlest by
+
+static delayed_work_t irq_balance_work;
+static uint64_t       irq_balance_seen[IOAPIC_MAX_PINS]; // Interrupts of each pin up to the previous pass
+static uint64_t       irq_balance_rate[IOAPIC_MAX_PINS]; // Interrupts of each pin during the last pass
+static uint64_t       irq_balance_load[CPUMASK_BITS];    // Interrupts handled per CPU, as placed or as planned
+
+/* Pin 0 shares its vector with the local APIC timer and stays where the platform timer expects it */
+static int irq_balance_movable(uint32_t irq)
+{
+    return irq && ioapic_pin_routed(irq) && ioapic_irq_cpu(irq) != IOAPIC_CPU_LOGICAL;
+}
+
+/* Returns the spread between the busiest and the idlest housekeeping CPU under irq_balance_load */
+static uint64_t irq_balance_spread(uint32_t cpus)
+{
+    uint64_t most = 0, least = ~(uint64_t)0;
+    for (uint32_t cpu = 0; cpu < cpus; cpu++) {
+        if (cpu_isolated(cpu)) continue; // Quiet by design, only explicitly affined pins reach it
+        if (irq_balance_load[cpu] > most) most = irq_balance_load[cpu];
+        if (irq_balance_load[cpu] < least) least = irq_balance_load[cpu];
+    }
+    return most - least;
+}
+
+/* Measure each pin's rate and, if the CPUs are out of balance, re-place the busiest pins first */
+static void irq_balance(work_t *work)
+{
+    uint32_t cpus = get_cpu_count();
+
+    memset(irq_balance_load, 0, sizeof(uint64_t) * cpus);
+    for (uint32_t irq = 0; irq < IOAPIC_MAX_PINS; irq++) {
+        uint64_t total = 0;
+        for (uint32_t cpu = 0; cpu < cpus; cpu++) total += get_cpu_percpu(cpu)->irq_counts[irq];
+        irq_balance_rate[irq] = total - irq_balance_seen[irq];
+        irq_balance_seen[irq] = total;
+        if (irq_balance_movable(irq)) irq_balance_load[ioapic_irq_cpu(irq)] += irq_balance_rate[irq];
+    }
+
+    if (irq_balance_spread(cpus) > IRQ_BALANCE_THRESHOLD) {
+        uint32_t placed = 0; // Bit per pin already given a CPU this pass
+        memset(irq_balance_load, 0, sizeof(uint64_t) * cpus);
+
+        while (1) {
+            uint32_t busiest = IOAPIC_MAX_PINS;
+            for (uint32_t irq = 0; irq < IOAPIC_MAX_PINS; irq++) {
+                if ((placed & (1 << irq)) || !irq_balance_rate[irq] || !irq_balance_movable(irq)) continue;
+                if (busiest == IOAPIC_MAX_PINS || irq_balance_rate[irq] > irq_balance_rate[busiest]) busiest = irq;
+            }
+            if (busiest == IOAPIC_MAX_PINS) break;
+            placed |= 1 << busiest;
+
+            /* Least planned load wins, the current CPU on a tie so quiet pins stay put */
+            cpumask_t affinity;
+            uint32_t  current = ioapic_irq_cpu(busiest), best = current, cpu;
+            ioapic_get_affinity(busiest, &affinity);
+            for_each_cpu(cpu, &affinity) {
+                if (cpu >= cpus) break;
+                if (irq_balance_load[cpu] < irq_balance_load[best]) best = cpu;
+            }
+            irq_balance_load[best] += irq_balance_rate[busiest];
+            if (best != current && !ioapic_move_irq(busiest, best))
+                plogk("irq: IRQ %u (%llu/s) moved from CPU %u to CPU %u.\n", busiest,
+                      irq_balance_rate[busiest] * 1000 / IRQ_BALANCE_INTERVAL, current, best);
+        }
+    }
+    queue_delayed_work(system_wq, to_delayed_work(work), IRQ_BALANCE_INTERVAL);
+}
+
+/* Set up lowest-priority delivery where the APIC mode allows it and start the balancer */
+static void irq_balance_init(void)
+{
+    uint32_t cpus = get_cpu_count();
+    if (cpus < 2) return;
+
+    int logical = !ioapic_logical_init();
+    init_delayed_work(&irq_balance_work, irq_balance);
+    queue_delayed_work(system_wq, &irq_balance_work, IRQ_BALANCE_INTERVAL);
+    plogk("irq: Balancing %u I/O APIC pins over %u CPUs every %u ms, lowest-priority delivery %s.\n",
+          ioapic_pin_count(), cpus, IRQ_BALANCE_INTERVAL, logical ? "available" : "unavailable");
+}
+
+INITCALL(irq_balance_init, INITCALL_LATE, 0);
@@ -0,0 +1,67 @@
+/*
+ *
+ *      irq_entry.s
+ *      Common interrupt entry stubs
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+    .text
+    .altmacro
+
+/* One IRQ_STUB_SIZE-byte stub per vector, a dummy error code keeps the frame layout of every vector the same */
+.macro IRQ_STUB vector
+    .balign 16
+    .if (\vector == 8) || ((\vector >= 10) && (\vector <= 14)) || (\vector == 17) || (\vector == 21) || (\vector == 29) || (\vector == 30)
+    .else
+    pushq $0
+    .endif
+    pushq $\vector
+    jmp irq_common
+.endm
+
+    .globl irq_stubs
+    .balign 16
+irq_stubs:
+    .set irq_stub_vector, 0
+    .rept 256
+    IRQ_STUB %irq_stub_vector
+    .set irq_stub_vector, irq_stub_vector + 1
+    .endr
+    .size irq_stubs, . - irq_stubs
+
+/* Save the registers a C call may clobber and run irq_dispatch(vector, frame), the stack is 16-byte aligned there */
+    .type irq_common, @function
+irq_common:
+    cld
+    pushq %rax
+    pushq %rcx
+    pushq %rdx
+    pushq %rsi
+    pushq %rdi
+    pushq %r8
+    pushq %r9
+    pushq %r10
+    pushq %r11
+
+    movq 72(%rsp), %rdi
+    leaq 88(%rsp), %rsi
+    call irq_dispatch
+
+    popq %r11
+    popq %r10
+    popq %r9
+    popq %r8
+    popq %rdi
+    popq %rsi
+    popq %rdx
+    popq %rcx
+    popq %rax
+    addq $16, %rsp
+    iretq
+    .size irq_common, . - irq_common
+
+    .section .note.GNU-stack, "", @progbits
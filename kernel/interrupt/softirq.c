@@ -0,0 +1,125 @@
+/*
+ *
+ *      softirq.c
+ *      Deferred interrupt work
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "softirq.h"
+#include "acpi.h"
+#include "common.h"
+#include "debug.h"
+#include "percpu.h"
+#include "printk.h"
+#include "sched.h"
+#include "smp.h"
+#include "stdint.h"
+
+#define RFLAGS_IF (1 << 9)
+
+static softirq_handler_t softirq_handlers[SOFTIRQ_COUNT];
+
+/* Install the handler of a softirq */
+void open_softirq(softirq_nr_t nr, softirq_handler_t handler)
+{
+    softirq_handlers[nr] = handler;
+}
+
+/* Mark a softirq pending on the current CPU from a hard interrupt, it runs at interrupt exit */
+void raise_softirq_irqoff(softirq_nr_t nr)
+{
+    this_cpu_write(softirq_pending, this_cpu_read(softirq_pending) | 1ULL << nr);
+}
+
+/* Mark a softirq pending on the current CPU from any context, ksoftirqd runs it */
+void raise_softirq(softirq_nr_t nr)
+{
+    uint64_t flags = get_rflags();
+    disable_intr();
+    raise_softirq_irqoff(nr);
+    thread_t *ksoftirqd = this_cpu_read(ksoftirqd);
+    if (ksoftirqd) thread_wakeup(ksoftirqd);
+    if (flags & RFLAGS_IF) enable_intr();
+}
+
+/* Run pending softirqs within the budget, interrupts are off on entry and exit, returns 1 if some are left */
+static int softirq_run(void)
+{
+    uint64_t start = nano_time();
+    this_cpu_write(softirq_active, 1);
+    preempt_disable();
+
+    for (uint32_t restart = 0; restart < SOFTIRQ_RESTART_MAX; restart++) {
+        uint64_t pending = this_cpu_read(softirq_pending);
+        if (!pending) break;
+        this_cpu_write(softirq_pending, 0);
+
+        /* Hard interrupts may raise more meanwhile, they are picked up by the next pass */
+        enable_intr();
+        while (pending) {
+            uint32_t nr = __builtin_ctzll(pending);
+            pending &= pending - 1;
+            if (softirq_handlers[nr]) softirq_handlers[nr]();
+            this_cpu_inc(softirq_runs);
+        }
+        disable_intr();
+        if (nano_time() - start >= SOFTIRQ_TIME_MAX) break;
+    }
+
+    preempt_enable();
+    this_cpu_write(softirq_active, 0);
+    return this_cpu_read(softirq_pending) != 0;
+}
+
+/* Run pending softirqs at the end of a hard interrupt, interrupts must be off */
+void irq_exit(void)
+{
+    if (!this_cpu_read(softirq_pending) || this_cpu_read(softirq_active)) return;
+
+    /* Once ksoftirqd is awake the load is high, leave the work to it rather than stretch every interrupt */
+    thread_t *ksoftirqd = this_cpu_read(ksoftirqd);
+    if (ksoftirqd && ksoftirqd->state != THREAD_BLOCKED) return;
+
+    if (softirq_run() && ksoftirqd) {
+        this_cpu_inc(softirq_deferred);
+        thread_wakeup(ksoftirqd);
+    }
+}
+
+/* Per-CPU thread that runs softirqs the interrupt exit budget left over */
+static void ksoftirqd_thread(void *arg)
+{
+    (void)arg;
+    thread_t *self = get_current_thread();
+
+    while (1) {
+        disable_intr();
+        if (!this_cpu_read(softirq_pending)) {
+            /* Interrupts stay off until the switch, so a raise on this CPU cannot slip in before we sleep */
+            self->state = THREAD_BLOCKED;
+            schedule();
+            enable_intr();
+            continue;
+        }
+        softirq_run();
+        enable_intr();
+        thread_yield(); // Other threads get the CPU between batches
+    }
+}
+
+/* Start the per-CPU ksoftirqd threads */
+void softirq_init(void)
+{
+    uint32_t cpus = get_cpu_count() ? get_cpu_count() : 1;
+    for (uint32_t cpu = 0; cpu < cpus; cpu++) {
+        thread_t *thread = thread_create_on("ksoftirqd", ksoftirqd_thread, 0, cpu, THREAD_PINNED);
+        if (!thread) panic("softirq: Cannot create ksoftirqd for CPU %u.", cpu);
+        __atomic_store_n(&get_cpu_percpu(cpu)->ksoftirqd, thread, __ATOMIC_RELEASE);
+    }
+    plogk("softirq: %u softirqs, ksoftirqd on %u CPUs, %u passes or %u us per interrupt exit.\n", SOFTIRQ_COUNT,
+          cpus, SOFTIRQ_RESTART_MAX, SOFTIRQ_TIME_MAX / 1000);
+}
@@ -126,6 +126,17 @@ uint64_t alloc_frames_1G(size_t count)
     return 0;
 }
 
+/* Returns 1 if a frame lies in a usable region, only those may be passed to free_frame() */
+int frame_is_usable(uint64_t addr)
+{
+    struct limine_memmap_response *memory_map = memmap_request.response;
+    for (uint64_t i = 0; i < memory_map->entry_count; i++) {
+        struct limine_memmap_entry *region = memory_map->entries[i];
+        if (region->type == LIMINE_MEMMAP_USABLE && addr >= region->base && addr < region->base + region->length) return 1;
+    }
+    return 0;
+}
+
 /* Free a memory frame */
 void free_frame(uint64_t addr)
 {
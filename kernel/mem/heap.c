@@ -12,13 +12,18 @@
 #include "heap.h"
 #include "alloc.h"
 #include "cpuid.h"
+#include "debug.h"
 #include "frame.h"
 #include "hhdm.h"
 #include "page.h"
+#include "parallel_for.h"
 #include "stddef.h"
 #include "stdint.h"
 #include "stdlib.h"
 #include "string.h"
+#include "vm_space.h"
+
+#define HEAP_ZERO_GRAIN 0x40000 // Bytes per parallel_for() chunk of calloc(), smaller blocks are zeroed in one go
 
 uint64_t KERNEL_HEAP_START = 0xffff900000000000;
 uint64_t KERNEL_HEAP_SIZE  = 0x6400000;
@@ -33,12 +38,23 @@ void init_heap(void)
     pointer_cast_t cast;
     cast.val = KERNEL_HEAP_START;
     heap_init(cast.ptr, KERNEL_HEAP_SIZE);
+
+    /* Keep later virtual allocations out of the heap window */
+    if (vm_space_reserve(get_kernel_vm_space(), KERNEL_HEAP_START, KERNEL_HEAP_SIZE, VM_AREA_HEAP)) {
+        panic("heap: Cannot reserve the heap window %p - %p.", KERNEL_HEAP_START, KERNEL_HEAP_START + KERNEL_HEAP_SIZE);
+    }
+}
+
+/* Zero the bytes [start, end) of a block */
+static void heap_zero(uint64_t start, uint64_t end, void *arg)
+{
+    memset((uint8_t *)arg + start, 0, end - start);
 }
 
 /* Allocate an empty memory */
 void *calloc(size_t nmemb, size_t size)
 {
     void *p = malloc(nmemb * size);
-    memset(p, 0, nmemb * size);
+    if (p) parallel_for(0, nmemb * size, HEAP_ZERO_GRAIN, heap_zero, p);
     return p;
 }
@@ -0,0 +1,170 @@
+/*
+ *
+ *      kernel_map.c
+ *      Kernel image mapping
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "kernel_map.h"
+#include "common.h"
+#include "frame.h"
+#include "hhdm.h"
+#include "limine.h"
+#include "page.h"
+#include "pmu.h"
+#include "printk.h"
+#include "rinx.h"
+#include "stdint.h"
+#include "stdlib.h"
+#include "string.h"
+
+static uint64_t kernel_virt_base;
+static uint64_t kernel_phys_base;
+
+/* Returns the leaf flags for a kernel image address, 0 outside the image */
+static uint64_t kernel_map_flags(uint64_t addr)
+{
+    pointer_cast_t cast;
+
+    cast.ptr = __text_start;
+    if (addr < cast.val) return PTE_PRESENT | PTE_NO_EXECUTE; // Limine requests
+    cast.ptr = __rodata_start;
+    if (addr < cast.val) return PTE_PRESENT; // Text
+    cast.ptr = __data_start;
+    if (addr < cast.val) return PTE_PRESENT | PTE_NO_EXECUTE; // Read-only data
+    cast.ptr = __kernel_end;
+    if (addr < cast.val) return PTE_PRESENT | PTE_WRITEABLE | PTE_NO_EXECUTE; // Data and BSS
+    return 0;
+}
+
+/* Physical address of a kernel image address */
+static inline uint64_t kernel_map_phys(uint64_t addr)
+{
+    return kernel_phys_base + (addr - kernel_virt_base);
+}
+
+/* Fill the mapping of one 2 MiB chunk, returns 1 if a large page was used */
+static int kernel_map_chunk(page_table_entry_t *l2_entry, uint64_t chunk, uint64_t start, uint64_t end)
+{
+    uint64_t flags   = chunk >= start ? kernel_map_flags(chunk) : 0;
+    int      uniform = flags && chunk + HUGE_2M_SIZE <= end && !(kernel_map_phys(chunk) & (HUGE_2M_SIZE - 1));
+
+    for (uint64_t addr = chunk; uniform && addr < chunk + HUGE_2M_SIZE; addr += PAGE_SIZE)
+        if (kernel_map_flags(addr) != flags) uniform = 0;
+
+    if (uniform) {
+        l2_entry->value = kernel_map_phys(chunk) | flags | PTE_HUGE;
+        return 1;
+    }
+
+    uint64_t frame = alloc_frames(1);
+    if (frame == 0) return -1;
+
+    page_table_t *l1_table = (page_table_t *)phys_to_virt(frame);
+    page_table_clear(l1_table);
+    for (int i = 0; i < 512; i++) {
+        uint64_t addr = chunk + (uint64_t)i * PAGE_SIZE;
+        if (addr < start || addr >= end) continue;
+        l1_table->entries[i].value = kernel_map_phys(addr) | kernel_map_flags(addr);
+    }
+    l2_entry->value = frame | PTE_PRESENT | PTE_WRITEABLE;
+    return 0;
+}
+
+/* Free the L1 tables behind the image chunks [from, to) of an L2 table, with `owned` set only frames the allocator handed out */
+static void kernel_map_release(page_table_t *l2_table, uint64_t from, uint64_t to, int owned)
+{
+    for (uint64_t chunk = from; chunk < to; chunk += HUGE_2M_SIZE) {
+        page_table_entry_t *entry = &l2_table->entries[(chunk >> 21) & 0x1ff];
+        uint64_t            table = entry->value & PAGE_FLAGS_MASK;
+        if (!(entry->value & PTE_PRESENT) || is_huge_page(entry)) continue;
+        if (!owned || frame_is_usable(table)) free_frame(table);
+    }
+}
+
+/* Count iTLB walks of calling one stub on each probe page with those pages flushed from the TLB */
+static uint64_t kernel_map_measure(void)
+{
+    pointer_cast_t cast;
+
+    for (uint32_t i = 0; i < KERNEL_MAP_PROBE_PAGES; i++) {
+        cast.ptr = kernel_map_probe + (uint64_t)i * PAGE_SIZE;
+        flush_tlb(cast.val); // invlpg also drops global entries
+    }
+
+    pmu_start(0, PMU_EVENT_ITLB_MISSES, PMU_UMASK_ITLB_WALK_COMPLETE);
+    for (uint32_t i = 0; i < KERNEL_MAP_PROBE_PAGES; i++) ((void (*)(void))(kernel_map_probe + (uint64_t)i * PAGE_SIZE))();
+    uint64_t misses = pmu_read(0);
+    pmu_stop(0);
+    return misses;
+}
+
+/* Rebuild the kernel image mapping with 2 MiB pages and per-segment W^X */
+void kernel_map_init(void) // NOLINT
+{
+    pointer_cast_t cast;
+
+    if (!kernel_address_request.response) return;
+    kernel_virt_base = kernel_address_request.response->virtual_base;
+    kernel_phys_base = kernel_address_request.response->physical_base;
+
+    cast.ptr       = __kernel_start;
+    uint64_t start = cast.val;
+    cast.ptr       = __kernel_end;
+    uint64_t end   = ALIGN_UP(cast.val, PAGE_SIZE);
+
+    /* The image must sit inside one 1 GiB slot so a single L3 entry can be swapped */
+    if ((start >> 30) != ((end - 1) >> 30)) {
+        plogk("kmap: Kernel image crosses a 1 GiB boundary, keeping the boot mapping.\n");
+        return;
+    }
+
+    uint32_t pmu_counters = pmu_init();
+    uint64_t misses_4k    = pmu_counters ? kernel_map_measure() : 0;
+
+    page_table_t       *l4_table = get_kernel_pagedir()->table;
+    page_table_entry_t *l4_entry = &l4_table->entries[(start >> 39) & 0x1ff];
+    page_table_t       *l3_table = (page_table_t *)phys_to_virt(l4_entry->value & PAGE_FLAGS_MASK);
+    page_table_entry_t *l3_entry = &l3_table->entries[(start >> 30) & 0x1ff];
+    if (!(l3_entry->value & PTE_PRESENT) || is_huge_page(l3_entry)) return;
+
+    /* Build the new L2 table off to the side, everything outside the image is kept */
+    uint64_t frame = alloc_frames(1);
+    if (frame == 0) return;
+    page_table_t *old_l2 = (page_table_t *)phys_to_virt(l3_entry->value & PAGE_FLAGS_MASK);
+    page_table_t *new_l2 = (page_table_t *)phys_to_virt(frame);
+    memcpy(new_l2, old_l2, sizeof(page_table_t));
+
+    size_t huge = 0, small = 0;
+    for (uint64_t chunk = ALIGN_DOWN(start, HUGE_2M_SIZE); chunk < end; chunk += HUGE_2M_SIZE) {
+        int ret = kernel_map_chunk(&new_l2->entries[(chunk >> 21) & 0x1ff], chunk, start, end);
+        if (ret < 0) {
+            plogk("kmap: Out of page table frames, keeping the boot mapping.\n");
+            kernel_map_release(new_l2, ALIGN_DOWN(start, HUGE_2M_SIZE), chunk, 0);
+            free_frame(frame);
+            return;
+        }
+        ret ? huge++ : small++;
+    }
+
+    /* Every image address keeps its frame, only page sizes and permissions change */
+    uint64_t old_frame = l3_entry->value & PAGE_FLAGS_MASK;
+    l3_entry->value    = frame | PTE_PRESENT | PTE_WRITEABLE;
+    flush_tlb_local();
+
+    /* The APs are not up yet, so the local flush was the last user of the old tables, Limine's own stay in reclaimable memory */
+    kernel_map_release(old_l2, ALIGN_DOWN(start, HUGE_2M_SIZE), end, 1);
+    if (frame_is_usable(old_frame)) free_frame(old_frame);
+
+    plogk("kmap: Kernel image %p - %p mapped with %llu 2M and %llu 4K-backed chunks.\n", start, end, huge, small);
+    if (pmu_counters) {
+        uint64_t misses_2m = kernel_map_measure();
+        plogk("kmap: iTLB walks over %u probe pages: %llu (4K) -> %llu (2M).\n", KERNEL_MAP_PROBE_PAGES, misses_4k, misses_2m);
+    } else {
+        plogk("kmap: No architectural PMU, iTLB misses not measured.\n");
+    }
+}
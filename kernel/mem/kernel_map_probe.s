@@ -0,0 +1,24 @@
+/*
+ *
+ *      kernel_map_probe.s
+ *      Instruction TLB probe of the kernel image mapping
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+    .section .text.kernel_map_probe, "ax", @progbits
+
+/* KERNEL_MAP_PROBE_PAGES `ret` stubs one page apart, calling each fetches code from a different 4 KiB page */
+    .globl kernel_map_probe
+    .balign 4096
+kernel_map_probe:
+    .rept 16
+    ret
+    .balign 4096, 0xcc
+    .endr
+    .size kernel_map_probe, . - kernel_map_probe
+
+    .section .note.GNU-stack, "", @progbits
@@ -12,19 +12,25 @@
 #include "page.h"
 #include "alloc.h"
 #include "common.h"
+#include "cpuid.h"
 #include "debug.h"
 #include "frame.h"
 #include "hhdm.h"
 #include "interrupt.h"
 #include "printk.h"
+#include "smp.h"
+#include "spin_lock.h"
 #include "stddef.h"
 #include "stdint.h"
 #include "stdlib.h"
 #include "string.h"
+#include "vm_space.h"
 
 page_directory_t  kernel_page_dir;
 page_directory_t *current_directory = 0;
 
+static spinlock_t page_table_lock = SPINLOCK_INIT(0); // Held while set_memory_type() splits and rewrites kernel leaves
+
 /* Page fault handling */
 INTERRUPT_BEGIN void page_fault_handle(interrupt_frame_t *frame, uint64_t error_code)
 {
@@ -383,7 +389,7 @@ void page_map_range_to_random(page_directory_t *directory, uint64_t addr, uint64
 pat_config_t get_pat_config(void)
 {
     pat_config_t config       = {0};
-    const char  *pat_types[8] = {"WB ", "WC ", "UC-", "UC ", "WB ", "WP ", "UC-", "WT "};
+    const char  *pat_types[8] = {"UC ", "WC ", "RSV", "RSV", "WT ", "WP ", "WB ", "UC-"};
     uint64_t     pat_value    = rdmsr(MSR_IA32_PAT);
     int          pos          = 0;
 
@@ -400,10 +406,144 @@ pat_config_t get_pat_config(void)
     return config;
 }
 
+/* Program the PAT layout on the current CPU */
+void pat_init(void)
+{
+    uint64_t rflags = get_rflags();
+    uint64_t cr0;
+
+    /* Intel SDM 11.12.4, caches must be disabled and flushed while the PAT changes */
+    disable_intr();
+    __asm__ volatile("mov %%cr0, %0" : "=r"(cr0));
+    __asm__ volatile("mov %0, %%cr0\n\t"
+                     "wbinvd\n\t"
+                     :
+                     : "r"(cr0 | (1UL << 30))
+                     : "memory");
+    flush_tlb_local();
+    wrmsr(MSR_IA32_PAT, PAT_LAYOUT);
+    __asm__ volatile("wbinvd" ::: "memory");
+    flush_tlb_local();
+    __asm__ volatile("mov %0, %%cr0" ::"r"(cr0) : "memory");
+    if (rflags & (1 << 9)) enable_intr();
+}
+
+/* Replace the cache bits of a leaf entry */
+static void page_set_cache_bits(page_table_entry_t *entry, memory_type_t type, int huge)
+{
+    uint64_t pat   = huge ? PTE_HUGE_PAT : PTE_PAT;
+    uint64_t value = entry->value & ~(PTE_PWT | PTE_PCD | pat);
+
+    if (type & 0x1) value |= PTE_PWT;
+    if (type & 0x2) value |= PTE_PCD;
+    if (type & 0x4) value |= pat;
+    entry->value = value;
+}
+
+/* Split a huge leaf into a table of smaller leaves with the same attributes */
+static page_table_t *page_split_huge(page_table_entry_t *entry, uint64_t child_size, int child_huge)
+{
+    uint64_t frame = alloc_frames(1);
+    if (frame == 0) return 0;
+
+    uint64_t      value = entry->value;
+    uint64_t      base  = value & (child_huge ? HUGE_PAGE_1G_MASK : HUGE_PAGE_2M_MASK);
+    uint64_t      flags = value & ~PAGE_FLAGS_MASK;
+    page_table_t *table = (page_table_t *)phys_to_virt(frame);
+
+    /* The PAT bit sits at bit 12 in huge leaves and at bit 7 in 4K leaves */
+    if (!child_huge) {
+        flags &= ~(uint64_t)PTE_HUGE;
+        if (value & PTE_HUGE_PAT) flags |= PTE_PAT;
+    } else {
+        flags |= value & PTE_HUGE_PAT;
+    }
+    for (int i = 0; i < 512; i++) table->entries[i].value = (base + i * child_size) | flags;
+
+    entry->value = frame | (value & (PTE_PRESENT | PTE_WRITEABLE | PTE_USER));
+    return table;
+}
+
+/* Walk to the leaf mapping `va`, splitting a huge leaf that [va, end) covers only in part, returns 0 on a hole or a failed split */
+static page_table_entry_t *page_leaf_prepare(uint64_t va, uint64_t end, uint64_t *size)
+{
+    page_table_entry_t *l4_entry = &kernel_page_dir.table->entries[(va >> 39) & 0x1ff];
+    if (!(l4_entry->value & PTE_PRESENT)) return 0;
+
+    page_table_t       *l3_table = (page_table_t *)phys_to_virt(l4_entry->value & PAGE_FLAGS_MASK);
+    page_table_entry_t *l3_entry = &l3_table->entries[(va >> 30) & 0x1ff];
+    if (!(l3_entry->value & PTE_PRESENT)) return 0;
+    if (is_huge_page(l3_entry)) {
+        *size = HUGE_1G_SIZE;
+        if (!(va & (HUGE_1G_SIZE - 1)) && end - va >= HUGE_1G_SIZE) return l3_entry;
+        if (!page_split_huge(l3_entry, HUGE_2M_SIZE, 1)) return 0;
+    }
+
+    page_table_t       *l2_table = (page_table_t *)phys_to_virt(l3_entry->value & PAGE_FLAGS_MASK);
+    page_table_entry_t *l2_entry = &l2_table->entries[(va >> 21) & 0x1ff];
+    if (!(l2_entry->value & PTE_PRESENT)) return 0;
+    if (is_huge_page(l2_entry)) {
+        *size = HUGE_2M_SIZE;
+        if (!(va & (HUGE_2M_SIZE - 1)) && end - va >= HUGE_2M_SIZE) return l2_entry;
+        if (!page_split_huge(l2_entry, PAGE_SIZE, 0)) return 0;
+    }
+
+    page_table_t       *l1_table = (page_table_t *)phys_to_virt(l2_entry->value & PAGE_FLAGS_MASK);
+    page_table_entry_t *l1_entry = &l1_table->entries[(va >> 12) & 0x1ff];
+    *size                        = PAGE_SIZE;
+    return (l1_entry->value & PTE_PRESENT) ? l1_entry : 0;
+}
+
+/* Cross-CPU call of set_memory_type(), drops the translations of the range in `info` */
+static void page_flush_range(void *info)
+{
+    uint64_t *range = (uint64_t *)info;
+    flush_tlb_range(range[0], range[1]);
+}
+
+/* Change the memory type of a kernel virtual range */
+int set_memory_type(uint64_t addr, uint64_t length, memory_type_t type) // NOLINT
+{
+    uint64_t range[2] = {ALIGN_DOWN(addr, PAGE_SIZE), ALIGN_UP(addr + length, PAGE_SIZE)};
+    uint64_t size     = PAGE_SIZE;
+
+    /* Check the whole range and do every split first, a split keeps the translations, so a failure changes no type */
+    uint64_t flags = spin_lock_irqsave(&page_table_lock);
+    for (uint64_t va = range[0]; va < range[1]; va += size) {
+        if (page_leaf_prepare(va, range[1], &size)) continue;
+        spin_unlock_irqrestore(&page_table_lock, flags);
+        return 1;
+    }
+    for (uint64_t va = range[0]; va < range[1]; va += size) {
+        page_table_entry_t *leaf = page_leaf_prepare(va, range[1], &size);
+        page_set_cache_bits(leaf, type, size != PAGE_SIZE);
+    }
+    spin_unlock_irqrestore(&page_table_lock, flags);
+
+    /* INVLPG drops global entries too, the other CPUs have flushed once the call returns */
+    flush_tlb_range(range[0], range[1]);
+    smp_call_function_many(0, page_flush_range, range, 1);
+
+    /* Write back lines cached under the old type */
+    if (cpu_support_clflush()) {
+        uint64_t line = get_cpu_clflush_size();
+        if (!line) line = 64;
+        for (uint64_t va = range[0]; va < range[1]; va += line) __asm__ volatile("clflush (%0)" ::"r"(va) : "memory");
+        __asm__ volatile("mfence" ::: "memory");
+    } else {
+        __asm__ volatile("wbinvd" ::: "memory");
+    }
+    return 0;
+}
+
 /* Initialize memory page table */
 void page_init(void)
 {
     page_table_t *kernel_page_table = phys_to_virt(get_cr3());
     kernel_page_dir                 = (page_directory_t) {.table = kernel_page_table};
     current_directory               = &kernel_page_dir;
+
+    /* The kernel window is shared by every directory, nodes are allocated lazily so the space can be set up before the heap */
+    vm_space_init(get_kernel_vm_space(), KERNEL_VM_START, KERNEL_VM_END);
+    pat_init();
 }
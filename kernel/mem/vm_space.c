@@ -0,0 +1,284 @@
+/*
+ *
+ *      vm_space.c
+ *      Virtual address space allocator
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "vm_space.h"
+#include "alloc.h"
+#include "page.h"
+#include "rbtree.h"
+#include "spin_lock.h"
+#include "stddef.h"
+#include "stdint.h"
+#include "stdlib.h"
+
+static vm_space_t kernel_vm_space;
+
+/* Recompute the largest gap of a subtree */
+static void vm_area_augment(rb_node_t *node)
+{
+    vm_area_t *area = rb_entry(node, vm_area_t, node);
+    uintptr_t  max  = area->gap;
+
+    if (node->left) max = MAX(max, rb_entry(node->left, vm_area_t, node)->max_gap);
+    if (node->right) max = MAX(max, rb_entry(node->right, vm_area_t, node)->max_gap);
+    area->max_gap = max;
+}
+
+/* Returns the end of the range before `area`, or the space base */
+static uintptr_t vm_prev_end(vm_space_t *space, vm_area_t *area)
+{
+    rb_node_t *prev = rb_prev(&area->node);
+    return prev ? rb_entry(prev, vm_area_t, node)->end : space->base;
+}
+
+/* Refresh the gap of the range after `node` once its predecessor changed */
+static void vm_update_next_gap(vm_space_t *space, rb_node_t *next)
+{
+    if (!next) return;
+    vm_area_t *area = rb_entry(next, vm_area_t, node);
+    area->gap       = area->start - vm_prev_end(space, area);
+    rb_propagate(next, vm_area_augment);
+}
+
+/* Returns the aligned address where a gap ending at `gap_end` fits `size` bytes, or 0 */
+static uintptr_t vm_gap_fit(uintptr_t gap_start, uintptr_t gap_end, uintptr_t hint, size_t size, size_t align)
+{
+    uintptr_t addr = ALIGN_UP(MAX(gap_start, hint), align);
+    if (addr < gap_start || addr >= gap_end || gap_end - addr < size) return 0;
+    return addr;
+}
+
+/* Lowest-address descent, subtrees whose largest gap is too small are never visited */
+static uintptr_t vm_search(rb_node_t *node, uintptr_t hint, size_t size, size_t align) // NOLINT
+{
+    if (!node) return 0;
+    vm_area_t *area = rb_entry(node, vm_area_t, node);
+    if (area->max_gap < size) return 0;
+
+    /* Every gap on the left ends before this range starts */
+    if (area->start > hint) {
+        uintptr_t addr = vm_search(node->left, hint, size, align);
+        if (addr) return addr;
+    }
+    if (area->gap >= size) {
+        uintptr_t addr = vm_gap_fit(area->start - area->gap, area->start, hint, size, align);
+        if (addr) return addr;
+    }
+    return vm_search(node->right, hint, size, align);
+}
+
+/* Find a free range, the caller holds the lock */
+static uintptr_t vm_find_locked(vm_space_t *space, uintptr_t hint, size_t size, size_t align)
+{
+    uintptr_t addr = vm_search(space->root.node, hint, size, align);
+    if (addr) return addr;
+
+    /* Fall back to the gap between the last range and the limit */
+    rb_node_t *last     = rb_last(&space->root);
+    uintptr_t  tail_min = last ? rb_entry(last, vm_area_t, node)->end : space->base;
+    return vm_gap_fit(tail_min, space->limit, hint, size, align);
+}
+
+/* Insert a range, the caller holds the lock and has checked for overlaps */
+static void vm_insert_locked(vm_space_t *space, vm_area_t *area)
+{
+    rb_node_t **link   = &space->root.node;
+    rb_node_t  *parent = 0;
+
+    while (*link) {
+        parent = *link;
+        if (area->start < rb_entry(parent, vm_area_t, node)->start)
+            link = &parent->left;
+        else
+            link = &parent->right;
+    }
+    rb_link_node(&area->node, parent, link);
+    area->gap     = area->start - vm_prev_end(space, area);
+    area->max_gap = area->gap;
+    rb_insert_color(&space->root, &area->node, vm_area_augment);
+    vm_update_next_gap(space, rb_next(&area->node));
+    space->count++;
+}
+
+/* Find the range containing `addr`, the caller holds the lock */
+static vm_area_t *vm_lookup_locked(vm_space_t *space, uintptr_t addr)
+{
+    rb_node_t *node = space->root.node;
+
+    while (node) {
+        vm_area_t *area = rb_entry(node, vm_area_t, node);
+        if (addr < area->start)
+            node = node->left;
+        else if (addr >= area->end)
+            node = node->right;
+        else
+            return area;
+    }
+    return 0;
+}
+
+/* Check [start, end) against its neighbours, the caller holds the lock */
+static int vm_range_free_locked(vm_space_t *space, uintptr_t start, uintptr_t end)
+{
+    rb_node_t *node  = space->root.node;
+    vm_area_t *after = 0;
+
+    /* Find the first range that ends after `start` */
+    while (node) {
+        vm_area_t *area = rb_entry(node, vm_area_t, node);
+        if (area->end > start) {
+            after = area;
+            node  = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+    return !after || after->start >= end;
+}
+
+/* Initialize an empty address space covering [base, limit) */
+void vm_space_init(vm_space_t *space, uintptr_t base, uintptr_t limit)
+{
+    rb_root_init(&space->root);
+    space->base  = ALIGN_UP(base, PAGE_SIZE);
+    space->limit = ALIGN_DOWN(limit, PAGE_SIZE);
+    space->count = 0;
+    spin_lock_init(&space->lock, 0);
+}
+
+/* Free every range of an address space */
+void vm_space_destroy(vm_space_t *space)
+{
+    uint64_t rflags = spin_lock_irqsave(&space->lock);
+    rb_node_t *node = space->root.node;
+
+    /* Post-order teardown without rebalancing */
+    while (node) {
+        if (node->left) {
+            node = node->left;
+        } else if (node->right) {
+            node = node->right;
+        } else {
+            rb_node_t *parent = node->parent;
+            if (parent) {
+                if (parent->left == node)
+                    parent->left = 0;
+                else
+                    parent->right = 0;
+            }
+            free(rb_entry(node, vm_area_t, node));
+            node = parent;
+        }
+    }
+    rb_root_init(&space->root);
+    space->count = 0;
+    spin_unlock_irqrestore(&space->lock, rflags);
+}
+
+/* Find (without reserving) the lowest free range of `size` bytes at or above `hint` */
+uintptr_t vm_space_find_free(vm_space_t *space, uintptr_t hint, size_t size)
+{
+    if (!space || !size) return 0;
+    size = ALIGN_UP(size, PAGE_SIZE);
+
+    uint64_t rflags = spin_lock_irqsave(&space->lock);
+    uintptr_t addr = vm_find_locked(space, hint, size, PAGE_SIZE);
+    spin_unlock_irqrestore(&space->lock, rflags);
+    return addr;
+}
+
+/* Reserve the lowest free range of `size` bytes at or above `hint`, aligned to `align` */
+uintptr_t vm_space_alloc(vm_space_t *space, uintptr_t hint, size_t size, size_t align, uint64_t flags)
+{
+    if (!space || !size) return 0;
+    size  = ALIGN_UP(size, PAGE_SIZE);
+    align = MAX(align, PAGE_SIZE);
+
+    vm_area_t *area = malloc(sizeof(vm_area_t));
+    if (!area) return 0;
+
+    uint64_t rflags = spin_lock_irqsave(&space->lock);
+    uintptr_t addr = vm_find_locked(space, hint, size, align);
+    if (!addr) {
+        spin_unlock_irqrestore(&space->lock, rflags);
+        free(area);
+        return 0;
+    }
+    area->start = addr;
+    area->end   = addr + size;
+    area->flags = flags;
+    vm_insert_locked(space, area);
+    spin_unlock_irqrestore(&space->lock, rflags);
+    return addr;
+}
+
+/* Reserve the fixed range [start, start + size) */
+int vm_space_reserve(vm_space_t *space, uintptr_t start, size_t size, uint64_t flags)
+{
+    if (!space || !size) return 1;
+    uintptr_t end = ALIGN_UP(start + size, PAGE_SIZE);
+    start         = ALIGN_DOWN(start, PAGE_SIZE);
+    if (start < space->base || end > space->limit || end <= start) return 1;
+
+    vm_area_t *area = malloc(sizeof(vm_area_t));
+    if (!area) return 1;
+
+    uint64_t rflags = spin_lock_irqsave(&space->lock);
+    if (!vm_range_free_locked(space, start, end)) {
+        spin_unlock_irqrestore(&space->lock, rflags);
+        free(area);
+        return 1;
+    }
+    area->start = start;
+    area->end   = end;
+    area->flags = flags;
+    vm_insert_locked(space, area);
+    spin_unlock_irqrestore(&space->lock, rflags);
+    return 0;
+}
+
+/* Release the range starting at `start` */
+int vm_space_free(vm_space_t *space, uintptr_t start)
+{
+    if (!space) return 1;
+
+    uint64_t rflags = spin_lock_irqsave(&space->lock);
+    vm_area_t *area = vm_lookup_locked(space, start);
+    if (!area || area->start != start) {
+        spin_unlock_irqrestore(&space->lock, rflags);
+        return 1;
+    }
+    rb_node_t *next = rb_next(&area->node);
+    rb_erase(&space->root, &area->node, vm_area_augment);
+    vm_update_next_gap(space, next);
+    space->count--;
+    spin_unlock_irqrestore(&space->lock, rflags);
+
+    free(area);
+    return 0;
+}
+
+/* Copy the range containing `addr` into `range`, returns 1 if no range contains it */
+int vm_space_find(vm_space_t *space, uintptr_t addr, vm_range_t *range)
+{
+    if (!space || !range) return 1;
+
+    uint64_t rflags = spin_lock_irqsave(&space->lock);
+    vm_area_t *area = vm_lookup_locked(space, addr);
+    if (area) *range = (vm_range_t) {area->start, area->end, area->flags};
+    spin_unlock_irqrestore(&space->lock, rflags);
+    return !area;
+}
+
+/* Returns the kernel address space */
+vm_space_t *get_kernel_vm_space(void)
+{
+    return &kernel_vm_space;
+}
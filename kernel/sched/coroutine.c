@@ -0,0 +1,256 @@
+/*
+ *
+ *      coroutine.c
+ *      Stackful kernel coroutines
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "coroutine.h"
+#include "double_list.h"
+#include "frame.h"
+#include "page.h"
+#include "sched.h"
+#include "spin_lock.h"
+#include "stddef.h"
+#include "stdint.h"
+#include "stdlib.h"
+#include "string.h"
+#include "vm_space.h"
+#include "wait.h"
+
+#define CO_STACK_PAGES (CO_STACK_SIZE / PAGE_SIZE)
+#define CO_SLOT_SIZE   (CO_STACK_SIZE + PAGE_SIZE) // A stack and the unmapped guard page below it
+
+static spinlock_t co_pool_lock = SPINLOCK_INIT(0);
+static uintptr_t  co_pool_base;   // Window of CO_POOL_SLOTS slots, reserved with the first coroutine
+static uint32_t   co_pool_mapped; // Slots below this one have their stack mapped
+static uintptr_t  co_pool_free;   // Stacks given back, linked through their lowest word
+
+/* Save the current context and resume another one on the same thread (switch.s) */
+void co_switch(uint64_t *prev_rsp, uint64_t next_rsp);
+
+/* First code run by a new coroutine (switch.s) */
+void co_trampoline(void);
+
+/* C half of the new coroutine entry, called from co_trampoline */
+void co_start(void);
+
+/* Map the stack of the next untouched slot, its guard page stays unmapped, returns 0 when out of slots or frames */
+static uintptr_t co_stack_map(void)
+{
+    uint64_t frames[CO_STACK_PAGES];
+    if (!co_pool_base) co_pool_base = vm_space_alloc(get_kernel_vm_space(), 0, (size_t)CO_POOL_SLOTS * CO_SLOT_SIZE, PAGE_SIZE, VM_AREA_STACK);
+    if (!co_pool_base || co_pool_mapped == CO_POOL_SLOTS) return 0;
+
+    for (uint32_t i = 0; i < CO_STACK_PAGES; i++) {
+        frames[i] = alloc_frames(1);
+        if (frames[i]) continue;
+        while (i--) free_frame(frames[i]);
+        return 0;
+    }
+
+    uintptr_t stack = co_pool_base + (uintptr_t)co_pool_mapped++ * CO_SLOT_SIZE + PAGE_SIZE;
+    for (uint32_t i = 0; i < CO_STACK_PAGES; i++) page_map_to(get_kernel_pagedir(), stack + i * PAGE_SIZE, frames[i], KERNEL_PTE_FLAGS);
+    return stack;
+}
+
+/* Take a stack from the pool, returns its lowest byte or 0 */
+static uintptr_t co_stack_alloc(void)
+{
+    uint64_t  flags = spin_lock_irqsave(&co_pool_lock);
+    uintptr_t stack = co_pool_free;
+    if (stack)
+        co_pool_free = *(uintptr_t *)stack;
+    else
+        stack = co_stack_map();
+    spin_unlock_irqrestore(&co_pool_lock, flags);
+    return stack;
+}
+
+/* Give a stack back to the pool, it stays mapped for the next coroutine */
+static void co_stack_free(uintptr_t stack)
+{
+    uint64_t flags = spin_lock_irqsave(&co_pool_lock);
+    *(uintptr_t *)stack = co_pool_free;
+    co_pool_free        = stack;
+    spin_unlock_irqrestore(&co_pool_lock, flags);
+}
+
+/* Put a coroutine on the ready list, the executor lock is held */
+static void co_enqueue(co_sched_t *sched, coroutine_t *co)
+{
+    co->state = CO_READY;
+    ilist_insert_before(&sched->ready, &co->node);
+    sched->nr_ready++;
+}
+
+/* Wait queue callback of co_await(), readies a switched-out coroutine */
+static void co_wake(wait_queue_entry_t *entry)
+{
+    coroutine_t *co    = (coroutine_t *)((char *)entry - offsetof(coroutine_t, wait));
+    co_sched_t  *sched = co->sched;
+    int          kick  = 0;
+
+    uint64_t flags = spin_lock_irqsave(&sched->lock);
+    if (co->state == CO_WAITING) {
+        co->state = CO_RUNNING; // Not switched out yet, co_suspend() returns at once
+    } else if (co->state == CO_SLEEPING) {
+        co_enqueue(sched, co);
+        kick = 1;
+    }
+    spin_unlock_irqrestore(&sched->lock, flags);
+    if (kick) wake_up(&sched->wait);
+}
+
+/* C half of the new coroutine entry, called from co_trampoline */
+void co_start(void)
+{
+    co_sched_t  *sched = get_current_thread()->co;
+    coroutine_t *co    = sched->current;
+
+    co->entry(co->arg);
+    co->state = CO_DEAD;
+    co_switch(&co->rsp, sched->rsp);
+}
+
+/* Initialize an executor without coroutines */
+void co_sched_init(co_sched_t *sched)
+{
+    memset(sched, 0, sizeof(co_sched_t));
+    spin_lock_init(&sched->lock, 0);
+    ilist_init(&sched->ready);
+    wait_queue_init(&sched->wait);
+}
+
+/* Create a coroutine and queue it on an executor, returns 0 if no stack is left */
+coroutine_t *co_create(co_sched_t *sched, void (*entry)(void *arg), void *arg)
+{
+    uintptr_t stack = co_stack_alloc();
+    if (!stack) return 0;
+
+    /* The coroutine sits at the top of its own stack, a slot is all the memory it takes */
+    coroutine_t *co = (coroutine_t *)ALIGN_DOWN(stack + CO_STACK_SIZE - sizeof(coroutine_t), 64);
+    memset(co, 0, sizeof(coroutine_t));
+    co->sched = sched;
+    co->stack = stack;
+    co->entry = entry;
+    co->arg   = arg;
+    wait_entry_init_func(&co->wait, co_wake, 0);
+
+    /* Frame popped by co_switch: r15 r14 r13 r12 rbx rbp, then the return address */
+    pointer_cast_t cast;
+    cast.ptr      = co;
+    uint64_t *top = (uint64_t *)ALIGN_DOWN(cast.val, 16);
+    cast.ptr      = (void *)co_trampoline;
+    *--top        = cast.val;
+    for (int i = 0; i < 6; i++) *--top = 0;
+    cast.ptr = top;
+    co->rsp  = cast.val;
+
+    uint64_t flags = spin_lock_irqsave(&sched->lock);
+    sched->count++;
+    co_enqueue(sched, co);
+    spin_unlock_irqrestore(&sched->lock, flags);
+    wake_up(&sched->wait);
+    return co;
+}
+
+/* Run the coroutines of an executor on the calling thread until every one of them has returned */
+void co_run(co_sched_t *sched)
+{
+    thread_t *self = get_current_thread();
+    self->co       = sched;
+
+    while (1) {
+        uint64_t flags = spin_lock_irqsave(&sched->lock);
+        if (!sched->count) {
+            spin_unlock_irqrestore(&sched->lock, flags);
+            break;
+        }
+        if (ilist_is_empty(&sched->ready)) { // Every coroutine waits, sleep until one is woken
+            spin_unlock_irqrestore(&sched->lock, flags);
+            wait_event(sched->wait, sched->nr_ready);
+            continue;
+        }
+        coroutine_t *co = ilist_entry(sched->ready.next, coroutine_t, node);
+        ilist_remove(&co->node);
+        sched->nr_ready--;
+        co->state = CO_RUNNING;
+        spin_unlock_irqrestore(&sched->lock, flags);
+
+        sched->current = co;
+        sched->switches++;
+        co_switch(&sched->rsp, co->rsp);
+        sched->current = 0;
+
+        if (co->state == CO_DEAD) {
+            flags = spin_lock_irqsave(&sched->lock);
+            sched->count--;
+            spin_unlock_irqrestore(&sched->lock, flags);
+            co_stack_free(co->stack); // Off that stack again, nothing uses it any more
+        }
+    }
+    self->co = 0;
+}
+
+/* Returns the running coroutine, 0 outside one */
+coroutine_t *co_current(void)
+{
+    thread_t *self = get_current_thread();
+    return self && self->co ? self->co->current : 0;
+}
+
+/* Let the other ready coroutines run, outside a coroutine this is thread_yield() */
+void co_yield(void)
+{
+    coroutine_t *co = co_current();
+    if (!co) {
+        thread_yield();
+        return;
+    }
+
+    uint64_t flags = spin_lock_irqsave(&co->sched->lock);
+    co_enqueue(co->sched, co);
+    spin_unlock_irqrestore(&co->sched->lock, flags);
+    co_switch(&co->rsp, co->sched->rsp);
+}
+
+/* Queue the current coroutine on a wait queue and mark it waiting, check the condition afterwards */
+void co_prepare_wait(wait_queue_head_t *wq)
+{
+    coroutine_t *co    = co_current();
+    uint64_t     flags = spin_lock_irqsave(&co->sched->lock);
+    co->state          = CO_WAITING;
+    spin_unlock_irqrestore(&co->sched->lock, flags);
+    add_wait_queue(wq, &co->wait);
+}
+
+/* Switch away from the current coroutine unless a wakeup came after co_prepare_wait() */
+void co_suspend(void)
+{
+    coroutine_t *co    = co_current();
+    uint64_t     flags = spin_lock_irqsave(&co->sched->lock);
+    if (co->state != CO_WAITING) {
+        spin_unlock_irqrestore(&co->sched->lock, flags);
+        return;
+    }
+
+    /* A wakeup from here on queues it, only this thread's executor loop takes it off the list */
+    co->state = CO_SLEEPING;
+    spin_unlock_irqrestore(&co->sched->lock, flags);
+    co_switch(&co->rsp, co->sched->rsp);
+}
+
+/* Mark the current coroutine running again and dequeue it from the wait queue */
+void co_finish_wait(wait_queue_head_t *wq)
+{
+    coroutine_t *co    = co_current();
+    uint64_t     flags = spin_lock_irqsave(&co->sched->lock);
+    co->state          = CO_RUNNING;
+    spin_unlock_irqrestore(&co->sched->lock, flags);
+    remove_wait_queue(wq, &co->wait);
+}
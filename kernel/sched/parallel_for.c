@@ -0,0 +1,191 @@
+/*
+ *
+ *      parallel_for.c
+ *      Fork-join parallel loops
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "parallel_for.h"
+#include "alloc.h"
+#include "isolation.h"
+#include "printk.h"
+#include "sched.h"
+#include "smp.h"
+#include "spin_lock.h"
+#include "stdint.h"
+#include "string.h"
+#include "wait.h"
+
+static struct {
+        parallel_for_fn_t fn;
+        void             *arg;
+        uint64_t          grain;
+        uint32_t          helpers;   // Cap on helpers working on this loop
+        volatile uint64_t remaining; // Iterations not done yet, the loop is over at 0
+        volatile uint32_t active;    // Helpers inside the loop, the caller returns only once they have left
+} pfor_job;
+
+static pfor_deque_t     *pfor_deques;     // One per helper, the caller uses the last one
+static uint32_t          pfor_count;      // Helper threads
+static volatile int      pfor_busy;       // A loop is running, nested and concurrent ones run serially
+static volatile uint64_t pfor_generation; // Bumped for every loop handed to the helpers
+static volatile uint32_t pfor_cap = ~(uint32_t)0;
+static wait_queue_head_t pfor_wait;
+
+/* Push a range on the bottom of a deque, returns 1 if it is full */
+static int pfor_push(pfor_deque_t *deque, pfor_range_t range)
+{
+    uint64_t flags = spin_lock_irqsave(&deque->lock);
+    if (deque->bottom - deque->top == PFOR_DEQUE_SIZE) {
+        spin_unlock_irqrestore(&deque->lock, flags);
+        return 1;
+    }
+    deque->ranges[deque->bottom++ % PFOR_DEQUE_SIZE] = range;
+    spin_unlock_irqrestore(&deque->lock, flags);
+    return 0;
+}
+
+/* Pop the newest range from the bottom of the own deque, returns 1 if it is empty */
+static int pfor_pop(pfor_deque_t *deque, pfor_range_t *range)
+{
+    uint64_t flags = spin_lock_irqsave(&deque->lock);
+    if (deque->bottom == deque->top) {
+        spin_unlock_irqrestore(&deque->lock, flags);
+        return 1;
+    }
+    *range = deque->ranges[--deque->bottom % PFOR_DEQUE_SIZE];
+    spin_unlock_irqrestore(&deque->lock, flags);
+    return 0;
+}
+
+/* Take the oldest range from the top of another participant's deque, returns 1 if every deque is empty */
+static int pfor_steal(uint32_t self, pfor_range_t *range)
+{
+    for (uint32_t i = 1; i <= pfor_count; i++) {
+        pfor_deque_t *deque = &pfor_deques[(self + i) % (pfor_count + 1)];
+        if (deque->bottom == deque->top) continue; // Racy peek, the lock decides
+
+        uint64_t flags = spin_lock_irqsave(&deque->lock);
+        if (deque->bottom != deque->top) {
+            *range = deque->ranges[deque->top++ % PFOR_DEQUE_SIZE];
+            spin_unlock_irqrestore(&deque->lock, flags);
+            return 0;
+        }
+        spin_unlock_irqrestore(&deque->lock, flags);
+    }
+    return 1;
+}
+
+/* Work on the current loop until every iteration is done */
+static void pfor_work(uint32_t self)
+{
+    pfor_deque_t *deque = &pfor_deques[self];
+    pfor_range_t  range;
+
+    while (__atomic_load_n(&pfor_job.remaining, __ATOMIC_ACQUIRE)) {
+        if (pfor_pop(deque, &range) && pfor_steal(self, &range)) {
+            __asm__ volatile("pause"); // Everything left is running elsewhere
+            continue;
+        }
+
+        /* Leave the upper halves for thieves, run the lowest chunk here */
+        while (range.end - range.start > pfor_job.grain) {
+            uint64_t mid = range.start + (range.end - range.start) / 2;
+            if (pfor_push(deque, (pfor_range_t) {mid, range.end})) break;
+            range.end = mid;
+        }
+        pfor_job.fn(range.start, range.end, pfor_job.arg);
+        __atomic_sub_fetch(&pfor_job.remaining, range.end - range.start, __ATOMIC_RELEASE);
+    }
+}
+
+/* Helper thread, joins every loop published while it sleeps */
+static void pfor_helper(void *arg)
+{
+    pointer_cast_t cast;
+    cast.ptr      = arg;
+    uint32_t self = (uint32_t)cast.val;
+    uint64_t seen = 0;
+
+    while (1) {
+        wait_event(pfor_wait, pfor_generation != seen);
+        seen = pfor_generation;
+
+        /* A helper late for a finished loop sees remaining at 0 and leaves again */
+        if (__atomic_add_fetch(&pfor_job.active, 1, __ATOMIC_SEQ_CST) <= pfor_job.helpers) pfor_work(self);
+        __atomic_sub_fetch(&pfor_job.active, 1, __ATOMIC_RELEASE);
+    }
+}
+
+/* Start a helper thread on every housekeeping CPU, call once after workqueue_init() */
+void parallel_for_init(void)
+{
+    uint32_t cpus = get_cpu_count() ? get_cpu_count() : 1;
+    wait_queue_init(&pfor_wait);
+
+    pfor_deques = (pfor_deque_t *)aligned_alloc(64, sizeof(pfor_deque_t) * (cpus + 1));
+    if (!pfor_deques) {
+        plogk("pfor: Cannot allocate the deques, loops run serially.\n");
+        return;
+    }
+    memset(pfor_deques, 0, sizeof(pfor_deque_t) * (cpus + 1));
+    for (uint32_t i = 0; i <= cpus; i++) spin_lock_init(&pfor_deques[i].lock, 0);
+
+    pointer_cast_t cast;
+    uint32_t       count = 0;
+    for (uint32_t cpu = 0; cpu < cpus; cpu++) {
+        if (cpu_isolated(cpu)) continue;
+        cast.val = count;
+        count += thread_create_on("pfor", pfor_helper, cast.ptr, cpu, THREAD_PINNED) != 0;
+    }
+
+    /* The caller's deque sits right after the helpers */
+    pfor_count = count;
+    plogk("pfor: %u helper threads.\n", count);
+}
+
+/* Run fn over [start, end) in chunks of at least `grain` iterations on every helper and the caller, returns when all are done */
+void parallel_for(uint64_t start, uint64_t end, uint64_t grain, parallel_for_fn_t fn, void *arg)
+{
+    if (start >= end) return;
+    if (!grain) grain = 1;
+
+    /* Before the helpers exist, in interrupt context, nested in another loop or too small to split */
+    if (!pfor_count || end - start <= grain || !thread_can_sleep() || __atomic_exchange_n(&pfor_busy, 1, __ATOMIC_ACQUIRE)) {
+        fn(start, end, arg);
+        return;
+    }
+
+    pfor_job.fn      = fn;
+    pfor_job.arg     = arg;
+    pfor_job.grain   = grain;
+    pfor_job.helpers = pfor_cap;
+    pfor_push(&pfor_deques[pfor_count], (pfor_range_t) {start, end});
+
+    /* Publish the loop before waking anyone, a helper reads the fields after it sees remaining */
+    __atomic_store_n(&pfor_job.remaining, end - start, __ATOMIC_RELEASE);
+    if (pfor_job.helpers) {
+        __atomic_add_fetch(&pfor_generation, 1, __ATOMIC_RELEASE);
+        wake_up_all(&pfor_wait);
+    }
+
+    pfor_work(pfor_count);
+    while (__atomic_load_n(&pfor_job.active, __ATOMIC_ACQUIRE)) __asm__ volatile("pause");
+    __atomic_store_n(&pfor_busy, 0, __ATOMIC_RELEASE);
+}
+
+/* Cap the helpers joining the caller of parallel_for(), 0 runs every loop on the caller alone, returns the previous cap */
+uint32_t parallel_for_set_helpers(uint32_t helpers)
+{
+    return __atomic_exchange_n(&pfor_cap, helpers, __ATOMIC_RELAXED);
+}
+
+/* Returns the number of helper threads */
+uint32_t parallel_for_helpers(void)
+{
+    return pfor_count;
+}
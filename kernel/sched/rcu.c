@@ -0,0 +1,256 @@
+/*
+ *
+ *      rcu.c
+ *      Quiescent-state-based read-copy-update
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "rcu.h"
+#include "alloc.h"
+#include "apic.h"
+#include "common.h"
+#include "debug.h"
+#include "percpu.h"
+#include "printk.h"
+#include "sched.h"
+#include "smp.h"
+#include "spin_lock.h"
+#include "stdint.h"
+#include "string.h"
+#include "wait.h"
+#include "workqueue.h"
+
+/* Callbacks of one CPU, each batch waits for a single grace period */
+typedef struct rcu_data {
+        spinlock_t   lock;
+        rcu_head_t  *pending;      // Queued since the last batch was closed
+        rcu_head_t **pending_tail;
+        rcu_head_t  *waiting;      // Closed batch, ready once waiting_gp has completed
+        rcu_head_t **waiting_tail;
+        uint64_t     waiting_gp;
+        rcu_head_t  *ready;        // Past their grace period, run by the work item
+        rcu_head_t **ready_tail;
+        work_t       work;
+} __attribute__((aligned(64))) rcu_data_t;
+
+typedef struct rcu_sync {
+        rcu_head_t   head;
+        completion_t done;
+} rcu_sync_t;
+
+static volatile uint64_t rcu_gp_started;   // Grace periods begun
+static volatile uint64_t rcu_gp_completed; // Grace periods every CPU has passed
+static rcu_data_t       *rcu_data;
+static uint32_t          rcu_cpus;
+static volatile int      rcu_online = 0;
+
+/* CPUs that may hold read-side references, also right before rcu_init() has sized rcu_data */
+static inline uint32_t rcu_cpu_count(void)
+{
+    return get_cpu_count() ? get_cpu_count() : 1;
+}
+
+/* Returns the first grace period that begins after this call */
+static inline uint64_t rcu_gp_target(void)
+{
+    return __atomic_load_n(&rcu_gp_started, __ATOMIC_SEQ_CST) + 1;
+}
+
+/* Check whether grace period `gp` has completed */
+static inline int rcu_gp_done(uint64_t gp)
+{
+    return __atomic_load_n(&rcu_gp_completed, __ATOMIC_ACQUIRE) >= gp;
+}
+
+/* Begin grace period `target` if the previous one is over, then wake CPUs that sleep without a tick */
+static void rcu_start_gp(uint64_t target)
+{
+    uint64_t started = __atomic_load_n(&rcu_gp_started, __ATOMIC_ACQUIRE);
+    if (started >= target || __atomic_load_n(&rcu_gp_completed, __ATOMIC_ACQUIRE) != started) return;
+    if (!__atomic_compare_exchange_n(&rcu_gp_started, &started, started + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+        return;
+
+    /* Their idle loop reports the quiescent state once the IPI lands */
+    for (uint32_t i = 0; i < rcu_cpu_count(); i++) {
+        runqueue_t *rq = sched_runqueue(i);
+        if (rq && rq->tickless && i != get_current_cpu_id()) smp_send_reschedule(i);
+    }
+}
+
+/* Complete the running grace period once every scheduling CPU has passed a quiescent state */
+static void rcu_advance(void)
+{
+    uint64_t completed = __atomic_load_n(&rcu_gp_completed, __ATOMIC_ACQUIRE);
+    uint64_t started   = __atomic_load_n(&rcu_gp_started, __ATOMIC_ACQUIRE);
+    if (completed == started) return;
+
+    for (uint32_t i = 0; i < rcu_cpu_count(); i++) {
+        percpu_t *cpu = get_cpu_percpu(i);
+        if (!__atomic_load_n(&cpu->runqueue, __ATOMIC_ACQUIRE)) continue; // Not scheduling yet, holds no references
+        if (__atomic_load_n(&cpu->rcu_qs_seq, __ATOMIC_ACQUIRE) < started) return;
+    }
+    __atomic_compare_exchange_n(&rcu_gp_completed, &completed, started, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+/* Append a callback list to a segment */
+static inline void rcu_splice(rcu_head_t ***tail, rcu_head_t *list, rcu_head_t **list_tail)
+{
+    **tail = list;
+    *tail  = list_tail;
+}
+
+/* Move the callbacks of a CPU through their grace periods, returns 1 if some are ready */
+static int rcu_process(rcu_data_t *rdp)
+{
+    uint64_t flags = spin_lock_irqsave(&rdp->lock);
+
+    if (rdp->waiting && rcu_gp_done(rdp->waiting_gp)) {
+        rcu_splice(&rdp->ready_tail, rdp->waiting, rdp->waiting_tail);
+        rdp->waiting      = 0;
+        rdp->waiting_tail = &rdp->waiting;
+    }
+
+    /* Close the pending batch, it needs a grace period that starts after its last callback was queued */
+    if (!rdp->waiting && rdp->pending) {
+        rdp->waiting      = rdp->pending;
+        rdp->waiting_tail = rdp->pending_tail;
+        rdp->waiting_gp   = rcu_gp_target();
+        rdp->pending      = 0;
+        rdp->pending_tail = &rdp->pending;
+    }
+    uint64_t target = rdp->waiting ? rdp->waiting_gp : 0;
+    int      ready  = rdp->ready != 0;
+    spin_unlock_irqrestore(&rdp->lock, flags);
+
+    if (target) rcu_start_gp(target);
+    return ready;
+}
+
+/* Run the callbacks of a CPU that are past their grace period */
+static void rcu_work_fn(work_t *work)
+{
+    rcu_data_t *rdp   = ilist_entry(work, rcu_data_t, work);
+    uint64_t    flags = spin_lock_irqsave(&rdp->lock);
+    rcu_head_t *head  = rdp->ready;
+    rdp->ready        = 0;
+    rdp->ready_tail   = &rdp->ready;
+    spin_unlock_irqrestore(&rdp->lock, flags);
+
+    while (head) {
+        rcu_head_t *next = head->next;
+        head->func(head);
+        head = next;
+    }
+}
+
+/* Wake the caller of synchronize_rcu() */
+static void rcu_sync_fn(rcu_head_t *head)
+{
+    complete(&((rcu_sync_t *)head)->done);
+}
+
+/* Wait for a grace period without sleeping */
+static void rcu_sync_poll(void)
+{
+    uint64_t target = rcu_gp_target();
+    while (!rcu_gp_done(target)) {
+        rcu_qs(); // Spinning here holds no references either
+        rcu_start_gp(target);
+        rcu_advance();
+        __asm__ volatile("pause");
+    }
+}
+
+/* Report a quiescent state of the current CPU, the caller holds no RCU references */
+void rcu_qs(void)
+{
+    uint64_t started = __atomic_load_n(&rcu_gp_started, __ATOMIC_SEQ_CST);
+    if (this_cpu_read(rcu_qs_seq) != started) __atomic_store_n(&this_cpu()->rcu_qs_seq, started, __ATOMIC_SEQ_CST);
+}
+
+/* Report the quiescent state of an idle CPU right before it halts, interrupts must be off */
+void rcu_idle_enter(void)
+{
+    /* Pairs with rcu_start_gp(), either this sees the new grace period or the starter sees the stopped tick */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    rcu_qs();
+}
+
+/* Scheduler tick hook, reports a quiescent state and moves this CPU's callbacks on */
+void rcu_tick(void)
+{
+    if (!this_cpu_read(preempt_count)) rcu_qs(); // The interrupted code is outside every read-side section
+    rcu_advance();
+    if (!rcu_online) return; // Grace periods already complete, only the callback lists wait for rcu_init()
+
+    uint32_t cpu = get_current_cpu_id();
+    if (rcu_process(&rcu_data[cpu])) queue_work_on(cpu, system_wq, &rcu_data[cpu].work);
+}
+
+/* Check whether the current CPU has callbacks and must keep its tick */
+int rcu_needs_cpu(void)
+{
+    if (!rcu_online) return 0;
+    rcu_data_t *rdp = &rcu_data[get_current_cpu_id()];
+    return rdp->pending || rdp->waiting || rdp->ready;
+}
+
+/* Run `func` once every CPU has passed a quiescent state, callable from interrupt handlers */
+void call_rcu(rcu_head_t *head, rcu_callback_t func)
+{
+    head->next = 0;
+    head->func = func;
+    if (!rcu_online) { // No per-CPU lists yet
+        rcu_sync_poll();
+        func(head);
+        return;
+    }
+
+    /* Migrating before the lock is taken only queues it on the previous CPU */
+    rcu_data_t *rdp   = &rcu_data[get_current_cpu_id()];
+    uint64_t    flags = spin_lock_irqsave(&rdp->lock);
+    rcu_splice(&rdp->pending_tail, head, &head->next);
+    spin_unlock_irqrestore(&rdp->lock, flags);
+}
+
+/* Wait until every read-side critical section running at the call has finished */
+void synchronize_rcu(void)
+{
+    if (get_cpu_count() <= 1) return; // The caller is the only CPU and is outside every read-side section, rcu_cpus is 0 before rcu_init()
+
+    if (!thread_can_sleep()) {
+        rcu_sync_poll();
+        return;
+    }
+
+    rcu_sync_t sync;
+    init_completion(&sync.done);
+    call_rcu(&sync.head, rcu_sync_fn);
+    wait_for_completion(&sync.done);
+}
+
+/* Set up the per-CPU callback lists, needs the workqueues */
+void rcu_init(void)
+{
+    rcu_cpus = get_cpu_count() ? get_cpu_count() : 1;
+    rcu_data = (rcu_data_t *)aligned_alloc(64, sizeof(rcu_data_t) * rcu_cpus);
+    if (!rcu_data) panic("rcu: Cannot allocate the per-CPU callback lists.");
+    memset(rcu_data, 0, sizeof(rcu_data_t) * rcu_cpus);
+
+    for (uint32_t i = 0; i < rcu_cpus; i++) {
+        rcu_data_t *rdp = &rcu_data[i];
+        spin_lock_init(&rdp->lock, 0);
+        rdp->pending_tail = &rdp->pending;
+        rdp->waiting_tail = &rdp->waiting;
+        rdp->ready_tail   = &rdp->ready;
+        init_work(&rdp->work, rcu_work_fn);
+    }
+
+    compiler_barrier();
+    rcu_online = 1;
+    plogk("rcu: %u CPUs, callbacks batched per CPU.\n", rcu_cpus);
+}
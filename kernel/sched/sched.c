@@ -0,0 +1,749 @@
+/*
+ *
+ *      sched.c
+ *      Kernel thread scheduler
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "sched.h"
+#include "acpi.h"
+#include "alloc.h"
+#include "apic.h"
+#include "common.h"
+#include "cpumask.h"
+#include "debug.h"
+#include "double_list.h"
+#include "fpu.h"
+#include "idle.h"
+#include "isolation.h"
+#include "percpu.h"
+#include "printk.h"
+#include "rcu.h"
+#include "smp.h"
+#include "spin_lock.h"
+#include "stddef.h"
+#include "stdint.h"
+#include "string.h"
+#include "tick.h"
+#include "topology.h"
+
+#define RFLAGS_IF (1 << 9)
+
+static runqueue_t       *runqueues;
+static uint32_t          runqueue_count;
+static volatile int      sched_online = 0;
+static volatile uint64_t next_tid     = 1;
+static thread_t          boot_thread; // The context that called sched_init()
+
+static const char *sched_domain_names[SD_LEVELS] = {"smt", "llc", "package", "system"};
+
+static DEFINE_SPIN_LOCK_CLASS(runqueue_lock_class, "runqueue");
+
+/* Save the current context and resume another one (switch.s) */
+void switch_context(uint64_t *prev_rsp, uint64_t next_rsp);
+
+/* First code run by a new thread (switch.s) */
+void thread_trampoline(void);
+
+/* C half of the new thread entry, called from thread_trampoline */
+void thread_start(void);
+
+/* Lock a run queue with interrupts off, returns the previous RFLAGS */
+static inline uint64_t runqueue_lock(runqueue_t *rq)
+{
+    return spin_lock_irqsave(&rq->lock);
+}
+
+/* Unlock a run queue and restore the interrupt flag */
+static inline void runqueue_unlock(runqueue_t *rq, uint64_t flags)
+{
+    spin_unlock_irqrestore(&rq->lock, flags);
+}
+
+/* Insert a deadline thread by absolute deadline, the caller holds the lock */
+static void dl_enqueue(runqueue_t *rq, thread_t *thread)
+{
+    rb_node_t **link     = &rq->dl_root.node;
+    rb_node_t  *parent   = 0;
+    int         leftmost = 1;
+
+    while (*link) {
+        parent = *link;
+        if (thread->dl_abs < rb_entry(parent, thread_t, dl_node)->dl_abs) {
+            link = &parent->left;
+        } else {
+            link     = &parent->right; // Equal deadlines run in queueing order
+            leftmost = 0;
+        }
+    }
+    rb_link_node(&thread->dl_node, parent, link);
+    rb_insert_color(&rq->dl_root, &thread->dl_node, 0);
+
+    if (leftmost) rq->dl_first = thread;
+    rq->nr_deadline++;
+}
+
+/* Take the earliest deadline thread off a run queue, the caller holds the lock */
+static thread_t *dl_dequeue_first(runqueue_t *rq)
+{
+    thread_t  *thread = rq->dl_first;
+    rb_node_t *next   = rb_next(&thread->dl_node);
+    rq->dl_first      = next ? rb_entry(next, thread_t, dl_node) : 0;
+    rb_erase(&rq->dl_root, &thread->dl_node, 0);
+    rq->nr_deadline--;
+    return thread;
+}
+
+/* Append a thread to a run queue, the caller holds the lock */
+static void runqueue_push(runqueue_t *rq, thread_t *thread)
+{
+    thread->state = THREAD_READY;
+    thread->cpu   = rq->cpu;
+    if (thread->policy == SCHED_DEADLINE)
+        dl_enqueue(rq, thread);
+    else
+        ilist_insert_before(&rq->ready, &thread->run_node);
+    rq->nr_ready++;
+}
+
+/* Take the next thread off a run queue, deadline threads before normal ones, the caller holds the lock */
+static thread_t *runqueue_pop(runqueue_t *rq)
+{
+    if (rq->dl_first) {
+        rq->nr_ready--;
+        return dl_dequeue_first(rq);
+    }
+    if (ilist_is_empty(&rq->ready)) return 0;
+    ilist_node_t *node = rq->ready.next;
+    ilist_remove(node);
+    rq->nr_ready--;
+    return ilist_entry(node, thread_t, run_node);
+}
+
+/* Start the next period of a deadline thread, the debt of an overrun carries over */
+static void dl_replenish(thread_t *thread, uint64_t now)
+{
+    if (thread->dl_yielded) thread->dl_budget = 0;
+    thread->dl_yielded = 0;
+    do {
+        thread->dl_abs += thread->dl.period;
+        thread->dl_budget += thread->dl.runtime;
+    } while (thread->dl_budget <= 0);
+    if (thread->dl_budget > (int64_t)thread->dl.runtime) thread->dl_budget = thread->dl.runtime;
+
+    /* Blocked or throttled past its deadline, a fresh period starts now */
+    if (thread->dl_abs <= now) {
+        thread->dl_abs    = now + thread->dl.deadline;
+        thread->dl_budget = thread->dl.runtime;
+    }
+}
+
+/* CBS wakeup rule: keep the deadline only if the budget left cannot exceed the reserved bandwidth before it */
+static void dl_wakeup(thread_t *thread, uint64_t now)
+{
+    if (thread->dl_abs > now && thread->dl_budget > 0 &&
+        ((uint64_t)thread->dl_budget << SCHED_DL_BW_SHIFT) / (thread->dl_abs - now) <= thread->dl_bw)
+        return;
+    thread->dl_abs    = now + thread->dl.deadline;
+    thread->dl_budget = thread->dl.runtime;
+}
+
+/* Preempt the thread running on a run queue's CPU if a deadline thread just queued there has to run first */
+static void dl_check_preempt(runqueue_t *rq, thread_t *thread)
+{
+    thread_t *current = get_cpu_percpu(rq->cpu)->current_thread;
+    if (current && current->policy == SCHED_DEADLINE && current->dl_abs <= thread->dl_abs) return;
+    if (rq->cpu == get_current_cpu_id())
+        smp_send_reschedule_self(); // Taken once the caller's interrupt or locked section is over
+    else
+        smp_send_reschedule(rq->cpu);
+}
+
+/* Replenishment timer, puts a throttled deadline thread back on its run queue */
+static hrtimer_restart_t dl_timer_func(hrtimer_t *timer)
+{
+    thread_t   *thread = (thread_t *)((char *)timer - offsetof(thread_t, dl_timer));
+    runqueue_t *rq     = &runqueues[thread->cpu];
+    uint64_t    flags  = runqueue_lock(rq);
+
+    if (thread->dl_throttled) {
+        thread->dl_throttled = 0;
+        dl_replenish(thread, nano_time());
+        runqueue_push(rq, thread);
+        dl_check_preempt(rq, thread);
+    }
+    runqueue_unlock(rq, flags);
+    return HRTIMER_NORESTART;
+}
+
+/* Budget timer, the running deadline thread has used up its runtime */
+static hrtimer_restart_t dl_enforce_func(hrtimer_t *timer)
+{
+    (void)timer;
+    smp_send_reschedule_self();
+    return HRTIMER_NORESTART;
+}
+
+/* Charge a deadline thread for its time on the CPU and throttle it once its budget or period is used up */
+static void dl_account(thread_t *thread, uint64_t now)
+{
+    thread->dl_budget -= (int64_t)(now - thread->dl_exec_start);
+    thread->dl_exec_start = now;
+    if (thread->state != THREAD_RUNNING || (thread->dl_budget > 0 && !thread->dl_yielded)) return;
+
+    /* Hard reservation: no more CPU time until the next period starts */
+    uint64_t next = thread->dl_abs - thread->dl.deadline + thread->dl.period;
+    if (next <= now) {
+        dl_replenish(thread, now);
+        return;
+    }
+    thread->dl_throttled = 1;
+    thread->state        = THREAD_READY;
+    hrtimer_start(&thread->dl_timer, next);
+}
+
+/* Returns the CPUs sharing a topology level with a CPU, 0 without topology or for SD_SYSTEM */
+static const cpumask_t *sched_level_mask(uint32_t cpu, uint32_t level)
+{
+    const cpu_topology_t *topo = cpu_topology(cpu);
+    if (!topo) return 0;
+    switch (level) {
+        case SD_SMT :
+            return &topo->smt_mask;
+        case SD_LLC :
+            return &topo->llc_mask;
+        case SD_PACKAGE :
+            return &topo->package_mask;
+        default :
+            return 0;
+    }
+}
+
+/* Returns the threads a CPU has to run, counting the one on it unless it is idle */
+static uint32_t sched_cpu_load(uint32_t cpu)
+{
+    runqueue_t *rq      = &runqueues[cpu];
+    thread_t   *current = get_cpu_percpu(cpu)->current_thread;
+    return rq->nr_ready + (current && current != rq->idle);
+}
+
+/* Returns the summed load of the CPUs in a mask */
+static uint32_t sched_mask_load(const cpumask_t *mask)
+{
+    uint32_t cpu, load = 0;
+    for_each_cpu(cpu, mask) {
+        if (cpu >= runqueue_count) break;
+        load += sched_cpu_load(cpu);
+    }
+    return load;
+}
+
+/* Take the coldest stealable thread off another run queue */
+static thread_t *runqueue_steal(runqueue_t *self, runqueue_t *busiest)
+{
+    spin_lock(&busiest->lock);
+    for (ilist_node_t *node = busiest->ready.prev; node != &busiest->ready; node = node->prev) {
+        thread_t *thread = ilist_entry(node, thread_t, run_node);
+        if (thread->on_cpu) continue; // Its context is not saved yet
+        if (thread->flags & THREAD_PINNED) continue;
+        ilist_remove(node);
+        busiest->nr_ready--;
+        thread->cpu = self->cpu;
+        spin_unlock(&busiest->lock);
+        self->steals++;
+        return thread;
+    }
+    spin_unlock(&busiest->lock);
+    return 0;
+}
+
+/* Pull a thread from the busiest CPU of the nearest domain that has surplus work */
+static thread_t *sched_steal(runqueue_t *self)
+{
+    for (uint32_t d = 0; d < self->nr_domains; d++) {
+        runqueue_t *busiest = 0;
+        size_t      most    = 0;
+        uint32_t    cpu;
+
+        for_each_cpu(cpu, &self->domains[d]) {
+            if (cpu >= runqueue_count) break;
+            if (d && cpumask_test_cpu(&self->domains[d - 1], cpu)) continue; // Already looked at
+            runqueue_t *rq = &runqueues[cpu];
+            if (rq != self && rq->nr_ready > most) {
+                most    = rq->nr_ready;
+                busiest = rq;
+            }
+        }
+        if (!busiest) continue;
+
+        /* Cache-sharing siblings come first, their threads find a warm cache here */
+        thread_t *thread = runqueue_steal(self, busiest);
+        if (thread) return thread;
+    }
+    return 0;
+}
+
+/* Build the nested CPU spans a run queue balances over, duplicates and single CPUs left out */
+static void sched_build_domains(runqueue_t *rq)
+{
+    cpumask_t system, span;
+    cpumask_fill(&system, runqueue_count);
+
+    /* Isolated CPUs neither steal nor give up threads, and are never kicked to */
+    rq->nr_domains = 0;
+    if (cpu_isolated(rq->cpu)) return;
+    for (uint32_t level = 0; level < SD_LEVELS; level++) {
+        const cpumask_t *mask = level == SD_SYSTEM ? &system : sched_level_mask(rq->cpu, level);
+        if (!mask) continue;
+        cpumask_and(&span, mask, housekeeping_mask());
+        if (cpumask_weight(&span) < 2) continue;
+        if (rq->nr_domains && cpumask_equal(&rq->domains[rq->nr_domains - 1], &span)) continue;
+        rq->domain_level[rq->nr_domains] = level;
+        rq->domains[rq->nr_domains++]    = span;
+    }
+}
+
+/* Finish a switch on the new stack, the previous thread may now run elsewhere */
+static void sched_finish_switch(void)
+{
+    thread_t *prev = this_cpu_read(prev_thread);
+    if (!prev) return;
+    this_cpu_write(prev_thread, 0);
+
+    compiler_barrier();
+    if (prev->state == THREAD_DEAD) {
+        fpu_state_free(prev->fpu_state);
+        free(prev->stack);
+        free(prev);
+        return;
+    }
+    prev->on_cpu = 0;
+}
+
+/* Allocate a thread whose first switch lands in thread_trampoline */
+static thread_t *thread_alloc(const char *name, void (*entry)(void *arg), void *arg)
+{
+    thread_t *thread = (thread_t *)aligned_alloc(64, sizeof(thread_t));
+    if (!thread) return 0;
+    memset(thread, 0, sizeof(thread_t));
+
+    thread->stack     = malloc(THREAD_STACK_SIZE);
+    thread->fpu_state = fpu_state_alloc();
+    if (!thread->stack || !thread->fpu_state) {
+        free(thread->stack);
+        fpu_state_free(thread->fpu_state);
+        free(thread);
+        return 0;
+    }
+    thread->tid     = __atomic_fetch_add(&next_tid, 1, __ATOMIC_RELAXED);
+    thread->name    = name;
+    thread->entry   = entry;
+    thread->arg     = arg;
+    thread->fpu_cpu = FPU_CPU_NONE;
+
+    /* Frame popped by switch_context: r15 r14 r13 r12 rbx rbp rflags, then the return address */
+    pointer_cast_t cast;
+    cast.ptr      = thread->stack;
+    uint64_t *top = (uint64_t *)ALIGN_DOWN(cast.val + THREAD_STACK_SIZE, 16);
+    cast.ptr      = (void *)thread_trampoline;
+    *--top        = cast.val;
+    *--top        = 0x2; // RFLAGS with interrupts off
+    for (int i = 0; i < 6; i++) *--top = 0;
+
+    cast.ptr    = top;
+    thread->rsp = cast.val;
+    return thread;
+}
+
+/* C half of the new thread entry, called from thread_trampoline */
+void thread_start(void)
+{
+    sched_finish_switch();
+    thread_t *self = this_cpu_read(current_thread);
+
+    enable_intr();
+    self->entry(self->arg);
+    thread_exit();
+}
+
+/* Idle loop, stops the tick and sleeps until an interrupt brings work */
+static void sched_idle(void *arg)
+{
+    (void)arg;
+    runqueue_t *rq = this_cpu_read(runqueue);
+    while (1) {
+        disable_intr();
+        if (rq->nr_ready) { // Woken locally from an interrupt handler
+            schedule();
+            continue;
+        }
+        if (!rcu_needs_cpu()) {
+            if (tick_sched_stop()) rq->tickless = 1;
+        } else if (rq->tickless) { // Callbacks were queued while the tick was stopped
+            rq->tickless = 0;
+            tick_sched_resume();
+        }
+        rcu_idle_enter();
+        idle_enter();
+    }
+}
+
+/* Get a run queue's CPU to pick up a thread just queued there */
+static void sched_kick(runqueue_t *rq)
+{
+    if (rq->cpu != get_current_cpu_id())
+        smp_send_reschedule(rq->cpu);
+    else if (rq->tickless && this_cpu_read(current_thread) != rq->idle)
+        smp_send_reschedule_self(); // No tick is left to end the running thread's slice
+}
+
+/* Send the nearest CPU with a stopped tick to fetch surplus work from a busy one */
+static void sched_kick_idle(runqueue_t *self)
+{
+    uint32_t cpu;
+    for (uint32_t d = 0; d < self->nr_domains; d++) {
+        for_each_cpu(cpu, &self->domains[d]) {
+            if (cpu >= runqueue_count) break;
+            if (&runqueues[cpu] != self && runqueues[cpu].tickless) {
+                smp_send_reschedule(cpu);
+                return;
+            }
+        }
+    }
+}
+
+/* Returns the thread running on the current CPU */
+thread_t *get_current_thread(void)
+{
+    return this_cpu_read(current_thread);
+}
+
+/* Returns the run queue of a CPU */
+runqueue_t *sched_runqueue(uint32_t cpu)
+{
+    return cpu < runqueue_count ? &runqueues[cpu] : 0;
+}
+
+/* Create a kernel thread with THREAD_* flags and queue it on the given CPU */
+thread_t *thread_create_on(const char *name, void (*entry)(void *arg), void *arg, uint32_t cpu, uint32_t flags)
+{
+    if (!sched_online || cpu >= runqueue_count) return 0;
+
+    thread_t *thread = thread_alloc(name, entry, arg);
+    if (!thread) return 0;
+    thread->flags = flags;
+
+    runqueue_t *rq     = &runqueues[cpu];
+    uint64_t    rflags = runqueue_lock(rq);
+    runqueue_push(rq, thread);
+    runqueue_unlock(rq, rflags);
+
+    /* Kick the target out of its idle wait or its tickless run so it does not wait for its next tick */
+    sched_kick(rq);
+    return thread;
+}
+
+/* Create a kernel thread and queue it on the least loaded CPU */
+thread_t *thread_create(const char *name, void (*entry)(void *arg), void *arg)
+{
+    if (!sched_online) return 0;
+
+    /* Narrow down from the least loaded package to its least loaded cache and core, spreading work out */
+    cpumask_t span, group, idlest;
+    cpumask_fill(&span, runqueue_count);
+    cpumask_and(&span, &span, housekeeping_mask()); // Isolated CPUs only run threads placed on them
+    for (int level = SD_PACKAGE; level >= SD_SMT; level--) {
+        uint32_t best_load = 0, best_weight = 0, cpu;
+        for_each_cpu(cpu, &span) {
+            if (cpu >= runqueue_count) break;
+            const cpumask_t *mask = sched_level_mask(cpu, level);
+            if (!mask) continue;
+            cpumask_and(&group, mask, &span);
+            if (cpumask_first(&group) != cpu) continue; // Each group once, by its first CPU
+
+            /* Compare the load per CPU, groups of one level may differ in size */
+            uint32_t load = sched_mask_load(&group), weight = cpumask_weight(&group);
+            if (!best_weight || (uint64_t)load * best_weight < (uint64_t)best_load * weight) {
+                idlest      = group;
+                best_load   = load;
+                best_weight = weight;
+            }
+        }
+        if (best_weight) span = idlest;
+    }
+
+    uint32_t best = get_current_cpu_id(), cpu;
+    if (!cpumask_test_cpu(&span, best)) best = cpumask_first(&span);
+    for_each_cpu(cpu, &span) {
+        if (cpu >= runqueue_count) break;
+        if (sched_cpu_load(cpu) < sched_cpu_load(best)) best = cpu;
+    }
+    return thread_create_on(name, entry, arg, best, 0);
+}
+
+/* Make a blocked thread runnable again, returns 1 if it was not blocked */
+int thread_wakeup(thread_t *thread)
+{
+    /* A blocked thread is on no run queue, so nothing can move it to another CPU */
+    runqueue_t *rq    = &runqueues[thread->cpu];
+    uint64_t    flags = runqueue_lock(rq);
+    if (thread->state != THREAD_BLOCKED) {
+        runqueue_unlock(rq, flags);
+        return 1;
+    }
+
+    /* Not switched out yet, it keeps running and schedule() will not put it to sleep */
+    if (!thread->asleep) {
+        thread->state = THREAD_RUNNING;
+        runqueue_unlock(rq, flags);
+        return 0;
+    }
+    thread->asleep = 0;
+    if (thread->policy == SCHED_DEADLINE) dl_wakeup(thread, nano_time());
+    runqueue_push(rq, thread);
+    runqueue_unlock(rq, flags);
+
+    if (thread->policy == SCHED_DEADLINE)
+        dl_check_preempt(rq, thread);
+    else
+        sched_kick(rq);
+    return 0;
+}
+
+/* Pick the next thread and switch to it */
+void schedule(void)
+{
+    if (!sched_online) return;
+
+    uint64_t flags = get_rflags();
+    disable_intr();
+
+    runqueue_t *rq = this_cpu_read(runqueue);
+    if (!rq) {
+        if (flags & RFLAGS_IF) enable_intr();
+        return;
+    }
+    thread_t *prev = this_cpu_read(current_thread);
+
+    /* Inside preempt_disable() the thread keeps the CPU, a blocking one is a caller bug */
+    if (this_cpu_read(preempt_count) && prev->state == THREAD_RUNNING) {
+        if (flags & RFLAGS_IF) enable_intr();
+        return;
+    }
+    if (!this_cpu_read(preempt_count)) rcu_qs();
+
+    uint64_t now = 0;
+    if (prev->policy == SCHED_DEADLINE) {
+        hrtimer_try_cancel(&rq->dl_enforce);
+        now = nano_time();
+        dl_account(prev, now);
+    }
+
+    spin_lock(&rq->lock);
+    if (prev->state == THREAD_RUNNING && prev != rq->idle) runqueue_push(rq, prev);
+    if (prev->state == THREAD_BLOCKED) prev->asleep = 1; // From here on a wakeup has to queue it
+    thread_t *next = runqueue_pop(rq);
+    spin_unlock(&rq->lock);
+
+    if (!next) next = sched_steal(rq);
+    if (!next) next = rq->idle;
+
+    next->state = THREAD_RUNNING;
+    next->slice = SCHED_TIMESLICE;
+    if (next->policy == SCHED_DEADLINE) {
+        next->dl_exec_start = now ? now : nano_time();
+        hrtimer_start(&rq->dl_enforce, next->dl_exec_start + next->dl_budget);
+    }
+    if (next != rq->idle && rq->tickless) {
+        rq->tickless = 0;
+        tick_sched_resume();
+    }
+    if (next != prev) {
+        if (prev == rq->idle) idle_exit(); // Interrupted in MWAIT, this CPU needs IPIs again
+        next->on_cpu = 1;
+        rq->switches++;
+        this_cpu_write(prev_thread, prev);
+        this_cpu_write(current_thread, next);
+        fpu_switch(prev, next);
+        switch_context(&prev->rsp, next->rsp);
+        sched_finish_switch();
+    }
+    if (flags & RFLAGS_IF) enable_intr();
+}
+
+/* Check whether the current context may block */
+int thread_can_sleep(void)
+{
+    if (!sched_online || !(get_rflags() & RFLAGS_IF) || this_cpu_read(preempt_count)) return 0; // Spinlock held or softirq
+    runqueue_t *rq = this_cpu_read(runqueue);
+    return rq && this_cpu_read(current_thread) != rq->idle;
+}
+
+/* Move the current thread into the deadline class on its CPU, or back with a zero runtime, returns 1 if rejected */
+int sched_set_deadline(const sched_attr_t *attr)
+{
+    uint64_t runtime  = attr ? attr->runtime : 0;
+    uint64_t deadline = runtime ? (attr->deadline ? attr->deadline : attr->period) : 0;
+    uint64_t period   = runtime ? (attr->period ? attr->period : deadline) : 0;
+    uint64_t now      = nano_time();
+    if (!sched_online || !now) return 1; // Budgets are charged against the HPET clock
+    if (runtime && (runtime < SCHED_DL_MIN_NS || runtime > deadline || deadline > period || period > SCHED_DL_MAX_NS)) return 1;
+    uint64_t bw = runtime ? (runtime << SCHED_DL_BW_SHIFT) / period : 0;
+
+    /* Interrupts off keep the running thread on this CPU, each CPU admits its own threads */
+    uint64_t    flags = get_rflags();
+    thread_t   *self  = this_cpu_read(current_thread);
+    runqueue_t *rq;
+    disable_intr();
+    rq = this_cpu_read(runqueue);
+    if (!rq || self == rq->idle) {
+        if (flags & RFLAGS_IF) enable_intr();
+        return 1;
+    }
+
+    spin_lock(&rq->lock);
+    if (rq->dl_bw - self->dl_bw + bw > SCHED_DL_BW_MAX) {
+        spin_unlock(&rq->lock);
+        if (flags & RFLAGS_IF) enable_intr();
+        return 1;
+    }
+    rq->dl_bw   = rq->dl_bw - self->dl_bw + bw;
+    self->dl_bw = bw;
+    spin_unlock(&rq->lock);
+
+    hrtimer_try_cancel(&rq->dl_enforce);
+    if (runtime) {
+        if (self->policy != SCHED_DEADLINE) {
+            hrtimer_setup(&self->dl_timer, dl_timer_func);
+            self->dl_pinned = self->flags & THREAD_PINNED;
+        }
+        self->policy        = SCHED_DEADLINE;
+        self->dl.runtime    = runtime;
+        self->dl.deadline   = deadline;
+        self->dl.period     = period;
+        self->dl_abs        = now + deadline;
+        self->dl_budget     = runtime;
+        self->dl_exec_start = now;
+        self->dl_yielded    = 0;
+        hrtimer_start(&rq->dl_enforce, now + runtime);
+        self->flags |= THREAD_PINNED; // The reservation belongs to this CPU
+    } else if (self->policy == SCHED_DEADLINE) {
+        self->flags  = (self->flags & ~THREAD_PINNED) | self->dl_pinned; // Free to migrate again unless it was pinned before
+        self->policy = SCHED_NORMAL;
+    }
+    if (flags & RFLAGS_IF) enable_intr();
+    return 0;
+}
+
+/* Give up the rest of the time slice, or of the period for a deadline thread */
+void thread_yield(void)
+{
+    thread_t *self = this_cpu_read(current_thread);
+    if (self && self->policy == SCHED_DEADLINE) self->dl_yielded = 1; // The job is done, wait for the next period
+    schedule();
+}
+
+/* Terminate the current thread */
+void thread_exit(void)
+{
+    if (this_cpu_read(current_thread)->policy == SCHED_DEADLINE) sched_set_deadline(0); // Free the reservation
+    disable_intr();
+    this_cpu_read(current_thread)->state = THREAD_DEAD;
+    schedule();
+    panic("sched: Dead thread was scheduled again.");
+    while (1) __asm__ volatile("hlt");
+}
+
+/* Timer tick on the current CPU, called from the timer interrupt */
+void sched_tick(void)
+{
+    if (!sched_online || !this_cpu_read(runqueue)) return;
+
+    runqueue_t *rq      = this_cpu_read(runqueue);
+    thread_t   *current = this_cpu_read(current_thread);
+    current->runtime++;
+    if (current->slice) current->slice--;
+    if (rq->nr_ready) sched_kick_idle(rq);
+    rcu_tick();
+
+    /* An isolated CPU left with one thread needs no tick until a wakeup or an RCU grace period kicks it */
+    if (cpu_isolated(rq->cpu) && current != rq->idle && !rq->nr_ready && !rcu_needs_cpu()) {
+        if (tick_sched_stop()) rq->tickless = 1;
+        return;
+    }
+
+    /* Idle threads that still take ticks poll for local or stealable work */
+    if (!current->slice || current == rq->idle) schedule();
+}
+
+/* Attach an application processor to the scheduler and run its idle loop */
+void sched_ap_entry(void)
+{
+    while (!sched_online) __asm__ volatile("pause");
+
+    /* The AP boot context becomes this CPU's idle thread */
+    thread_t *idle = (thread_t *)aligned_alloc(64, sizeof(thread_t));
+    memset(idle, 0, sizeof(thread_t));
+    idle->tid    = __atomic_fetch_add(&next_tid, 1, __ATOMIC_RELAXED);
+    idle->name   = "idle";
+    idle->state  = THREAD_RUNNING;
+    idle->on_cpu = 1;
+
+    /* Its registers were never saved, the first switch away fills the area */
+    idle->fpu_state = fpu_state_alloc();
+    idle->fpu_cpu   = FPU_CPU_NONE;
+    if (!idle->fpu_state) panic("sched: Cannot allocate the idle thread FPU state.");
+
+    runqueue_t *rq = &runqueues[get_current_cpu_id()];
+    rq->idle       = idle;
+    this_cpu_write(current_thread, idle);
+    this_cpu_write(runqueue, rq);
+
+    sched_idle(0);
+    while (1) __asm__ volatile("hlt");
+}
+
+/* Initialize the scheduler, the caller becomes the first thread */
+void sched_init(void)
+{
+    runqueue_count = get_cpu_count() ? get_cpu_count() : 1;
+    runqueues      = (runqueue_t *)aligned_alloc(64, sizeof(runqueue_t) * runqueue_count);
+    memset(runqueues, 0, sizeof(runqueue_t) * runqueue_count);
+    for (uint32_t i = 0; i < runqueue_count; i++) {
+        spin_lock_init(&runqueues[i].lock, &runqueue_lock_class);
+        ilist_init(&runqueues[i].ready);
+        rb_root_init(&runqueues[i].dl_root);
+        hrtimer_setup(&runqueues[i].dl_enforce, dl_enforce_func);
+        runqueues[i].cpu = i;
+        sched_build_domains(&runqueues[i]);
+    }
+
+    boot_thread.tid    = 0;
+    boot_thread.name   = "kernel";
+    boot_thread.state  = THREAD_RUNNING;
+    boot_thread.on_cpu = 1;
+    boot_thread.slice  = SCHED_TIMESLICE;
+
+    boot_thread.fpu_state = fpu_state_alloc();
+    boot_thread.fpu_cpu   = FPU_CPU_NONE;
+    if (!boot_thread.fpu_state) panic("sched: Cannot allocate the boot thread FPU state.");
+
+    /* The boot CPU needs a real idle thread, its boot context keeps running kernel_entry() */
+    runqueue_t *rq = &runqueues[get_current_cpu_id()];
+    rq->idle       = thread_alloc("idle", sched_idle, 0);
+    if (!rq->idle) panic("sched: Cannot allocate the idle thread.");
+    boot_thread.cpu = rq->cpu;
+    this_cpu_write(current_thread, &boot_thread);
+    this_cpu_write(runqueue, rq);
+
+    compiler_barrier();
+    sched_online = 1;
+    plogk("sched: %u run queues online, time slice %u ticks.\n", runqueue_count, SCHED_TIMESLICE);
+    for (uint32_t d = 0; d < rq->nr_domains; d++)
+        plogk("sched: CPU %u domain %u: %-7s %u CPUs.\n", rq->cpu, d, sched_domain_names[rq->domain_level[d]],
+              cpumask_weight(&rq->domains[d]));
+}
@@ -0,0 +1,80 @@
+/*
+ *
+ *      switch.s
+ *      Kernel thread and coroutine context switch
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+    .text
+
+/* void switch_context(uint64_t *prev_rsp, uint64_t next_rsp), fpu_switch() has already moved the extended state */
+    .globl switch_context
+    .type switch_context, @function
+switch_context:
+    pushfq
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    popfq
+    ret
+    .size switch_context, . - switch_context
+
+/* First return target of a new thread, the stack is 16-byte aligned here */
+    .globl thread_trampoline
+    .type thread_trampoline, @function
+thread_trampoline:
+    xorq %rbp, %rbp
+    call thread_start
+    ud2
+    .size thread_trampoline, . - thread_trampoline
+
+/* void co_switch(uint64_t *prev_rsp, uint64_t next_rsp), both sides run on one thread so RFLAGS and FPU state stay */
+    .globl co_switch
+    .type co_switch, @function
+co_switch:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size co_switch, . - co_switch
+
+/* First return target of a new coroutine, the stack is 16-byte aligned here */
+    .globl co_trampoline
+    .type co_trampoline, @function
+co_trampoline:
+    xorq %rbp, %rbp
+    call co_start
+    ud2
+    .size co_trampoline, . - co_trampoline
+
+    .section .note.GNU-stack, "", @progbits
@@ -0,0 +1,268 @@
+/*
+ *
+ *      wait.c
+ *      Wait queues and completions
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "wait.h"
+#include "acpi.h"
+#include "common.h"
+#include "double_list.h"
+#include "hrtimer.h"
+#include "sched.h"
+#include "spin_lock.h"
+#include "stdint.h"
+#include "string.h"
+
+typedef struct sleep_timer {
+        hrtimer_t timer;
+        thread_t *thread;
+} sleep_timer_t;
+
+/* Lock a wait queue with interrupts off, returns the previous RFLAGS */
+static inline uint64_t wait_lock(wait_queue_head_t *wq)
+{
+    return spin_lock_irqsave(&wq->lock);
+}
+
+/* Unlock a wait queue and restore the interrupt flag */
+static inline void wait_unlock(wait_queue_head_t *wq, uint64_t flags)
+{
+    spin_unlock_irqrestore(&wq->lock, flags);
+}
+
+/* Wake waiters from the head, stopping after `nr_exclusive` exclusive ones (0 for all), the queue lock is held */
+static int wake_up_common_locked(wait_queue_head_t *wq, int nr_exclusive)
+{
+    int woken = 0;
+
+    ilist_node_t *node = wq->waiters.next;
+    while (node != &wq->waiters) {
+        ilist_node_t       *next      = node->next;
+        wait_queue_entry_t *entry     = ilist_entry(node, wait_queue_entry_t, node);
+        thread_t           *thread    = entry->thread;
+        uint32_t            exclusive = entry->flags & WAIT_EXCLUSIVE;
+
+        /* The entry lives on the waiter's stack, only a callback entry is touched once unlinked */
+        ilist_remove(node);
+        if (entry->func)
+            entry->func(entry); // Its owner takes the lock in remove_wait_queue() before letting it go
+        else
+            thread_wakeup(thread);
+        woken++;
+        if (exclusive && !--nr_exclusive) break;
+        node = next;
+    }
+    return woken;
+}
+
+/* Wake waiters from the head, stopping after `nr_exclusive` exclusive ones (0 for all) */
+static int wake_up_common(wait_queue_head_t *wq, int nr_exclusive)
+{
+    uint64_t flags = wait_lock(wq);
+    int      woken = wake_up_common_locked(wq, nr_exclusive);
+    wait_unlock(wq, flags);
+    return woken;
+}
+
+/* Wake the thread that armed a sleep timer */
+static hrtimer_restart_t sleep_timer_fn(hrtimer_t *timer)
+{
+    sleep_timer_t *sleeper = (sleep_timer_t *)timer;
+    thread_wakeup(sleeper->thread);
+    return HRTIMER_NORESTART;
+}
+
+/* Take one complete() call, returns 0 if there is none */
+static int completion_consume(completion_t *completion)
+{
+    uint64_t flags = wait_lock(&completion->wait);
+    int      done  = completion->done != 0;
+    if (done && completion->done != COMPLETION_ALL) completion->done--;
+    wait_unlock(&completion->wait, flags);
+    return done;
+}
+
+/* Wait for a completion, a timeout of 0 waits forever, returns 0 on timeout */
+static int completion_wait(completion_t *completion, uint64_t timeout_ns)
+{
+    if (!thread_can_sleep()) {
+        uint64_t deadline = nano_time() + timeout_ns;
+        while (!completion_consume(completion)) {
+            if (timeout_ns && nano_time() >= deadline) return 0;
+            __asm__ volatile("pause");
+        }
+        return 1;
+    }
+
+    wait_queue_entry_t entry;
+    uint64_t           left = timeout_ns;
+    int                done = 0;
+
+    wait_entry_init(&entry, WAIT_EXCLUSIVE);
+    while (1) {
+        prepare_to_wait(&completion->wait, &entry);
+        if (completion_consume(completion)) {
+            done = 1;
+            break;
+        }
+        if (timeout_ns && !left) break;
+        if (timeout_ns)
+            left = schedule_timeout(left);
+        else
+            schedule();
+    }
+    finish_wait(&completion->wait, &entry);
+    return done;
+}
+
+/* Initialize a wait queue */
+void wait_queue_init(wait_queue_head_t *wq)
+{
+    memset(wq, 0, sizeof(wait_queue_head_t));
+    ilist_init(&wq->waiters);
+}
+
+/* Initialize a wait entry for the current thread */
+void wait_entry_init(wait_queue_entry_t *entry, uint32_t flags)
+{
+    entry->node.prev = 0;
+    entry->node.next = 0;
+    entry->thread    = get_current_thread();
+    entry->flags     = flags;
+    entry->func      = 0;
+}
+
+/* Initialize a wait entry whose wakeup calls `func` instead of waking a thread */
+void wait_entry_init_func(wait_queue_entry_t *entry, void (*func)(wait_queue_entry_t *entry), uint32_t flags)
+{
+    entry->node.prev = 0;
+    entry->node.next = 0;
+    entry->thread    = 0;
+    entry->flags     = flags;
+    entry->func      = func;
+}
+
+/* Queue an entry that is not queued yet without touching any thread state */
+void add_wait_queue(wait_queue_head_t *wq, wait_queue_entry_t *entry)
+{
+    uint64_t flags = wait_lock(wq);
+    if (!entry->node.next) {
+        if (entry->flags & WAIT_EXCLUSIVE)
+            ilist_insert_before(&wq->waiters, &entry->node);
+        else
+            ilist_insert_after(&wq->waiters, &entry->node);
+    }
+    wait_unlock(wq, flags);
+}
+
+/* Dequeue an entry, once it returns no wakeup is still using the entry */
+void remove_wait_queue(wait_queue_head_t *wq, wait_queue_entry_t *entry)
+{
+    /* Always locked, a wakeup that already unlinked the entry may still be inside its callback */
+    uint64_t flags = wait_lock(wq);
+    if (entry->node.next) ilist_remove(&entry->node);
+    wait_unlock(wq, flags);
+}
+
+/* Queue the entry if needed and mark the current thread blocked, check the condition afterwards */
+void prepare_to_wait(wait_queue_head_t *wq, wait_queue_entry_t *entry)
+{
+    uint64_t flags = wait_lock(wq);
+    if (!entry->node.next) {
+        if (entry->flags & WAIT_EXCLUSIVE)
+            ilist_insert_before(&wq->waiters, &entry->node);
+        else
+            ilist_insert_after(&wq->waiters, &entry->node);
+    }
+    entry->thread->state = THREAD_BLOCKED;
+    wait_unlock(wq, flags);
+}
+
+/* Mark the current thread running again and dequeue the entry */
+void finish_wait(wait_queue_head_t *wq, wait_queue_entry_t *entry)
+{
+    entry->thread->state = THREAD_RUNNING;
+    if (!__atomic_load_n(&entry->node.next, __ATOMIC_ACQUIRE)) return; // Already unlinked by a wakeup
+
+    uint64_t flags = wait_lock(wq);
+    if (entry->node.next) ilist_remove(&entry->node);
+    wait_unlock(wq, flags);
+}
+
+/* Wake every non-exclusive waiter and one exclusive waiter, returns the number woken */
+int wake_up(wait_queue_head_t *wq)
+{
+    return wake_up_common(wq, 1);
+}
+
+/* Wake every waiter, returns the number woken */
+int wake_up_all(wait_queue_head_t *wq)
+{
+    return wake_up_common(wq, 0);
+}
+
+/* Block for up to `ns` nanoseconds or until woken, returns the time left */
+uint64_t schedule_timeout(uint64_t ns)
+{
+    sleep_timer_t sleeper;
+    uint64_t      deadline = nano_time() + ns;
+
+    /* The caller marked itself blocked, the timer is the fallback wakeup */
+    hrtimer_setup(&sleeper.timer, sleep_timer_fn);
+    sleeper.thread = get_current_thread();
+    hrtimer_start(&sleeper.timer, deadline);
+    schedule();
+    hrtimer_cancel(&sleeper.timer);
+
+    uint64_t now = nano_time();
+    return now < deadline ? deadline - now : 0;
+}
+
+/* Initialize a completion */
+void init_completion(completion_t *completion)
+{
+    wait_queue_init(&completion->wait);
+    completion->done = 0;
+}
+
+/* Forget earlier complete() calls before reusing a completion */
+void reinit_completion(completion_t *completion)
+{
+    __atomic_store_n(&completion->done, 0, __ATOMIC_RELEASE);
+}
+
+/* Signal one waiter, safe from interrupt handlers */
+void complete(completion_t *completion)
+{
+    uint64_t flags = wait_lock(&completion->wait);
+    if (completion->done != COMPLETION_ALL) completion->done++;
+    wake_up_common_locked(&completion->wait, 1); // A waiter may free the completion once it sees `done`, touch nothing after the unlock
+    wait_unlock(&completion->wait, flags);
+}
+
+/* Signal every current and future waiter */
+void complete_all(completion_t *completion)
+{
+    uint64_t flags = wait_lock(&completion->wait);
+    completion->done = COMPLETION_ALL;
+    wake_up_common_locked(&completion->wait, 0);
+    wait_unlock(&completion->wait, flags);
+}
+
+/* Block until the completion is signalled */
+void wait_for_completion(completion_t *completion)
+{
+    completion_wait(completion, 0);
+}
+
+/* Block until the completion is signalled or the timeout expires, returns 0 on timeout */
+int wait_for_completion_timeout(completion_t *completion, uint64_t timeout_ms)
+{
+    return completion_wait(completion, timeout_ms ? timeout_ms * 1000000 : 1);
+}
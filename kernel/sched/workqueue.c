@@ -0,0 +1,360 @@
+/*
+ *
+ *      workqueue.c
+ *      Kernel workqueue
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "workqueue.h"
+#include "acpi.h"
+#include "alloc.h"
+#include "common.h"
+#include "debug.h"
+#include "double_list.h"
+#include "isolation.h"
+#include "printk.h"
+#include "sched.h"
+#include "smp.h"
+#include "spin_lock.h"
+#include "stddef.h"
+#include "stdint.h"
+#include "string.h"
+#include "timer.h"
+
+#define RFLAGS_IF (1 << 9)
+
+typedef struct worker {
+        ilist_node_t        idle_node;
+        thread_t           *thread;
+        struct worker_pool *pool;
+        work_t *volatile    current_work; // Item being executed, 0 when idle
+        volatile uint64_t   current_seq;  // Its queue sequence, 0 when idle
+} worker_t;
+
+typedef struct worker_pool {
+        spinlock_t        lock;
+        ilist_node_t      worklist;    // Pending items in FIFO order
+        ilist_node_t      idle;        // Workers blocked waiting for items
+        uint32_t          cpu;         // Bound CPU or WORK_CPU_UNBOUND
+        uint32_t          nr_workers;
+        worker_t         *workers;
+        volatile uint64_t seq_queued; // Sequence of the last queued item, the worklist stays sorted by it
+        volatile uint64_t processed;  // Items executed by the pool
+} __attribute__((aligned(64))) worker_pool_t;
+
+static worker_pool_t *bound_pools;
+static worker_pool_t  unbound_pool;
+static uint32_t       pool_count;
+static volatile int   workqueue_online = 0;
+
+static DEFINE_SPIN_LOCK_CLASS(pool_lock_class, "worker_pool");
+
+static workqueue_t system_wq_struct         = {"events", 0};
+static workqueue_t system_unbound_wq_struct = {"events_unbound", WQ_UNBOUND};
+workqueue_t       *system_wq                = &system_wq_struct;
+workqueue_t       *system_unbound_wq        = &system_unbound_wq_struct;
+
+/* Lock a pool with interrupts off, returns the previous RFLAGS */
+static inline uint64_t wq_lock(spinlock_t *lock)
+{
+    return spin_lock_irqsave(lock);
+}
+
+/* Unlock a pool and restore the interrupt flag */
+static inline void wq_unlock(spinlock_t *lock, uint64_t flags)
+{
+    spin_unlock_irqrestore(lock, flags);
+}
+
+/* Returns the pool that serves a workqueue on a CPU */
+static worker_pool_t *select_pool(workqueue_t *wq, uint32_t cpu)
+{
+    if (wq->flags & WQ_UNBOUND) return &unbound_pool;
+    if (cpu >= pool_count) cpu = housekeeping_cpu(); // An isolated CPU only runs work queued on it by name
+    return &bound_pools[cpu];
+}
+
+/* Append an item that already has WORK_PENDING set and wake an idle worker */
+static void queue_pending_work(uint32_t cpu, workqueue_t *wq, work_t *work)
+{
+    worker_pool_t *pool  = select_pool(wq, cpu);
+    uint64_t       flags = wq_lock(&pool->lock);
+
+    work->pool      = pool;
+    work->seq       = ++pool->seq_queued;
+    work->queued_at = nano_time();
+    ilist_insert_before(&pool->worklist, &work->node);
+
+    if (!ilist_is_empty(&pool->idle)) {
+        ilist_node_t *node = pool->idle.next;
+        ilist_remove(node);
+        thread_wakeup(ilist_entry(node, worker_t, idle_node)->thread);
+    }
+    wq_unlock(&pool->lock, flags);
+}
+
+/* Worker thread main loop */
+static void worker_thread(void *arg)
+{
+    worker_t      *worker = (worker_t *)arg;
+    worker_pool_t *pool   = worker->pool;
+    thread_t      *self   = get_current_thread();
+
+    while (1) {
+        uint64_t flags = wq_lock(&pool->lock);
+        if (ilist_is_empty(&pool->worklist)) {
+            /* Block under the pool lock so an enqueue cannot slip in before we sleep */
+            self->state = THREAD_BLOCKED;
+            ilist_insert_before(&pool->idle, &worker->idle_node);
+            spin_unlock(&pool->lock);
+            schedule();
+            if (flags & RFLAGS_IF) enable_intr();
+            continue;
+        }
+
+        ilist_node_t *node = pool->worklist.next;
+        ilist_remove(node);
+        work_t *work         = ilist_entry(node, work_t, node);
+        worker->current_work = work;
+        worker->current_seq  = work->seq;
+
+        /* The item may queue itself again from here on */
+        __atomic_fetch_and(&work->flags, ~WORK_PENDING, __ATOMIC_RELEASE);
+        wq_unlock(&pool->lock, flags);
+
+        /* The function may free the item, it is not touched after the call */
+        work->func(work);
+
+        __atomic_add_fetch(&pool->processed, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&worker->current_seq, 0, __ATOMIC_RELEASE);
+        __atomic_store_n(&worker->current_work, 0, __ATOMIC_RELEASE);
+    }
+}
+
+/* Check whether an item is pending or running */
+static int work_busy(work_t *work)
+{
+    if (__atomic_load_n(&work->flags, __ATOMIC_ACQUIRE) & WORK_PENDING) return 1;
+
+    worker_pool_t *pool = work->pool;
+    if (!pool) return 0;
+    for (uint32_t i = 0; i < pool->nr_workers; i++)
+        if (__atomic_load_n(&pool->workers[i].current_work, __ATOMIC_ACQUIRE) == work) return 1;
+    return 0;
+}
+
+/* Check whether an item at or below `target` still waits on the worklist, cancelled items are gone from it */
+static int pool_pending_upto(worker_pool_t *pool, uint64_t target)
+{
+    uint64_t flags   = wq_lock(&pool->lock);
+    int      pending = !ilist_is_empty(&pool->worklist) && ilist_entry(pool->worklist.next, work_t, node)->seq <= target;
+    wq_unlock(&pool->lock, flags);
+    return pending;
+}
+
+/* Wait until every item queued on a pool before the call has finished or been cancelled */
+static void flush_pool(worker_pool_t *pool)
+{
+    uint64_t  target = __atomic_load_n(&pool->seq_queued, __ATOMIC_ACQUIRE);
+    thread_t *self   = get_current_thread();
+
+    while (1) {
+        int busy = pool_pending_upto(pool, target);
+        for (uint32_t i = 0; i < pool->nr_workers && !busy; i++) {
+            worker_t *worker = &pool->workers[i];
+            uint64_t  seq    = __atomic_load_n(&worker->current_seq, __ATOMIC_ACQUIRE);
+            if (worker->thread != self && seq && seq <= target) busy = 1;
+        }
+        if (!busy) return;
+        thread_yield();
+    }
+}
+
+/* Start the workers of a pool */
+static int pool_setup(worker_pool_t *pool, uint32_t cpu, uint32_t nr_workers)
+{
+    spin_lock_init(&pool->lock, &pool_lock_class);
+    ilist_init(&pool->worklist);
+    ilist_init(&pool->idle);
+    pool->cpu        = cpu;
+    pool->nr_workers = nr_workers;
+    pool->workers    = (worker_t *)malloc(sizeof(worker_t) * nr_workers);
+    if (!pool->workers) return 1;
+    memset(pool->workers, 0, sizeof(worker_t) * nr_workers);
+
+    for (uint32_t i = 0; i < nr_workers; i++) {
+        worker_t *worker = &pool->workers[i];
+        worker->pool     = pool;
+        if (cpu == WORK_CPU_UNBOUND)
+            worker->thread = thread_create("kworker/u", worker_thread, worker);
+        else
+            worker->thread = thread_create_on("kworker", worker_thread, worker, cpu, THREAD_PINNED);
+        if (!worker->thread) return 1;
+    }
+    return 0;
+}
+
+/* Timer callback of a delayed work item */
+static void delayed_work_timer_fn(timer_list_t *timer)
+{
+    delayed_work_t *dwork = ilist_entry(timer, delayed_work_t, timer);
+    queue_pending_work(dwork->cpu, dwork->wq, &dwork->work);
+}
+
+/* Initialize a work item */
+void init_work(work_t *work, work_func_t func)
+{
+    memset(work, 0, sizeof(work_t));
+    work->func = func;
+}
+
+/* Initialize a delayed work item */
+void init_delayed_work(delayed_work_t *dwork, work_func_t func)
+{
+    memset(dwork, 0, sizeof(delayed_work_t));
+    dwork->work.func = func;
+    timer_setup(&dwork->timer, delayed_work_timer_fn);
+}
+
+/* Returns the delayed work item that contains a work item */
+delayed_work_t *to_delayed_work(work_t *work)
+{
+    return ilist_entry(work, delayed_work_t, work);
+}
+
+/* Create a workqueue */
+workqueue_t *workqueue_create(const char *name, uint32_t flags)
+{
+    workqueue_t *wq = (workqueue_t *)malloc(sizeof(workqueue_t));
+    if (!wq) return 0;
+    wq->name  = name;
+    wq->flags = flags;
+    return wq;
+}
+
+/* Queue a work item on a CPU, returns 1 if it was already pending */
+int queue_work_on(uint32_t cpu, workqueue_t *wq, work_t *work)
+{
+    if (__atomic_fetch_or(&work->flags, WORK_PENDING, __ATOMIC_ACQ_REL) & WORK_PENDING) return 1;
+
+    /* Items queued before the pools exist run synchronously */
+    if (!workqueue_online) {
+        __atomic_fetch_and(&work->flags, ~WORK_PENDING, __ATOMIC_RELEASE);
+        work->func(work);
+        return 0;
+    }
+    queue_pending_work(cpu, wq, work);
+    return 0;
+}
+
+/* Queue a work item on the current CPU, returns 1 if it was already pending */
+int queue_work(workqueue_t *wq, work_t *work)
+{
+    return queue_work_on(WORK_CPU_UNBOUND, wq, work);
+}
+
+/* Queue a work item after a delay in milliseconds, returns 1 if it was already pending */
+int queue_delayed_work_on(uint32_t cpu, workqueue_t *wq, delayed_work_t *dwork, uint64_t delay_ms)
+{
+    if (!delay_ms || !workqueue_online) return queue_work_on(cpu, wq, &dwork->work);
+    if (__atomic_fetch_or(&dwork->work.flags, WORK_PENDING, __ATOMIC_ACQ_REL) & WORK_PENDING) return 1;
+
+    dwork->wq  = wq;
+    dwork->cpu = cpu;
+    add_timer(&dwork->timer, jiffies_now() + msecs_to_jiffies(delay_ms)); // Fires on the CPU that armed it, or a housekeeping one
+    return 0;
+}
+
+/* Queue a work item on the current CPU after a delay in milliseconds */
+int queue_delayed_work(workqueue_t *wq, delayed_work_t *dwork, uint64_t delay_ms)
+{
+    return queue_delayed_work_on(WORK_CPU_UNBOUND, wq, dwork, delay_ms);
+}
+
+/* Queue a work item on the system workqueue */
+int schedule_work(work_t *work)
+{
+    return queue_work(system_wq, work);
+}
+
+/* Remove a pending work item, returns 1 if it was removed before running */
+int cancel_work(work_t *work)
+{
+    worker_pool_t *pool = work->pool;
+    if (!pool || !(__atomic_load_n(&work->flags, __ATOMIC_ACQUIRE) & WORK_PENDING)) return 0;
+
+    int      removed = 0;
+    uint64_t flags   = wq_lock(&pool->lock);
+    if ((work->flags & WORK_PENDING) && work->pool == pool && work->node.next) {
+        ilist_remove(&work->node);
+        __atomic_fetch_and(&work->flags, ~WORK_PENDING, __ATOMIC_RELEASE);
+        removed = 1;
+    }
+    wq_unlock(&pool->lock, flags);
+    return removed;
+}
+
+/* Remove a pending work item and wait for a running instance to finish */
+int cancel_work_sync(work_t *work)
+{
+    int removed = cancel_work(work);
+    flush_work(work);
+    return removed;
+}
+
+/* Disarm or dequeue a delayed work item, returns 1 if it was removed before running */
+int cancel_delayed_work(delayed_work_t *dwork)
+{
+    if (del_timer(&dwork->timer)) {
+        __atomic_fetch_and(&dwork->work.flags, ~WORK_PENDING, __ATOMIC_RELEASE);
+        return 1;
+    }
+    return cancel_work(&dwork->work);
+}
+
+/* Disarm a delayed work item and wait for a running instance to finish */
+int cancel_delayed_work_sync(delayed_work_t *dwork)
+{
+    int removed = cancel_delayed_work(dwork);
+    del_timer_sync(&dwork->timer);
+    flush_work(&dwork->work);
+    return removed;
+}
+
+/* Wait until a work item is neither pending nor running */
+void flush_work(work_t *work)
+{
+    while (work_busy(work)) thread_yield();
+}
+
+/* Wait until every item queued on a workqueue before the call has finished */
+void flush_workqueue(workqueue_t *wq)
+{
+    if (!workqueue_online) return;
+    if (wq->flags & WQ_UNBOUND) {
+        flush_pool(&unbound_pool);
+        return;
+    }
+    for (uint32_t i = 0; i < pool_count; i++) flush_pool(&bound_pools[i]);
+}
+
+/* Start the worker pools, needs the scheduler */
+void workqueue_init(void)
+{
+    pool_count  = get_cpu_count() ? get_cpu_count() : 1;
+    bound_pools = (worker_pool_t *)aligned_alloc(64, sizeof(worker_pool_t) * pool_count);
+    if (!bound_pools) panic("workqueue: Cannot allocate the worker pools.");
+    memset(bound_pools, 0, sizeof(worker_pool_t) * pool_count);
+
+    for (uint32_t i = 0; i < pool_count; i++)
+        if (pool_setup(&bound_pools[i], i, 1)) panic("workqueue: Cannot start the workers of CPU %u.", i);
+    if (pool_setup(&unbound_pool, WORK_CPU_UNBOUND, pool_count)) panic("workqueue: Cannot start the unbound workers.");
+
+    compiler_barrier();
+    workqueue_online = 1;
+    plogk("workqueue: %u bound pools, %u unbound workers online.\n", pool_count, unbound_pool.nr_workers);
+}
@@ -9,8 +9,15 @@
  *
  */
 
+#include "time.h"
+#include "acpi.h"
 #include "cmos.h"
 #include "common.h"
+#include "seqlock.h"
+
+static seqlock_t wall_clock_lock = SEQLOCK_INIT(0);
+static uint64_t  wall_clock_sec;  // Unix time read from the CMOS, 0 before time_init()
+static uint64_t  wall_clock_base; // nano_time() when it was read
 
 uint32_t is_leap_year(uint32_t year)
 {
@@ -82,7 +89,29 @@ uint64_t calculate_unix_timestamp(void)
     return total_seconds;
 }
 
+/* Read the CMOS clock once and keep time from the HPET afterwards */
+void time_init(void)
+{
+    uint64_t seconds = calculate_unix_timestamp();
+    uint64_t now     = nano_time();
+    uint64_t flags   = write_seqlock_irqsave(&wall_clock_lock);
+    wall_clock_sec   = seconds;
+    wall_clock_base  = now;
+    write_sequnlock_irqrestore(&wall_clock_lock, flags);
+}
+
+/* Returns the Unix time without touching the CMOS */
 uint64_t get_current_time(void)
 {
-    return calculate_unix_timestamp();
+    uint64_t seconds, base;
+    uint32_t seq;
+
+    do {
+        seq     = read_seqbegin(&wall_clock_lock);
+        seconds = wall_clock_sec;
+        base    = wall_clock_base;
+    } while (read_seqretry(&wall_clock_lock, seq));
+
+    if (!seconds) return calculate_unix_timestamp();
+    return seconds + (nano_time() - base) / 1000000000;
 }
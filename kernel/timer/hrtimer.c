@@ -0,0 +1,206 @@
+/*
+ *
+ *      hrtimer.c
+ *      High-resolution timer
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "hrtimer.h"
+#include "acpi.h"
+#include "alloc.h"
+#include "common.h"
+#include "debug.h"
+#include "printk.h"
+#include "rbtree.h"
+#include "smp.h"
+#include "stddef.h"
+#include "stdint.h"
+#include "string.h"
+#include "tick.h"
+
+static hrtimer_base_t *hrtimer_bases;
+static uint32_t        hrtimer_base_count;
+
+static DEFINE_SPIN_LOCK_CLASS(hrtimer_base_lock_class, "hrtimer_base");
+
+/* Lock a timer tree with interrupts off, returns the previous RFLAGS */
+static inline uint64_t hrtimer_base_lock(hrtimer_base_t *base)
+{
+    return spin_lock_irqsave(&base->lock);
+}
+
+/* Unlock a timer tree and restore the interrupt flag */
+static inline void hrtimer_base_unlock(hrtimer_base_t *base, uint64_t flags)
+{
+    spin_unlock_irqrestore(&base->lock, flags);
+}
+
+/* Lock the tree a timer is queued on, returns 0 if it is not queued */
+static hrtimer_base_t *lock_hrtimer_base(hrtimer_t *timer, uint64_t *flags)
+{
+    while (1) {
+        hrtimer_base_t *base = __atomic_load_n(&timer->base, __ATOMIC_ACQUIRE);
+        if (!base) return 0;
+        *flags = hrtimer_base_lock(base);
+        if (timer->base == base) return base;
+        hrtimer_base_unlock(base, *flags);
+    }
+}
+
+/* Insert a timer by expiry, returns 1 if it became the first to expire */
+static int enqueue_hrtimer(hrtimer_base_t *base, hrtimer_t *timer)
+{
+    rb_node_t **link     = &base->root.node;
+    rb_node_t  *parent   = 0;
+    int         leftmost = 1;
+
+    while (*link) {
+        parent = *link;
+        if (timer->expires < rb_entry(parent, hrtimer_t, node)->expires) {
+            link = &parent->left;
+        } else {
+            link     = &parent->right; // Equal expiries keep their queueing order
+            leftmost = 0;
+        }
+    }
+    rb_link_node(&timer->node, parent, link);
+    rb_insert_color(&base->root, &timer->node, 0);
+
+    if (leftmost) base->first = timer;
+    __atomic_store_n(&timer->base, base, __ATOMIC_RELEASE);
+    base->count++;
+    return leftmost;
+}
+
+/* Take a timer out of its tree */
+static void dequeue_hrtimer(hrtimer_base_t *base, hrtimer_t *timer)
+{
+    if (base->first == timer) {
+        rb_node_t *next = rb_next(&timer->node);
+        base->first     = next ? rb_entry(next, hrtimer_t, node) : 0;
+    }
+    rb_erase(&base->root, &timer->node, 0);
+    __atomic_store_n(&timer->base, 0, __ATOMIC_RELEASE);
+    base->count--;
+}
+
+/* Initialize a high-resolution timer */
+void hrtimer_setup(hrtimer_t *timer, hrtimer_restart_t (*func)(hrtimer_t *timer))
+{
+    memset(timer, 0, sizeof(hrtimer_t));
+    timer->func = func;
+}
+
+/* Check whether a high-resolution timer is queued */
+int hrtimer_active(const hrtimer_t *timer)
+{
+    return __atomic_load_n(&timer->base, __ATOMIC_ACQUIRE) != 0;
+}
+
+/* Queue a timer on the current CPU for an absolute nano_time() expiry */
+void hrtimer_start(hrtimer_t *timer, uint64_t expires)
+{
+    if (!hrtimer_bases) panic("hrtimer: Timer armed before hrtimer_init().");
+    hrtimer_try_cancel(timer);
+
+    uint64_t        flags = get_rflags();
+    hrtimer_base_t *base;
+    disable_intr();
+    base = &hrtimer_bases[get_current_cpu_id()];
+    spin_lock(&base->lock);
+
+    timer->expires = expires;
+    if (enqueue_hrtimer(base, timer)) tick_arm(expires);
+    hrtimer_base_unlock(base, flags);
+}
+
+/* Push the expiry forward by whole intervals past now, returns the number of intervals */
+uint64_t hrtimer_forward(hrtimer_t *timer, uint64_t now, uint64_t interval)
+{
+    if (!interval || timer->expires > now) return 0;
+
+    uint64_t overruns = (now - timer->expires) / interval + 1;
+    timer->expires += overruns * interval;
+    return overruns;
+}
+
+/* Dequeue a timer without waiting, returns 1 if it was queued */
+int hrtimer_try_cancel(hrtimer_t *timer)
+{
+    uint64_t        flags;
+    hrtimer_base_t *base = lock_hrtimer_base(timer, &flags);
+    if (!base) return 0;
+    dequeue_hrtimer(base, timer);
+    hrtimer_base_unlock(base, flags);
+    return 1;
+}
+
+/* Dequeue a timer and wait for a running callback to finish, returns 1 if it was queued */
+int hrtimer_cancel(hrtimer_t *timer)
+{
+    int queued = hrtimer_try_cancel(timer);
+    for (uint32_t i = 0; i < hrtimer_base_count; i++) {
+        while (__atomic_load_n(&hrtimer_bases[i].running, __ATOMIC_ACQUIRE) == timer) __asm__ volatile("pause");
+        if (hrtimer_try_cancel(timer)) queued = 1; // The callback restarted it
+    }
+    return queued;
+}
+
+/* Returns the earliest expiry on the current CPU, 0 if none */
+uint64_t hrtimer_next_expiry(void)
+{
+    if (!hrtimer_bases) return 0;
+
+    hrtimer_base_t *base  = &hrtimer_bases[get_current_cpu_id()];
+    hrtimer_t      *first = __atomic_load_n(&base->first, __ATOMIC_ACQUIRE);
+    return first ? first->expires : 0;
+}
+
+/* Run expired high-resolution timers of the current CPU, called from the timer interrupt */
+void hrtimer_run_expired(void)
+{
+    if (!hrtimer_bases) return;
+
+    hrtimer_base_t *base = &hrtimer_bases[get_current_cpu_id()];
+    if (!base->first) return;
+
+    uint64_t now   = nano_time();
+    uint64_t flags = hrtimer_base_lock(base);
+    while (base->first && base->first->expires <= now + TICK_SLACK_NS) {
+        hrtimer_t *timer = base->first;
+        dequeue_hrtimer(base, timer);
+        base->running = timer;
+
+        spin_unlock(&base->lock);
+        hrtimer_restart_t restart = timer->func(timer);
+        spin_lock(&base->lock);
+
+        /* A restart from inside the callback has already requeued it */
+        if (restart == HRTIMER_RESTART && !timer->base) enqueue_hrtimer(base, timer);
+        base->running = 0;
+    }
+    hrtimer_base_unlock(base, flags);
+}
+
+/* Set up the per-CPU high-resolution timer trees */
+void hrtimer_init(void)
+{
+    hrtimer_base_count    = get_cpu_count() ? get_cpu_count() : 1;
+    hrtimer_base_t *bases = (hrtimer_base_t *)aligned_alloc(64, sizeof(hrtimer_base_t) * hrtimer_base_count);
+    if (!bases) panic("hrtimer: Cannot allocate the timer trees.");
+    memset(bases, 0, sizeof(hrtimer_base_t) * hrtimer_base_count);
+
+    for (uint32_t i = 0; i < hrtimer_base_count; i++) {
+        spin_lock_init(&bases[i].lock, &hrtimer_base_lock_class);
+        rb_root_init(&bases[i].root);
+        bases[i].cpu = i;
+    }
+
+    compiler_barrier();
+    hrtimer_bases = bases;
+    plogk("hrtimer: %u timer trees online.\n", hrtimer_base_count);
+}
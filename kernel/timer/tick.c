@@ -0,0 +1,180 @@
+/*
+ *
+ *      tick.c
+ *      Per-CPU timer tick
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "tick.h"
+#include "acpi.h"
+#include "apic.h"
+#include "common.h"
+#include "cpuid.h"
+#include "hrtimer.h"
+#include "idt.h"
+#include "percpu.h"
+#include "printk.h"
+#include "sched.h"
+#include "softirq.h"
+#include "stdint.h"
+#include "timer.h"
+
+static tick_mode_t tick_mode = TICK_MODE_PERIODIC;
+static uint64_t    tsc_per_ms;   // TSC increments per millisecond
+static uint64_t    lapic_per_ms; // LAPIC timer counts per millisecond at divide by 1
+
+/* Measure the TSC against the HPET */
+static uint64_t tsc_calibrate(void)
+{
+    uint64_t start     = nano_time();
+    uint64_t tsc_start = rdtsc();
+    while (nano_time() - start < 10000000) __asm__ volatile("pause");
+    return (rdtsc() - tsc_start) / 10;
+}
+
+/* Program the hardware for a nano_time() deadline, 0 stops the timer */
+static void tick_program(uint64_t deadline)
+{
+    this_cpu_write(tick_deadline, deadline);
+    if (!deadline) {
+        if (tick_mode == TICK_MODE_TSC_DEADLINE)
+            wrmsr(MSR_IA32_TSC_DEADLINE, 0);
+        else
+            lapic_write(LAPIC_REG_TIMER_INITCNT, 0);
+        return;
+    }
+
+    uint64_t now   = nano_time();
+    uint64_t delta = deadline > now + TICK_MIN_NS ? deadline - now : TICK_MIN_NS;
+    if (delta > TICK_MAX_NS) delta = TICK_MAX_NS;
+
+    if (tick_mode == TICK_MODE_TSC_DEADLINE) {
+        wrmsr(MSR_IA32_TSC_DEADLINE, rdtsc() + delta * tsc_per_ms / 1000000);
+    } else {
+        uint64_t count = delta * lapic_per_ms / 1000000;
+        if (count > 0xffffffff) count = 0xffffffff; // Fires early and is rearmed from the handler
+        lapic_write(LAPIC_REG_TIMER_INITCNT, count ? (uint32_t)count : 1);
+    }
+}
+
+/* Returns the earlier of two deadlines, 0 means none */
+static inline uint64_t tick_earliest(uint64_t a, uint64_t b)
+{
+    if (!a) return b;
+    if (!b) return a;
+    return a < b ? a : b;
+}
+
+/* Returns the earliest timer wheel or hrtimer expiry of the current CPU, 0 if none */
+static inline uint64_t tick_next_timer(void)
+{
+    return tick_earliest(timer_next_expiry(), hrtimer_next_expiry());
+}
+
+/* Returns the timer mode in use */
+tick_mode_t tick_get_mode(void)
+{
+    return tick_mode;
+}
+
+/* Returns the invariant TSC increments per millisecond, 0 if the TSC is not usable */
+uint64_t tick_tsc_per_ms(void)
+{
+    return tsc_per_ms;
+}
+
+/* Program the LAPIC timer of the current CPU, takes the LAPIC timer counts per millisecond */
+void tick_cpu_init(uint64_t lapic_counts)
+{
+    if (!lapic_per_ms) { // The boot CPU picks the mode for everyone
+        lapic_per_ms = lapic_counts;
+        if (cpu_support_invariant_tsc()) tsc_per_ms = tsc_calibrate(); // Also used for short delays
+        if (TICKLESS && cpu_support_tsc_deadline() && tsc_per_ms) {
+            tick_mode = TICK_MODE_TSC_DEADLINE;
+        } else if (TICKLESS) {
+            tick_mode = TICK_MODE_ONESHOT;
+        }
+        plogk("tick: %s mode, LAPIC %llu kHz, TSC %llu kHz.\n",
+              (const char *[]) {"periodic", "one-shot", "TSC-deadline"}[tick_mode], lapic_per_ms, tsc_per_ms);
+    }
+
+    switch (tick_mode) {
+        case TICK_MODE_PERIODIC :
+            lapic_write(LAPIC_REG_TIMER, IRQ_0 | LAPIC_TIMER_PERIODIC);
+            lapic_write(LAPIC_REG_TIMER_INITCNT, lapic_counts * TICK_PERIOD_NS / 1000000);
+            return;
+        case TICK_MODE_ONESHOT :
+            lapic_write(LAPIC_REG_TIMER, IRQ_0 | LAPIC_TIMER_ONESHOT);
+            break;
+        case TICK_MODE_TSC_DEADLINE :
+            lapic_write(LAPIC_REG_TIMER, IRQ_0 | LAPIC_TIMER_TSC_DEADLINE);
+            __asm__ volatile("mfence" ::: "memory"); // Order the LVT write before the first deadline write
+            break;
+    }
+
+    uint64_t next = nano_time() + TICK_PERIOD_NS;
+    this_cpu_write(tick_sched_next, next);
+    tick_program(next);
+}
+
+/* Timer interrupt body, runs expired events and programs the next one */
+void tick_handle(void)
+{
+    this_cpu_inc(timer_irqs);
+    raise_softirq_irqoff(SOFTIRQ_TIMER); // Wheel timers are coarse, their callbacks run with interrupts on
+    if (tick_mode == TICK_MODE_PERIODIC) {
+        hrtimer_run_expired();
+        irq_exit();
+        sched_tick();
+        return;
+    }
+
+    /* One-shot interrupts also arrive for timers, only some of them are scheduler ticks */
+    uint64_t now  = nano_time();
+    uint64_t next = this_cpu_read(tick_sched_next);
+    int      tick = next && now + TICK_SLACK_NS >= next;
+    if (tick) {
+        next = now + TICK_PERIOD_NS;
+        this_cpu_write(tick_sched_next, next);
+    }
+
+    /* Callbacks run after EOI and outside the timer locks, they may arm new timers */
+    hrtimer_run_expired();
+    irq_exit(); // Before programming, so the wheel no longer holds the timers that just expired
+    tick_program(tick_earliest(next, tick_next_timer()));
+    if (tick) sched_tick(); // May switch threads, so the timer is programmed first
+}
+
+/* Make sure the timer fires no later than a nano_time() deadline, interrupts must be off */
+void tick_arm(uint64_t deadline)
+{
+    if (tick_mode == TICK_MODE_PERIODIC) return;
+
+    uint64_t current = this_cpu_read(tick_deadline);
+    if (!current || deadline < current) tick_program(deadline);
+}
+
+/* Stop the scheduler tick before idling, returns 1 if it was stopped */
+int tick_sched_stop(void)
+{
+    if (tick_mode == TICK_MODE_PERIODIC) return 0;
+
+    /* Only a pending timer can wake the CPU from here, or an interrupt from outside */
+    this_cpu_write(tick_sched_next, 0);
+    tick_program(tick_next_timer());
+    return 1;
+}
+
+/* Restart the scheduler tick when a thread starts running, interrupts must be off */
+void tick_sched_resume(void)
+{
+    if (tick_mode == TICK_MODE_PERIODIC || this_cpu_read(tick_sched_next)) return;
+
+    uint64_t next = nano_time() + TICK_PERIOD_NS;
+    this_cpu_write(tick_sched_next, next);
+    tick_arm(next);
+}
@@ -14,7 +14,13 @@
 #include "common.h"
 #include "interrupt.h"
 #include "printk.h"
+#include "sched.h"
 #include "stdint.h"
+#include "tick.h"
+#include "timer.h"
+#include "wait.h"
+
+#define SLEEP_SPIN_NS 20000 // Shorter delays cost less spinning than a context switch
 
 /* Timer interrupt */
 INTERRUPT_BEGIN void timer_handle(interrupt_frame_t *frame)
@@ -22,16 +28,24 @@ INTERRUPT_BEGIN void timer_handle(interrupt_frame_t *frame)
     (void)frame;
     disable_intr();
     send_eoi();
+    tick_handle(); // May switch threads, this frame resumes when the thread runs again
     enable_intr();
 }
 INTERRUPT_END
 
-/* Millisecond-based delay functions */
-void msleep(uint64_t ms)
+/* Busy-wait for `ns` nanoseconds, on the TSC when it is calibrated */
+static void delay_spin(uint64_t ns)
 {
+    uint64_t tsc_per_ms = tick_tsc_per_ms();
+    if (tsc_per_ms) {
+        uint64_t start = rdtsc();
+        uint64_t ticks = ns * tsc_per_ms / 1000000;
+        while (rdtsc() - start < ticks) __asm__ volatile("pause");
+        return;
+    }
+
     uint64_t target_time = nano_time();
     uint64_t after       = 0;
-    uint64_t ns          = ms * 1000000;
 
     while (1) {
         uint64_t n = nano_time();
@@ -46,21 +60,24 @@ void msleep(uint64_t ms)
     }
 }
 
-/* Nanosecond-based delay function */
+/* Millisecond-based delay functions */
+void msleep(uint64_t ms)
+{
+    nsleep(ms * 1000000);
+}
+
+/* Nanosecond-based delay function, blocks the thread unless the delay is short */
 void nsleep(uint64_t ns)
 {
-    uint64_t target_time = nano_time();
-    uint64_t after       = 0;
+    if (ns < SLEEP_SPIN_NS || !thread_can_sleep()) {
+        delay_spin(ns);
+        return;
+    }
 
-    while (1) {
-        uint64_t n = nano_time();
-        if (n < target_time) {
-            after += 0xffffffff - target_time + n;
-            target_time = n;
-        } else {
-            after += n - target_time;
-            target_time = n;
-        }
-        if (after >= ns) return;
+    uint64_t left = ns;
+    while (left >= SLEEP_SPIN_NS) { // Loops if something else woke the thread early
+        get_current_thread()->state = THREAD_BLOCKED;
+        left = schedule_timeout(left);
     }
+    if (left) delay_spin(left);
 }
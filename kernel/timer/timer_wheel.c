@@ -0,0 +1,324 @@
+/*
+ *
+ *      timer_wheel.c
+ *      Per-CPU hierarchical timer wheel
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "acpi.h"
+#include "alloc.h"
+#include "apic.h"
+#include "common.h"
+#include "debug.h"
+#include "double_list.h"
+#include "isolation.h"
+#include "printk.h"
+#include "smp.h"
+#include "softirq.h"
+#include "stddef.h"
+#include "stdint.h"
+#include "string.h"
+#include "tick.h"
+#include "timer.h"
+
+#define LVL_SHIFT(n) ((n) * WHEEL_LVL_CLK_SHIFT)
+#define LVL_GRAN(n)  ((uint64_t)1 << LVL_SHIFT(n))
+#define LVL_START(n) (((uint64_t)WHEEL_LVL_SIZE - 1) << (((n) - 1) * WHEEL_LVL_CLK_SHIFT))
+#define LVL_CLK_MASK ((1 << WHEEL_LVL_CLK_SHIFT) - 1)
+
+static timer_base_t *timer_bases;
+static uint32_t      timer_base_count;
+
+static DEFINE_SPIN_LOCK_CLASS(timer_base_lock_class, "timer_base");
+
+/* Lock a timer base with interrupts off, returns the previous RFLAGS */
+static inline uint64_t timer_base_lock(timer_base_t *base)
+{
+    return spin_lock_irqsave(&base->lock);
+}
+
+/* Unlock a timer base and restore the interrupt flag */
+static inline void timer_base_unlock(timer_base_t *base, uint64_t flags)
+{
+    spin_unlock_irqrestore(&base->lock, flags);
+}
+
+/* Lock the base a timer is queued on, returns 0 if it is not queued */
+static timer_base_t *lock_timer_base(timer_list_t *timer, uint64_t *flags)
+{
+    while (1) {
+        timer_base_t *base = __atomic_load_n(&timer->base, __ATOMIC_ACQUIRE);
+        if (!base) return 0;
+        *flags = timer_base_lock(base);
+        if (timer->base == base) return base;
+        timer_base_unlock(base, *flags); // Migrated while we were waiting, try again
+    }
+}
+
+/* Bucket for an expiry on one level, rounded up so that a timer never fires early */
+static uint32_t calc_index(uint64_t expires, uint32_t lvl, uint64_t *bucket_expiry)
+{
+    expires        = (expires + LVL_GRAN(lvl)) >> LVL_SHIFT(lvl);
+    *bucket_expiry = expires << LVL_SHIFT(lvl);
+    return lvl * WHEEL_LVL_SIZE + (uint32_t)(expires & WHEEL_LVL_MASK);
+}
+
+/* Pick the finest level whose range covers the expiry */
+static uint32_t calc_wheel_index(uint64_t expires, uint64_t clk, uint64_t *bucket_expiry)
+{
+    if ((int64_t)(expires - clk) < 0) { // Already due, fire on the next jiffy processed
+        *bucket_expiry = clk;
+        return (uint32_t)(clk & WHEEL_LVL_MASK);
+    }
+
+    uint64_t delta = expires - clk;
+    for (uint32_t lvl = 0; lvl < WHEEL_LVL_DEPTH - 1; lvl++)
+        if (delta < LVL_START(lvl + 1)) return calc_index(expires, lvl, bucket_expiry);
+
+    if (delta > WHEEL_TIMEOUT_MAX) expires = clk + WHEEL_TIMEOUT_MAX;
+    return calc_index(expires, WHEEL_LVL_DEPTH - 1, bucket_expiry);
+}
+
+/* Put a timer into its bucket, returns the jiffy the bucket fires at */
+static uint64_t enqueue_timer(timer_base_t *base, timer_list_t *timer)
+{
+    uint64_t bucket_expiry;
+    uint32_t idx = calc_wheel_index(timer->expires, base->clk, &bucket_expiry);
+
+    ilist_insert_before(&base->buckets[idx], &timer->entry);
+    base->pending[idx / WHEEL_LVL_SIZE] |= (uint64_t)1 << (idx % WHEEL_LVL_SIZE);
+    timer->idx = idx;
+    __atomic_store_n(&timer->base, base, __ATOMIC_RELEASE);
+    base->count++;
+    return bucket_expiry;
+}
+
+/* Take a timer out of the wheel or the list being expired */
+static void detach_timer(timer_base_t *base, timer_list_t *timer)
+{
+    ilist_remove(&timer->entry);
+    if (ilist_is_empty(&base->buckets[timer->idx]))
+        base->pending[timer->idx / WHEEL_LVL_SIZE] &= ~((uint64_t)1 << (timer->idx % WHEEL_LVL_SIZE));
+    __atomic_store_n(&timer->base, 0, __ATOMIC_RELEASE);
+    base->count--;
+}
+
+/* Move every node of one list to the tail of another */
+static void bucket_splice(ilist_node_t *from, ilist_node_t *to)
+{
+    if (ilist_is_empty(from)) return;
+    ilist_node_t *first = from->next;
+    ilist_node_t *last  = from->prev;
+    first->prev         = to->prev;
+    to->prev->next      = first;
+    last->next          = to;
+    to->prev            = last;
+    ilist_init(from);
+}
+
+/* Move the buckets due at base->clk to `expired`, a level is only due when all finer ones wrap */
+static void collect_expired(timer_base_t *base, ilist_node_t *expired)
+{
+    uint64_t clk = base->clk;
+    for (uint32_t lvl = 0; lvl < WHEEL_LVL_DEPTH; lvl++) {
+        uint32_t idx = (uint32_t)(clk & WHEEL_LVL_MASK);
+        if (base->pending[lvl] & ((uint64_t)1 << idx)) {
+            base->pending[lvl] &= ~((uint64_t)1 << idx);
+            bucket_splice(&base->buckets[lvl * WHEEL_LVL_SIZE + idx], expired);
+        }
+        if (clk & LVL_CLK_MASK) break;
+        clk >>= WHEEL_LVL_CLK_SHIFT;
+    }
+}
+
+/* Returns the first jiffy at which a non-empty bucket is collected, UINT64_MAX if none */
+static uint64_t wheel_next_bucket(timer_base_t *base)
+{
+    uint64_t next = ~(uint64_t)0;
+    for (uint32_t lvl = 0; lvl < WHEEL_LVL_DEPTH; lvl++) {
+        uint64_t pending = base->pending[lvl];
+        if (!pending) continue;
+
+        /* Position of the next collection on this level, then the nearest set bit from there */
+        uint64_t pos     = (base->clk + LVL_GRAN(lvl) - 1) >> LVL_SHIFT(lvl);
+        uint32_t start   = (uint32_t)(pos & WHEEL_LVL_MASK);
+        uint64_t rotated = start ? (pending >> start) | (pending << (WHEEL_LVL_SIZE - start)) : pending;
+        uint64_t expiry  = (pos + (uint64_t)__builtin_ctzll(rotated)) << LVL_SHIFT(lvl);
+        if (expiry < next) next = expiry;
+    }
+    return next;
+}
+
+/* Bring a stale base->clk up to now before a timer is bucketed, never past a pending bucket so none is skipped */
+static void forward_timer_base(timer_base_t *base)
+{
+    uint64_t now = jiffies_now();
+    if (base->clk >= now) return;
+
+    /* An idle CPU with its tick stopped leaves clk behind, an empty wheel can jump straight to now */
+    uint64_t next = base->count ? wheel_next_bucket(base) : now;
+    if (next > base->clk) base->clk = next < now ? next : now;
+}
+
+/* Returns the current time in scheduler ticks */
+uint64_t jiffies_now(void)
+{
+    return nano_time() / TICK_PERIOD_NS;
+}
+
+/* Convert milliseconds to jiffies, rounding up */
+uint64_t msecs_to_jiffies(uint64_t ms)
+{
+    return (ms * 1000000 + TICK_PERIOD_NS - 1) / TICK_PERIOD_NS;
+}
+
+/* Initialize a timer */
+void timer_setup(timer_list_t *timer, void (*func)(timer_list_t *timer))
+{
+    memset(timer, 0, sizeof(timer_list_t));
+    timer->func = func;
+}
+
+/* Check whether a timer is queued */
+int timer_pending(const timer_list_t *timer)
+{
+    return __atomic_load_n(&timer->base, __ATOMIC_ACQUIRE) != 0;
+}
+
+/* Queue a timer on a CPU's wheel for an absolute expiry in jiffies */
+void add_timer_on(timer_list_t *timer, uint64_t expires, uint32_t cpu)
+{
+    if (!timer_bases) panic("timer: Timer armed before timer_init().");
+    del_timer(timer);
+
+    if (cpu >= timer_base_count) cpu = housekeeping_cpu();
+    timer_base_t *base  = &timer_bases[cpu];
+    uint64_t      flags = timer_base_lock(base);
+    forward_timer_base(base);
+    timer->expires  = expires;
+    uint64_t bucket = enqueue_timer(base, timer);
+    int      local  = cpu == get_current_cpu_id();
+    if (local) tick_arm(bucket * TICK_PERIOD_NS);
+    timer_base_unlock(base, flags);
+
+    /* A remote CPU may sleep with its tick stopped, let its idle loop reprogram the timer */
+    if (!local) smp_send_reschedule(cpu);
+}
+
+/* Queue a timer on the current CPU's wheel for an absolute expiry in jiffies, a housekeeping CPU's if this one is isolated */
+void add_timer(timer_list_t *timer, uint64_t expires)
+{
+    add_timer_on(timer, expires, housekeeping_cpu());
+}
+
+/* Move a timer to a new expiry, returns 1 if it was pending */
+int mod_timer(timer_list_t *timer, uint64_t expires)
+{
+    int pending = timer_pending(timer);
+    add_timer(timer, expires);
+    return pending;
+}
+
+/* Dequeue a timer, returns 1 if it was pending */
+int del_timer(timer_list_t *timer)
+{
+    uint64_t      flags;
+    timer_base_t *base = lock_timer_base(timer, &flags);
+    if (!base) return 0;
+    detach_timer(base, timer);
+    timer_base_unlock(base, flags);
+    return 1;
+}
+
+/* Dequeue a timer and wait for a running callback to finish */
+int del_timer_sync(timer_list_t *timer)
+{
+    int pending = del_timer(timer);
+    for (uint32_t i = 0; i < timer_base_count; i++)
+        while (__atomic_load_n(&timer_bases[i].running, __ATOMIC_ACQUIRE) == timer) __asm__ volatile("pause");
+    return pending;
+}
+
+/* Returns the earliest wheel expiry of the current CPU in nano_time(), 0 if none */
+uint64_t timer_next_expiry(void)
+{
+    if (!timer_bases) return 0;
+
+    timer_base_t *base   = &timer_bases[get_current_cpu_id()];
+    uint64_t      expiry = 0;
+    if (!base->count) return 0;
+
+    uint64_t flags = timer_base_lock(base);
+    if (base->count) expiry = wheel_next_bucket(base) * TICK_PERIOD_NS;
+    timer_base_unlock(base, flags);
+    return expiry;
+}
+
+/* Run expired wheel timers of the current CPU, called from the timer softirq */
+void timer_run_expired(void)
+{
+    if (!timer_bases) return;
+
+    timer_base_t *base = &timer_bases[get_current_cpu_id()];
+    uint64_t      now  = jiffies_now();
+    if (base->clk > now) return;
+
+    ilist_node_t expired;
+    ilist_init(&expired);
+
+    uint64_t flags = timer_base_lock(base);
+    while (base->clk <= now) {
+        if (!base->count) {
+            base->clk = now + 1;
+            break;
+        }
+
+        /* Skip the jiffies with nothing to collect, e.g. after a long tickless idle */
+        uint64_t next = wheel_next_bucket(base);
+        if (next > base->clk) {
+            base->clk = next < now + 1 ? next : now + 1;
+            continue;
+        }
+        collect_expired(base, &expired);
+        base->clk++;
+
+        /* Callbacks run unlocked, a concurrent del_timer() can still pull the rest of the list */
+        while (!ilist_is_empty(&expired)) {
+            timer_list_t *timer = ilist_entry(expired.next, timer_list_t, entry);
+            detach_timer(base, timer);
+            base->running = timer;
+            timer_base_unlock(base, flags); // Interrupts are back on for the callback
+            timer->func(timer);
+            flags         = timer_base_lock(base);
+            base->running = 0;
+        }
+    }
+    timer_base_unlock(base, flags);
+}
+
+/* Set up the per-CPU timer wheels */
+void timer_init(void)
+{
+    timer_base_count    = get_cpu_count() ? get_cpu_count() : 1;
+    timer_base_t *bases = (timer_base_t *)aligned_alloc(64, sizeof(timer_base_t) * timer_base_count);
+    if (!bases) panic("timer: Cannot allocate the timer wheels.");
+    memset(bases, 0, sizeof(timer_base_t) * timer_base_count);
+
+    uint64_t now = jiffies_now();
+    for (uint32_t i = 0; i < timer_base_count; i++) {
+        spin_lock_init(&bases[i].lock, &timer_base_lock_class);
+        for (uint32_t j = 0; j < WHEEL_SIZE; j++) ilist_init(&bases[i].buckets[j]);
+        bases[i].clk = now;
+        bases[i].cpu = i;
+    }
+
+    open_softirq(SOFTIRQ_TIMER, timer_run_expired);
+    compiler_barrier();
+    timer_bases = bases;
+    plogk("timer: %u timer wheels, %u levels of %u buckets, %llu ms resolution.\n", timer_base_count, WHEEL_LVL_DEPTH, WHEEL_LVL_SIZE,
+          (uint64_t)TICK_PERIOD_NS / 1000000);
+}
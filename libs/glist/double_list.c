@@ -55,3 +55,37 @@ int ilist_is_empty(const struct ilist_node *list)
     if (!list) return 1;
     return list->next == list;
 }
+
+/* Insert a new node after the specified node, publishing it to concurrent RCU readers */
+int ilist_insert_after_rcu(struct ilist_node *node, struct ilist_node *new_node)
+{
+    if (!node || !new_node) return 1;
+    new_node->next   = node->next;
+    new_node->prev   = node;
+    node->next->prev = new_node;
+    __atomic_store_n(&node->next, new_node, __ATOMIC_RELEASE); // Readers see the node only once it is linked
+    return 0;
+}
+
+/* Insert a new node before the specified node, publishing it to concurrent RCU readers */
+int ilist_insert_before_rcu(struct ilist_node *node, struct ilist_node *new_node)
+{
+    if (!node || !new_node) return 1;
+    return ilist_insert_after_rcu(node->prev, new_node);
+}
+
+/* Unlink a node but keep its next pointer for RCU readers still on it, free it after a grace period */
+int ilist_remove_rcu(struct ilist_node *node)
+{
+    if (!node || node->next == node || node->prev == node) return 1;
+    node->next->prev = node->prev;
+    __atomic_store_n(&node->prev->next, node->next, __ATOMIC_RELEASE);
+    node->prev = 0;
+    return 0;
+}
+
+/* Load the successor of a node inside an RCU read-side critical section */
+struct ilist_node *ilist_next_rcu(const struct ilist_node *node)
+{
+    return __atomic_load_n(&node->next, __ATOMIC_CONSUME);
+}
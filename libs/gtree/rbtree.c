@@ -0,0 +1,286 @@
+/*
+ *
+ *      rbtree.c
+ *      Augmented red-black tree
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "rbtree.h"
+
+/* Replace `old` with `new` in the parent (or root) link */
+static void rb_replace_child(rb_root_t *root, rb_node_t *parent, rb_node_t *old, rb_node_t *new)
+{
+    if (!parent)
+        root->node = new;
+    else if (parent->left == old)
+        parent->left = new;
+    else
+        parent->right = new;
+    if (new) new->parent = parent;
+}
+
+/* Rotate the subtree at `node` to the left */
+static void rb_rotate_left(rb_root_t *root, rb_node_t *node, rb_augment_t augment)
+{
+    rb_node_t *right = node->right;
+
+    node->right = right->left;
+    if (right->left) right->left->parent = node;
+    rb_replace_child(root, node->parent, node, right);
+    right->left  = node;
+    node->parent = right;
+
+    /* The rotated subtree covers the same keys, only these two caches move */
+    if (augment) {
+        augment(node);
+        augment(right);
+    }
+}
+
+/* Rotate the subtree at `node` to the right */
+static void rb_rotate_right(rb_root_t *root, rb_node_t *node, rb_augment_t augment)
+{
+    rb_node_t *left = node->left;
+
+    node->left = left->right;
+    if (left->right) left->right->parent = node;
+    rb_replace_child(root, node->parent, node, left);
+    left->right  = node;
+    node->parent = left;
+
+    if (augment) {
+        augment(node);
+        augment(left);
+    }
+}
+
+/* Returns 1 if the node is black (leaves are black) */
+static inline int rb_is_black(const rb_node_t *node)
+{
+    return !node || node->color == RB_BLACK;
+}
+
+/* Initialize a red-black tree root */
+void rb_root_init(rb_root_t *root)
+{
+    root->node = 0;
+}
+
+/* Check if a red-black tree is empty */
+int rb_empty(const rb_root_t *root)
+{
+    return root->node == 0;
+}
+
+/* Link a new node at the position found by a caller-side descent */
+void rb_link_node(rb_node_t *node, rb_node_t *parent, rb_node_t **link)
+{
+    node->parent = parent;
+    node->left   = 0;
+    node->right  = 0;
+    node->color  = RB_RED;
+    *link        = node;
+}
+
+/* Recompute augmented values from a node up to the root */
+void rb_propagate(rb_node_t *node, rb_augment_t augment)
+{
+    if (!augment) return;
+    for (; node; node = node->parent) augment(node);
+}
+
+/* Rebalance after rb_link_node(), keeping augmented values in sync */
+void rb_insert_color(rb_root_t *root, rb_node_t *node, rb_augment_t augment)
+{
+    rb_node_t *parent;
+
+    /* The new key changes every cache on its path, rotations below keep them local */
+    rb_propagate(node, augment);
+
+    while ((parent = node->parent) && parent->color == RB_RED) {
+        rb_node_t *gparent = parent->parent;
+
+        if (parent == gparent->left) {
+            rb_node_t *uncle = gparent->right;
+            if (!rb_is_black(uncle)) {
+                parent->color  = RB_BLACK;
+                uncle->color   = RB_BLACK;
+                gparent->color = RB_RED;
+                node           = gparent;
+                continue;
+            }
+            if (node == parent->right) {
+                rb_rotate_left(root, parent, augment);
+                node   = parent;
+                parent = node->parent;
+            }
+            parent->color  = RB_BLACK;
+            gparent->color = RB_RED;
+            rb_rotate_right(root, gparent, augment);
+        } else {
+            rb_node_t *uncle = gparent->left;
+            if (!rb_is_black(uncle)) {
+                parent->color  = RB_BLACK;
+                uncle->color   = RB_BLACK;
+                gparent->color = RB_RED;
+                node           = gparent;
+                continue;
+            }
+            if (node == parent->left) {
+                rb_rotate_right(root, parent, augment);
+                node   = parent;
+                parent = node->parent;
+            }
+            parent->color  = RB_BLACK;
+            gparent->color = RB_RED;
+            rb_rotate_left(root, gparent, augment);
+        }
+    }
+    root->node->color = RB_BLACK;
+}
+
+/* Restore the black height after removing a black node */
+static void rb_erase_color(rb_root_t *root, rb_node_t *node, rb_node_t *parent, rb_augment_t augment) // NOLINT
+{
+    while (node != root->node && rb_is_black(node)) {
+        if (node == parent->left) {
+            rb_node_t *sibling = parent->right;
+            if (!rb_is_black(sibling)) {
+                sibling->color = RB_BLACK;
+                parent->color  = RB_RED;
+                rb_rotate_left(root, parent, augment);
+                sibling = parent->right;
+            }
+            if (rb_is_black(sibling->left) && rb_is_black(sibling->right)) {
+                sibling->color = RB_RED;
+                node           = parent;
+                parent         = node->parent;
+                continue;
+            }
+            if (rb_is_black(sibling->right)) {
+                sibling->left->color = RB_BLACK;
+                sibling->color       = RB_RED;
+                rb_rotate_right(root, sibling, augment);
+                sibling = parent->right;
+            }
+            sibling->color        = parent->color;
+            parent->color         = RB_BLACK;
+            sibling->right->color = RB_BLACK;
+            rb_rotate_left(root, parent, augment);
+            node = root->node;
+            break;
+        } else {
+            rb_node_t *sibling = parent->left;
+            if (!rb_is_black(sibling)) {
+                sibling->color = RB_BLACK;
+                parent->color  = RB_RED;
+                rb_rotate_right(root, parent, augment);
+                sibling = parent->left;
+            }
+            if (rb_is_black(sibling->left) && rb_is_black(sibling->right)) {
+                sibling->color = RB_RED;
+                node           = parent;
+                parent         = node->parent;
+                continue;
+            }
+            if (rb_is_black(sibling->left)) {
+                sibling->right->color = RB_BLACK;
+                sibling->color        = RB_RED;
+                rb_rotate_left(root, sibling, augment);
+                sibling = parent->left;
+            }
+            sibling->color       = parent->color;
+            parent->color        = RB_BLACK;
+            sibling->left->color = RB_BLACK;
+            rb_rotate_right(root, parent, augment);
+            node = root->node;
+            break;
+        }
+    }
+    if (node) node->color = RB_BLACK;
+}
+
+/* Remove a node from the tree, keeping augmented values in sync */
+void rb_erase(rb_root_t *root, rb_node_t *node, rb_augment_t augment)
+{
+    rb_node_t *child, *parent;
+    int        color;
+
+    if (!node->left || !node->right) {
+        child  = node->left ? node->left : node->right;
+        parent = node->parent;
+        color  = node->color;
+        rb_replace_child(root, parent, node, child);
+    } else {
+        /* Splice the successor into the removed node's place */
+        rb_node_t *successor = node->right;
+        while (successor->left) successor = successor->left;
+
+        child = successor->right;
+        color = successor->color;
+
+        if (successor->parent == node) {
+            parent = successor;
+        } else {
+            parent       = successor->parent;
+            parent->left = child;
+            if (child) child->parent = parent;
+            successor->right    = node->right;
+            node->right->parent = successor;
+        }
+        rb_replace_child(root, node->parent, node, successor);
+        successor->left    = node->left;
+        node->left->parent = successor;
+        successor->color   = node->color;
+    }
+
+    /* Every cache from the deepest changed node to the root may have moved */
+    rb_propagate(parent, augment);
+    if (color == RB_BLACK) rb_erase_color(root, child, parent, augment);
+}
+
+/* Returns the leftmost node of the tree */
+rb_node_t *rb_first(const rb_root_t *root)
+{
+    rb_node_t *node = root->node;
+    if (!node) return 0;
+    while (node->left) node = node->left;
+    return node;
+}
+
+/* Returns the rightmost node of the tree */
+rb_node_t *rb_last(const rb_root_t *root)
+{
+    rb_node_t *node = root->node;
+    if (!node) return 0;
+    while (node->right) node = node->right;
+    return node;
+}
+
+/* Returns the in-order successor */
+rb_node_t *rb_next(const rb_node_t *node)
+{
+    if (node->right) {
+        node = node->right;
+        while (node->left) node = node->left;
+        return (rb_node_t *)node;
+    }
+    while (node->parent && node == node->parent->right) node = node->parent;
+    return node->parent;
+}
+
+/* Returns the in-order predecessor */
+rb_node_t *rb_prev(const rb_node_t *node)
+{
+    if (node->left) {
+        node = node->left;
+        while (node->right) node = node->right;
+        return (rb_node_t *)node;
+    }
+    while (node->parent && node == node->parent->left) node = node->parent;
+    return node->parent;
+}
@@ -171,7 +171,7 @@ int itoa(int value, char *str, int base)
     return length;
 }
 
-int ftoa(double value, char *str, int precision)
+__attribute__((target("sse2"))) int ftoa(double value, char *str, int precision)
 {
     int    int_part  = (int)value;
     double frac_part = value - int_part;
@@ -0,0 +1,99 @@
+/*
+ *
+ *      rwlock.c
+ *      Reader-writer lock
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "rwlock.h"
+#include "percpu.h"
+#include "sched.h"
+#include "smp.h"
+#include "spin_lock.h"
+#include "stdint.h"
+
+static volatile uint32_t rwlock_next_slot; // Per-CPU reader count slots handed out
+
+/* Returns the reader count slot of a lock, assigning one on first use */
+static uint32_t rwlock_slot(rwlock_t *lock)
+{
+    uint32_t slot = __atomic_load_n(&lock->slot, __ATOMIC_SEQ_CST);
+    if (slot) return slot;
+
+    uint32_t want = __atomic_add_fetch(&rwlock_next_slot, 1, __ATOMIC_RELAXED);
+    if (want > RWLOCK_PERCPU_SLOTS) want = RWLOCK_SLOT_SHARED;
+    if (!__atomic_compare_exchange_n(&lock->slot, &slot, want, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) return slot; // Lost the race
+    return want;
+}
+
+/* Returns the counter a reader on this CPU updates */
+static volatile int32_t *rwlock_counter(rwlock_t *lock)
+{
+    uint32_t slot = rwlock_slot(lock);
+    if (slot == RWLOCK_SLOT_SHARED) return &lock->readers;
+    return &this_cpu()->rwlock_readers[slot - 1];
+}
+
+/* Sum the readers of a lock over every CPU */
+static int64_t rwlock_readers(rwlock_t *lock)
+{
+    uint32_t slot  = __atomic_load_n(&lock->slot, __ATOMIC_SEQ_CST);
+    int64_t  count = __atomic_load_n(&lock->readers, __ATOMIC_SEQ_CST);
+    if (!slot || slot == RWLOCK_SLOT_SHARED) return count;
+
+    uint32_t cpus = get_cpu_count() ? get_cpu_count() : 1;
+    for (uint32_t i = 0; i < cpus; i++) count += __atomic_load_n(&get_cpu_percpu(i)->rwlock_readers[slot - 1], __ATOMIC_SEQ_CST);
+    return count;
+}
+
+/* Initialize a reader-writer lock at runtime, `class` may be 0 */
+void rwlock_init(rwlock_t *lock, spin_lock_class_t *class)
+{
+    lock->writer  = 0;
+    lock->slot    = 0;
+    lock->readers = 0;
+    spin_lock_init(&lock->wlock, class);
+}
+
+/* Lock for reading with preemption disabled, waits while a writer holds or wants the lock */
+void read_lock(rwlock_t *lock)
+{
+    while (1) {
+        /* A preempted reader could sit behind a writer spinning on its CPU, so readers stay put until read_unlock() */
+        preempt_disable();
+        volatile int32_t *counter = rwlock_counter(lock);
+        __atomic_add_fetch(counter, 1, __ATOMIC_SEQ_CST);
+        if (!__atomic_load_n(&lock->writer, __ATOMIC_SEQ_CST)) return;
+
+        /* Back off on the same counter, the writer may already have summed the others */
+        __atomic_sub_fetch(counter, 1, __ATOMIC_SEQ_CST);
+        preempt_enable();
+        while (__atomic_load_n(&lock->writer, __ATOMIC_RELAXED)) __asm__ volatile("pause");
+    }
+}
+
+/* Unlock after reading and enable preemption again */
+void read_unlock(rwlock_t *lock)
+{
+    __atomic_sub_fetch(rwlock_counter(lock), 1, __ATOMIC_RELEASE);
+    preempt_enable();
+}
+
+/* Lock for writing, new readers back off and current ones drain */
+void write_lock(rwlock_t *lock)
+{
+    spin_lock(&lock->wlock);
+    __atomic_store_n(&lock->writer, 1, __ATOMIC_SEQ_CST);
+    while (rwlock_readers(lock)) __asm__ volatile("pause");
+}
+
+/* Unlock after writing */
+void write_unlock(rwlock_t *lock)
+{
+    __atomic_store_n(&lock->writer, 0, __ATOMIC_RELEASE);
+    spin_unlock(&lock->wlock);
+}
@@ -0,0 +1,76 @@
+/*
+ *
+ *      seqlock.c
+ *      Sequence counter and sequence lock
+ *
+ *      2026/10/18 By Rainy101112
+ *      Based on GPL-3.0 open source agreement
+ *      Rinx Kernel project.
+ *
+ */
+
+#include "seqlock.h"
+#include "spin_lock.h"
+#include "stdint.h"
+
+/* Start a read section, waits out a write in progress, returns the sequence to check */
+uint32_t read_seqcount_begin(const seqcount_t *seqcount)
+{
+    uint32_t start;
+    while ((start = __atomic_load_n(&seqcount->sequence, __ATOMIC_ACQUIRE)) & 1) __asm__ volatile("pause");
+    return start;
+}
+
+/* Returns 1 if a write happened since read_seqcount_begin() and the read must be repeated */
+int read_seqcount_retry(const seqcount_t *seqcount, uint32_t start)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE); // Order the protected loads before the recheck
+    return __atomic_load_n(&seqcount->sequence, __ATOMIC_RELAXED) != start;
+}
+
+/* Start a write, the caller excludes other writers and readers on this CPU */
+void write_seqcount_begin(seqcount_t *seqcount)
+{
+    __atomic_store_n(&seqcount->sequence, seqcount->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE); // Order the odd sequence before the protected stores
+}
+
+/* Finish a write */
+void write_seqcount_end(seqcount_t *seqcount)
+{
+    __atomic_store_n(&seqcount->sequence, seqcount->sequence + 1, __ATOMIC_RELEASE);
+}
+
+/* Initialize a sequence lock at runtime, `class` may be 0 */
+void seqlock_init(seqlock_t *seqlock, spin_lock_class_t *class)
+{
+    seqlock->seqcount.sequence = 0;
+    spin_lock_init(&seqlock->lock, class);
+}
+
+/* Start a read section of a sequence lock */
+uint32_t read_seqbegin(const seqlock_t *seqlock)
+{
+    return read_seqcount_begin(&seqlock->seqcount);
+}
+
+/* Returns 1 if the read section of a sequence lock must be repeated */
+int read_seqretry(const seqlock_t *seqlock, uint32_t start)
+{
+    return read_seqcount_retry(&seqlock->seqcount, start);
+}
+
+/* Lock for writing with interrupts off, returns the previous RFLAGS */
+uint64_t write_seqlock_irqsave(seqlock_t *seqlock)
+{
+    uint64_t flags = spin_lock_irqsave(&seqlock->lock);
+    write_seqcount_begin(&seqlock->seqcount);
+    return flags;
+}
+
+/* Unlock after writing and restore the interrupt flag */
+void write_sequnlock_irqrestore(seqlock_t *seqlock, uint64_t flags)
+{
+    write_seqcount_end(&seqlock->seqcount);
+    spin_unlock_irqrestore(&seqlock->lock, flags);
+}
@@ -10,22 +10,208 @@
  */
 
 #include "spin_lock.h"
+#include "common.h"
+#include "percpu.h"
+#include "printk.h"
+#include "sched.h"
 
-/* Lock a spinlock */
+#define RFLAGS_IF (1 << 9)
+
+static spin_lock_class_t *lockstat_classes; // Every class acquired at least once
+
+/* Take the lock word if it is free */
+static inline int spin_try_acquire(spinlock_t *lock)
+{
+    uint32_t expected = 0;
+    return __atomic_compare_exchange_n(&lock->locked, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+/* Spin on the lock word until it can be taken */
+static inline void spin_acquire_word(spinlock_t *lock)
+{
+    while (!spin_try_acquire(lock))
+        while (__atomic_load_n(&lock->locked, __ATOMIC_RELAXED)) __asm__ volatile("pause");
+}
+
+#if LOCKSTAT
+/* Raise a maximum without losing a concurrent update */
+static inline void lockstat_max(uint64_t *max, uint64_t value)
+{
+    uint64_t old = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (value > old && !__atomic_compare_exchange_n(max, &old, value, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+/* Account an acquisition that started at TSC `start` */
+static void lockstat_acquired(spinlock_t *lock, uint64_t start, int contended)
+{
+    spin_lock_class_t *class = lock->class;
+    uint64_t           now   = rdtsc();
+
+    lock->acquired_at = now;
+    if (!class) return;
+
+    if (!__atomic_exchange_n(&class->registered, 1, __ATOMIC_ACQ_REL)) {
+        class->next = __atomic_load_n(&lockstat_classes, __ATOMIC_ACQUIRE);
+        while (!__atomic_compare_exchange_n(&lockstat_classes, &class->next, class, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+    }
+    __atomic_add_fetch(&class->acquisitions, 1, __ATOMIC_RELAXED);
+    if (!contended) return;
+    __atomic_add_fetch(&class->contentions, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&class->wait_total, now - start, __ATOMIC_RELAXED);
+    lockstat_max(&class->wait_max, now - start);
+}
+
+/* Account the hold time before the lock is released */
+static void lockstat_released(spinlock_t *lock)
+{
+    spin_lock_class_t *class = lock->class;
+    if (!class) return;
+
+    uint64_t hold = rdtsc() - lock->acquired_at;
+    __atomic_add_fetch(&class->hold_total, hold, __ATOMIC_RELAXED);
+    lockstat_max(&class->hold_max, hold);
+}
+#endif
+
+/* Queue behind other waiters on per-CPU nodes, each spinning on its own node */
+static void spin_lock_slowpath(spinlock_t *lock)
+{
+    /* The node belongs to this CPU, interrupts off keep a nested lock on this CPU from queueing on it */
+    uint64_t rflags = get_rflags();
+    disable_intr();
+
+    uint64_t depth = this_cpu_read(spin_qnode_depth);
+    if (depth >= SPIN_QNODE_NEST) {
+        spin_acquire_word(lock);
+        if (rflags & RFLAGS_IF) enable_intr();
+        return;
+    }
+    this_cpu_write(spin_qnode_depth, depth + 1);
+
+    spin_qnode_t *node = &this_cpu()->spin_qnodes[depth];
+    node->next         = 0;
+    node->wait         = 1;
+
+    spin_qnode_t *prev = __atomic_exchange_n(&lock->tail, node, __ATOMIC_ACQ_REL);
+    if (prev) {
+        __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&node->wait, __ATOMIC_ACQUIRE)) __asm__ volatile("pause");
+    }
+
+    /* Queue head, only the holder and fast-path callers touch the lock word now */
+    spin_acquire_word(lock);
+
+    /* Leave the queue, handing the head position to the next waiter */
+    spin_qnode_t *expected = node;
+    if (!__atomic_compare_exchange_n(&lock->tail, &expected, 0, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+        spin_qnode_t *next;
+        while (!(next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE))) __asm__ volatile("pause");
+        __atomic_store_n(&next->wait, 0, __ATOMIC_RELEASE);
+    }
+
+    this_cpu_write(spin_qnode_depth, depth);
+    if (rflags & RFLAGS_IF) enable_intr();
+}
+
+/* Initialize a lock at runtime, `class` may be 0 */
+void spin_lock_init(spinlock_t *lock, spin_lock_class_t *class)
+{
+    lock->locked = 0;
+    lock->tail   = 0;
+#if LOCKSTAT
+    lock->class       = class;
+    lock->acquired_at = 0;
+#else
+    (void)class;
+#endif
+}
+
+/* Lock a spinlock and disable preemption, a lock interrupt handlers or softirqs also take needs spin_lock_irqsave() everywhere */
 void spin_lock(spinlock_t *lock)
 {
-    __asm__ volatile("pushfq; pop %0; cli" : "=r"(lock->rflags));
-    while (1) {
-        uint64_t desired = 1;
-        __asm__ volatile("lock xchg %[desired], %[lock];" : [lock] "+m"(lock->lock), [desired] "+r"(desired)::"memory");
-        if (!desired) break;
-        __asm__ volatile("pause");
+    preempt_disable(); // A holder switched out would leave waiters on its CPU spinning with nobody to release it
+#if LOCKSTAT
+    uint64_t start     = rdtsc();
+    int      contended = 0;
+#endif
+    /* Waiters already queued go first */
+    if (__atomic_load_n(&lock->tail, __ATOMIC_RELAXED) || !spin_try_acquire(lock)) {
+        spin_lock_slowpath(lock);
+#if LOCKSTAT
+        contended = 1;
+#endif
     }
+#if LOCKSTAT
+    lockstat_acquired(lock, start, contended);
+#endif
 }
 
-/* Unlock a spinlock */
+/* Try to lock a spinlock without waiting, returns 1 on success */
+int spin_trylock(spinlock_t *lock)
+{
+    preempt_disable();
+    if (__atomic_load_n(&lock->tail, __ATOMIC_RELAXED) || !spin_try_acquire(lock)) {
+        preempt_enable();
+        return 0;
+    }
+#if LOCKSTAT
+    lockstat_acquired(lock, 0, 0);
+#endif
+    return 1;
+}
+
+/* Unlock a spinlock and enable preemption again */
 void spin_unlock(spinlock_t *lock)
 {
-    lock->lock = 0;
-    __asm__ volatile("push %0; popfq" ::"r"(lock->rflags));
+#if LOCKSTAT
+    lockstat_released(lock);
+#endif
+    __atomic_store_n(&lock->locked, 0, __ATOMIC_RELEASE);
+    preempt_enable();
+}
+
+/* Disable interrupts and lock a spinlock, returns the previous RFLAGS */
+uint64_t spin_lock_irqsave(spinlock_t *lock)
+{
+    uint64_t flags = get_rflags();
+    disable_intr();
+    spin_lock(lock);
+    return flags;
+}
+
+/* Unlock a spinlock and restore the interrupt flag from spin_lock_irqsave() */
+void spin_unlock_irqrestore(spinlock_t *lock, uint64_t flags)
+{
+    spin_unlock(lock);
+    if (flags & RFLAGS_IF) enable_intr();
+}
+
+/* Print the statistics of every lock class used so far */
+void lockstat_print(void)
+{
+    spin_lock_class_t *class = __atomic_load_n(&lockstat_classes, __ATOMIC_ACQUIRE);
+    if (!LOCKSTAT) {
+        plogk("lockstat: Not enabled in this build.\n");
+        return;
+    }
+    for (; class; class = class->next) {
+        uint64_t acquisitions = class->acquisitions ? class->acquisitions : 1;
+        uint64_t contentions  = class->contentions ? class->contentions : 1;
+        plogk("lockstat: %-16s acq=%10llu cont=%8llu wait avg=%8llu max=%10llu hold avg=%8llu max=%10llu cycles\n",
+              class->name, class->acquisitions, class->contentions, class->wait_total / contentions, class->wait_max,
+              class->hold_total / acquisitions, class->hold_max);
+    }
+}
+
+/* Clear the statistics of every lock class */
+void lockstat_reset(void)
+{
+    for (spin_lock_class_t *class = __atomic_load_n(&lockstat_classes, __ATOMIC_ACQUIRE); class; class = class->next) {
+        class->acquisitions = 0;
+        class->contentions  = 0;
+        class->wait_total   = 0;
+        class->wait_max     = 0;
+        class->hold_total   = 0;
+        class->hold_max     = 0;
+    }
 }